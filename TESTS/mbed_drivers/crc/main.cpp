@@ -125,11 +125,95 @@ void test_any_polynomial()
     }
 }
 
+void test_sliced_crc()
+{
+    uint8_t test[67];
+    uint32_t crc;
+    uint32_t expected;
+
+    for (uint32_t i = 0; i < sizeof(test); i++) {
+        test[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    MbedCRC<POLY_32BIT_ANSI, 32> ct;
+    TEST_ASSERT_EQUAL(0, ct.compute((void *)test, sizeof(test), &expected));
+
+    // Every split must give the same result, regardless of alignment
+    for (uint32_t split = 0; split <= sizeof(test); split++) {
+        TEST_ASSERT_EQUAL(0, ct.compute_partial_start(&crc));
+        TEST_ASSERT_EQUAL(0, ct.compute_partial((void *)test, split, &crc));
+        TEST_ASSERT_EQUAL(0, ct.compute_partial((void *)&test[split], sizeof(test) - split, &crc));
+        TEST_ASSERT_EQUAL(0, ct.compute_partial_stop(&crc));
+        TEST_ASSERT_EQUAL(expected, crc);
+    }
+
+    // CRC32/JAMCRC, as used by NVStore records
+    char check[] = "123456789";
+    MbedCRC<POLY_32BIT_ANSI, 32> jam(0xFFFFFFFF, 0, true, true);
+    TEST_ASSERT_EQUAL(0, jam.compute((void *)check, strlen((const char*)check), &crc));
+    TEST_ASSERT_EQUAL(0x340BC6D9, crc);
+}
+
+template <uint32_t polynomial, uint8_t width, bool reflected, uint32_t size>
+uint32_t benchmark_crc_engine(const uint8_t *data, uint32_t len, uint32_t rounds)
+{
+    Timer timer;
+    uint32_t crc = 0;
+
+    timer.start();
+    for (uint32_t i = 0; i < rounds; i++) {
+        crc = mbed::internal::crc_engine<polynomial, width, reflected, size>::compute(crc, data, data + len);
+    }
+    timer.stop();
+
+    int us = timer.read_us();
+    utest_printf("poly 0x%lx%s, table size %3lu: %d us, %lu KB/s\r\n",
+                 (unsigned long)polynomial, reflected ? " reflected" : "", (unsigned long)size,
+                 us, us ? (unsigned long)((uint64_t)len * rounds * 1000000 / 1024 / us) : 0UL);
+    return crc;
+}
+
+void test_generated_tables()
+{
+    static uint8_t test[1024];
+    const uint32_t rounds = 16;
+    uint32_t crc;
+
+    for (uint32_t i = 0; i < sizeof(test); i++) {
+        test[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    // Polynomials without ROM tables, check values from the CRC catalogue
+    {
+        char check[] = "123456789";
+        MbedCRC<0x1EDC6F41, 32> ct(0xFFFFFFFF, 0xFFFFFFFF, true, true);
+        TEST_ASSERT_EQUAL(0, ct.compute((void *)check, strlen((const char*)check), &crc));
+        TEST_ASSERT_EQUAL(0xE3069283, crc);
+    }
+    {
+        char check[] = "123456789";
+        MbedCRC<0x3D65, 16> ct(0, 0xFFFF, false, false);
+        TEST_ASSERT_EQUAL(0, ct.compute((void *)check, strlen((const char*)check), &crc));
+        TEST_ASSERT_EQUAL(0xC2B7, crc);
+    }
+
+    // Bitwise, nibble and byte tables must agree
+    uint32_t bitwise = benchmark_crc_engine<0x1EDC6F41, 32, true, 0>(test, sizeof(test), rounds);
+    TEST_ASSERT_EQUAL(bitwise, (benchmark_crc_engine<0x1EDC6F41, 32, true, 16>(test, sizeof(test), rounds)));
+    TEST_ASSERT_EQUAL(bitwise, (benchmark_crc_engine<0x1EDC6F41, 32, true, 256>(test, sizeof(test), rounds)));
+
+    bitwise = benchmark_crc_engine<0x3D65, 16, false, 0>(test, sizeof(test), rounds);
+    TEST_ASSERT_EQUAL(bitwise, (benchmark_crc_engine<0x3D65, 16, false, 16>(test, sizeof(test), rounds)));
+    TEST_ASSERT_EQUAL(bitwise, (benchmark_crc_engine<0x3D65, 16, false, 256>(test, sizeof(test), rounds)));
+}
+
 Case cases[] = {
     Case("Test supported polynomials", test_supported_polynomials),
     Case("Test partial CRC", test_partial_crc),
     Case("Test SD CRC polynomials", test_sd_crc),
-    Case("Test not supported polynomials", test_any_polynomial)
+    Case("Test not supported polynomials", test_any_polynomial),
+    Case("Test sliced CRC32", test_sliced_crc),
+    Case("Test generated CRC tables", test_generated_tables)
 };
 
 utest::v1::status_t greentea_test_setup(const size_t number_of_cases) {
@@ -457,6 +457,79 @@ void test_fseek_ftell()
     std::fclose(file);
 }
 
+/** Test writev and readv
+ *
+ *  Given already opened file
+ *
+ *  When write list of buffers to file
+ *  Then underneath retargeting layer write function is called
+ *       writev return number of bytes written from all buffers
+ *       when file gets full writev stops at the partially written buffer
+ *
+ *  When read previously written data into list of buffers
+ *  Then underneath retargeting layer read function is called
+ *       readv return number of bytes read into all buffers
+ *       read data match previously written
+ *
+ */
+void test_writev_readv()
+{
+    const uint32_t FS = 5;
+    TestFile<FS> fh;
+    char str1[] = "abc";
+    char str2[] = "def";
+    char read_buf1[3];
+    char read_buf2[3];
+    ssize_t ret;
+
+    int fd = mbed::bind_to_fd(&fh);
+    TEST_ASSERT_TRUE(fd >= 0);
+
+    struct iovec wiov[] = {
+        { str1, 3 },
+        { str2, 3 },
+    };
+
+    // write 3+3; expected written 5
+    TestFile<FS>::resetFunctionCallHistory();
+    ret = writev(fd, wiov, 2);
+    TEST_ASSERT_TRUE(TestFile<FS>::functionCalled(TestFile<FS>::fnWrite));
+    TEST_ASSERT_EQUAL_INT(5, ret);
+
+    // write 3+3; expected error
+    errno = 0;
+    ret = writev(fd, wiov, 2);
+    TEST_ASSERT_EQUAL_INT(-1, ret);
+    TEST_ASSERT_EQUAL_INT(ENOSPC, errno);
+
+    // invalid number of buffers
+    errno = 0;
+    ret = writev(fd, wiov, -1);
+    TEST_ASSERT_EQUAL_INT(-1, ret);
+    TEST_ASSERT_EQUAL_INT(EINVAL, errno);
+
+    TEST_ASSERT_EQUAL_INT(0, lseek(fd, 0, SEEK_SET));
+
+    struct iovec riov[] = {
+        { read_buf1, 3 },
+        { read_buf2, 3 },
+    };
+
+    // read 3+3; expected read 5
+    TestFile<FS>::resetFunctionCallHistory();
+    ret = readv(fd, riov, 2);
+    TEST_ASSERT_TRUE(TestFile<FS>::functionCalled(TestFile<FS>::fnRead));
+    TEST_ASSERT_EQUAL_INT(5, ret);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(str1, read_buf1, 3));
+    TEST_ASSERT_EQUAL_INT(0, strncmp(str2, read_buf2, 2));
+
+    // read 3+3; expected read 0
+    ret = readv(fd, riov, 2);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+
+    TEST_ASSERT_EQUAL_INT(0, close(fd));
+}
+
 utest::v1::status_t test_setup(const size_t number_of_cases)
 {
     GREENTEA_SETUP(10, "default_auto");
@@ -469,7 +542,8 @@ Case cases[] = {
     Case("Test fputc/fgetc", test_fputc_fgetc),
     Case("Test fputs/fgets", test_fputs_fgets),
     Case("Test fprintf/fscanf", test_fprintf_fscanf),
-    Case("Test fseek/ftell", test_fseek_ftell)
+    Case("Test fseek/ftell", test_fseek_ftell),
+    Case("Test writev/readv", test_writev_readv)
 };
 
 utest::v1::Specification specification(test_setup, cases);
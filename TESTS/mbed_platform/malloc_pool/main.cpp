@@ -0,0 +1,170 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "mbed_stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if !MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
+  #error [NOT_SUPPORTED] test not supported
+#endif
+
+using utest::v1::Case;
+
+#define MAX_CLASSES     8
+#define MAX_BLOCKS      256
+
+static mbed_stats_heap_pool_t stats_start[MAX_CLASSES];
+static mbed_stats_heap_pool_t stats_current[MAX_CLASSES];
+static void *blocks[MAX_BLOCKS];
+
+/* Test the size classes are reported.
+ *
+ * Given is the configured pool.
+ * When the stats are read.
+ * Then each class has blocks and the classes grow in size.
+ */
+void test_classes()
+{
+    size_t count = mbed_stats_heap_pool_get(stats_start, MAX_CLASSES);
+    TEST_ASSERT(count > 0);
+
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT(stats_start[i].block_cnt > 0);
+        TEST_ASSERT_EQUAL(0, stats_start[i].block_size % 8);
+        if (i > 0) {
+            TEST_ASSERT(stats_start[i - 1].block_size < stats_start[i].block_size);
+        }
+    }
+}
+
+/* Test small allocations are served by the pools.
+ *
+ * Given is the smallest size class.
+ * When one block is allocated and freed.
+ * Then it is counted in a class and the data survives.
+ */
+void test_alloc_free()
+{
+    mbed_stats_heap_pool_get(stats_start, MAX_CLASSES);
+
+    uint8_t *data = (uint8_t *)malloc(4);
+    TEST_ASSERT_NOT_NULL(data);
+    memset(data, 0xA5, 4);
+
+    size_t count = mbed_stats_heap_pool_get(stats_current, MAX_CLASSES);
+    uint32_t allocated = 0;
+    for (size_t i = 0; i < count; i++) {
+        allocated += stats_current[i].total_cnt - stats_start[i].total_cnt;
+    }
+    TEST_ASSERT_EQUAL(1, allocated);
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(0xA5, data[i]);
+    }
+    free(data);
+
+    mbed_stats_heap_pool_get(stats_current, MAX_CLASSES);
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL(stats_start[i].current_cnt, stats_current[i].current_cnt);
+    }
+}
+
+/* Test exhausted classes fall back to the heap.
+ *
+ * Given is the largest size class.
+ * When more blocks than it holds are allocated.
+ * Then the extra allocations still succeed and are counted as overflow.
+ */
+void test_overflow()
+{
+    size_t count = mbed_stats_heap_pool_get(stats_start, MAX_CLASSES);
+    mbed_stats_heap_pool_t *largest = &stats_start[count - 1];
+    uint32_t allocs = largest->block_cnt - largest->current_cnt + 1;
+    TEST_ASSERT(allocs <= MAX_BLOCKS);
+
+    // Just over the next smaller class only fits the largest class
+    uint32_t size = count > 1 ? stats_start[count - 2].block_size + 1 : 1;
+    if (size > largest->block_size) {
+        TEST_IGNORE_MESSAGE("No size fits only the largest class");
+    }
+
+    for (uint32_t i = 0; i < allocs; i++) {
+        blocks[i] = malloc(size);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+    }
+
+    mbed_stats_heap_pool_get(stats_current, MAX_CLASSES);
+    TEST_ASSERT_EQUAL(largest->block_cnt, stats_current[count - 1].current_cnt);
+    TEST_ASSERT(stats_current[count - 1].overflow_cnt > largest->overflow_cnt);
+
+    for (uint32_t i = 0; i < allocs; i++) {
+        free(blocks[i]);
+    }
+
+    mbed_stats_heap_pool_get(stats_current, MAX_CLASSES);
+    TEST_ASSERT_EQUAL(largest->current_cnt, stats_current[count - 1].current_cnt);
+}
+
+/* Test realloc moves data between the pools and the heap.
+ *
+ * Given is a pooled allocation.
+ * When it is grown past the largest class and shrunk again.
+ * Then the data is preserved.
+ */
+void test_realloc()
+{
+    size_t count = mbed_stats_heap_pool_get(stats_start, MAX_CLASSES);
+    uint32_t large = stats_start[count - 1].block_size * 2;
+
+    uint8_t *data = (uint8_t *)malloc(8);
+    TEST_ASSERT_NOT_NULL(data);
+    for (int i = 0; i < 8; i++) {
+        data[i] = i;
+    }
+
+    data = (uint8_t *)realloc(data, large);
+    TEST_ASSERT_NOT_NULL(data);
+    data = (uint8_t *)realloc(data, 8);
+    TEST_ASSERT_NOT_NULL(data);
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL(i, data[i]);
+    }
+    free(data);
+}
+
+utest::v1::status_t test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(10, "default_auto");
+    return utest::v1::verbose_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("Test size classes", test_classes),
+    Case("Test pooled malloc and free", test_alloc_free),
+    Case("Test fallback to the heap", test_overflow),
+    Case("Test realloc across pools and heap", test_realloc),
+};
+
+utest::v1::Specification specification(test_setup, cases);
+
+int main()
+{
+    return !utest::v1::Harness::run(specification);
+}
@@ -0,0 +1,179 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+
+#include "mbed.h"
+#include "platform/SPSCCircularBuffer.h"
+
+using namespace utest::v1;
+
+/* Test single element push and pop.
+ *
+ * Given is a buffer with the capacity equal to N (BufferSize).
+ * When the buffer is filled with N elements.
+ * Then further pushes fail and all elements are read in the FIFO order.
+ *
+ */
+template<uint32_t BufferSize>
+void test_push_max_pop_max()
+{
+    SPSCCircularBuffer<uint32_t, BufferSize> cb;
+
+    for (uint32_t i = 0; i < BufferSize; i++) {
+        TEST_ASSERT_TRUE(cb.push(0xAA + i));
+        TEST_ASSERT_EQUAL(i + 1, cb.size());
+    }
+
+    TEST_ASSERT_TRUE(cb.full());
+    TEST_ASSERT_FALSE(cb.push(0xFF));
+
+    uint32_t data = 0;
+    for (uint32_t i = 0; i < BufferSize; i++) {
+        TEST_ASSERT_TRUE(cb.pop(data));
+        TEST_ASSERT_EQUAL(0xAA + i, data);
+        TEST_ASSERT_EQUAL(BufferSize - i - 1, cb.size());
+    }
+
+    TEST_ASSERT_TRUE(cb.empty());
+    TEST_ASSERT_FALSE(cb.pop(data));
+}
+
+/* Test bulk push and pop around the end of the storage.
+ *
+ * Given is a buffer with the capacity equal to 5.
+ * When chunks of various sizes are pushed and popped.
+ * Then the data comes out in the FIFO order and the counts are limited by space and content.
+ *
+ */
+void test_bulk_wrap()
+{
+    SPSCCircularBuffer<char, 5> cb;
+    char in[8];
+    char out[8];
+    char next_in = 0;
+    char next_out = 0;
+
+    for (int i = 0; i < 100; i++) {
+        uint32_t want = i % 7;
+        for (uint32_t j = 0; j < want; j++) {
+            in[j] = next_in + j;
+        }
+
+        uint32_t space = 5 - cb.size();
+        uint32_t pushed = cb.push(in, want);
+        TEST_ASSERT_EQUAL(want < space ? want : space, pushed);
+        next_in += pushed;
+
+        uint32_t size = cb.size();
+        uint32_t popped = cb.pop(out, (i * 3) % 7);
+        TEST_ASSERT(popped <= size);
+        for (uint32_t j = 0; j < popped; j++) {
+            TEST_ASSERT_EQUAL(next_out, out[j]);
+            next_out++;
+        }
+    }
+}
+
+/* Test peek.
+ *
+ * Given is a buffer with one element.
+ * When the element is peeked.
+ * Then the element stays in the buffer.
+ *
+ */
+void test_peek_no_pop()
+{
+    SPSCCircularBuffer<int, 3> cb;
+    int data = 0;
+
+    TEST_ASSERT_FALSE(cb.peek(data));
+    cb.push(7);
+    TEST_ASSERT_TRUE(cb.peek(data));
+    TEST_ASSERT_EQUAL(7, data);
+    TEST_ASSERT_EQUAL(1, cb.size());
+
+    cb.reset();
+    TEST_ASSERT_TRUE(cb.empty());
+}
+
+/* Test an interrupt producer with a thread consumer.
+ *
+ * Given is a buffer filled from a ticker interrupt.
+ * When a thread drains it in chunks at the same time.
+ * Then every element arrives once and in order.
+ *
+ */
+static SPSCCircularBuffer<uint8_t, 16> irq_cb;
+static volatile uint32_t irq_next;
+
+static void irq_producer()
+{
+    for (int i = 0; i < 4; i++) {
+        if (irq_cb.push((uint8_t)irq_next)) {
+            irq_next++;
+        }
+    }
+}
+
+void test_irq_producer()
+{
+    const uint32_t total = 2000;
+    uint32_t next = 0;
+    uint8_t out[5];
+
+    irq_cb.reset();
+    irq_next = 0;
+
+    Ticker ticker;
+    ticker.attach_us(irq_producer, 100);
+
+    Timer timer;
+    timer.start();
+    while (next < total && timer.read_ms() < 5000) {
+        uint32_t popped = irq_cb.pop(out, sizeof(out));
+        for (uint32_t i = 0; i < popped; i++) {
+            TEST_ASSERT_EQUAL((uint8_t)next, out[i]);
+            next++;
+        }
+    }
+
+    ticker.detach();
+    TEST_ASSERT(next >= total);
+}
+
+Case cases[] = {
+    Case("push max, pop max (1)", test_push_max_pop_max<1>),
+    Case("push max, pop max (5)", test_push_max_pop_max<5>),
+    Case("bulk push and pop wrap around", test_bulk_wrap),
+    Case("peek() returns data without popping the element", test_peek_no_pop),
+    Case("interrupt producer, thread consumer", test_irq_producer),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(15, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+
+int main()
+{
+    return Harness::run(specification);
+}
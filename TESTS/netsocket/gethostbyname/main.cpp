@@ -105,6 +105,76 @@ void test_dns_literal_pref() {
     TEST_ASSERT(strcmp(ip_literal, addr.get_ip_address()) == 0);
 }
 
+void test_dns_query_dual() {
+    SocketAddress addr[4];
+    int count = nsapi_dns_query_dual(net, MBED_CONF_APP_DNS_TEST_HOST, addr, 4);
+    TEST_ASSERT(count > 0);
+
+    bool found_pref = false;
+    for (int i = 0; i < count; i++) {
+        printf("DNS: dual query \"%s\" => \"%s\"\n",
+                MBED_CONF_APP_DNS_TEST_HOST, addr[i].get_ip_address());
+        TEST_ASSERT((bool)addr[i]);
+        found_pref |= addr[i].get_ip_version() == ip_pref;
+    }
+
+    // the family the stack is using must not be lost to the other
+    TEST_ASSERT(found_pref);
+}
+
+// Async tests
+Semaphore async_done;
+nsapi_error_t async_result;
+SocketAddress async_addr;
+
+void async_cb(nsapi_error_t result, SocketAddress *address) {
+    async_result = result;
+    if (address) {
+        async_addr = *address;
+    }
+    async_done.release();
+}
+
+void test_dns_query_async() {
+    async_addr = SocketAddress();
+    nsapi_error_t err = net->gethostbyname_async(MBED_CONF_APP_DNS_TEST_HOST,
+            mbed::callback(async_cb), ip_pref);
+    TEST_ASSERT(err >= 0);
+
+    // either answered from the cache, or wait for the callback
+    TEST_ASSERT(async_done.wait(60000) > 0);
+    printf("DNS: async query %s \"%s\" => \"%s\"\n",
+            ip_pref_repr, MBED_CONF_APP_DNS_TEST_HOST, async_addr.get_ip_address());
+
+    TEST_ASSERT_EQUAL(0, async_result);
+    TEST_ASSERT((bool)async_addr);
+    TEST_ASSERT_EQUAL(ip_pref, async_addr.get_ip_version());
+}
+
+void test_dns_query_async_cached() {
+    // the previous queries left the answer in the cache
+    async_addr = SocketAddress();
+    nsapi_error_t err = net->gethostbyname_async(MBED_CONF_APP_DNS_TEST_HOST,
+            mbed::callback(async_cb), ip_pref);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT(async_done.wait(0) > 0);
+
+    TEST_ASSERT_EQUAL(0, async_result);
+    TEST_ASSERT((bool)async_addr);
+    TEST_ASSERT_EQUAL(ip_pref, async_addr.get_ip_version());
+}
+
+void test_dns_literal_async() {
+    async_addr = SocketAddress();
+    nsapi_error_t err = net->gethostbyname_async(ip_literal,
+            mbed::callback(async_cb));
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT(async_done.wait(0) > 0);
+
+    TEST_ASSERT_EQUAL(0, async_result);
+    TEST_ASSERT(strcmp(ip_literal, async_addr.get_ip_address()) == 0);
+}
+
 
 // Test setup
 utest::v1::status_t test_setup(const size_t number_of_cases) {
@@ -118,6 +188,10 @@ Case cases[] = {
     Case("DNS preference query",    test_dns_query_pref),
     Case("DNS literal",             test_dns_literal),
     Case("DNS preference literal",  test_dns_literal_pref),
+    Case("DNS dual query",          test_dns_query_dual),
+    Case("DNS async query",         test_dns_query_async),
+    Case("DNS async cached query",  test_dns_query_async_cached),
+    Case("DNS async literal",       test_dns_literal_async),
 };
 
 Specification specification(test_setup, cases);
@@ -19,6 +19,9 @@
 
 #if DEVICE_I2C_ASYNCH
 #include "platform/mbed_power_mgmt.h"
+#include "platform/mbed_critical.h"
+#include "hal/us_ticker_api.h"
+#include "events/EventQueue.h"
 #endif
 
 namespace mbed {
@@ -26,9 +29,14 @@ namespace mbed {
 I2C *I2C::_owner = NULL;
 SingletonPtr<PlatformMutex> I2C::_mutex;
 
+#if DEVICE_I2C_ASYNCH && MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+I2C *I2C::_instances = NULL;
+#endif
+
 I2C::I2C(PinName sda, PinName scl) :
 #if DEVICE_I2C_ASYNCH
     _irq(this), _usage(DMA_USAGE_NEVER), _deep_sleep_locked(false),
+    _event_queue(NULL), _stats(), _transfer_start(0),
 #endif
     _i2c(), _hz(100000)
 {
@@ -39,6 +47,27 @@ I2C::I2C(PinName sda, PinName scl) :
 
     // Used to avoid unnecessary frequency updates
     _owner = this;
+
+#if DEVICE_I2C_ASYNCH && MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+    core_util_critical_section_enter();
+    _next_instance = _instances;
+    _instances = this;
+    core_util_critical_section_exit();
+#endif
+}
+
+I2C::~I2C()
+{
+#if DEVICE_I2C_ASYNCH && MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+    core_util_critical_section_enter();
+    for (I2C **obj = &_instances; *obj; obj = &(*obj)->_next_instance) {
+        if (*obj == this) {
+            *obj = _next_instance;
+            break;
+        }
+    }
+    core_util_critical_section_exit();
+#endif
 }
 
 void I2C::frequency(int hz) {
@@ -129,40 +158,180 @@ void I2C::unlock() {
 
 int I2C::transfer(int address, const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length, const event_callback_t& callback, int event, bool repeated)
 {
+    Transfer t;
+    t.address = address;
+    t.tx_buffer = tx_buffer;
+    t.tx_length = tx_length;
+    t.rx_buffer = rx_buffer;
+    t.rx_length = rx_length;
+    t.callback = callback;
+    t.event = event;
+    t.repeated = repeated;
+    return transfer_batch(&t, 1);
+}
+
+int I2C::transfer_batch(const Transfer *transfers, int count)
+{
+    if (count <= 0) {
+        return -1;
+    }
+
     lock();
-    if (i2c_active(&_i2c)) {
+    core_util_critical_section_enter();
+
+    // the first transfer starts right away on an idle bus, the rest wait in the queue
+    bool idle = !i2c_active(&_i2c);
+#if MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+    idle = idle && _transfer_buffer.empty();
+    int space = MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE - _transfer_buffer.size();
+#else
+    int space = 0;
+#endif
+    if (count - (idle ? 1 : 0) > space) {
+        _stats.rejected += count;
+        core_util_critical_section_exit();
         unlock();
         return -1; // transaction ongoing
     }
-    lock_deep_sleep();
-    aquire();
 
-    _callback = callback;
-    int stop = (repeated) ? 0 : 1;
-    _irq.callback(&I2C::irq_handler_asynch);
-    i2c_transfer_asynch(&_i2c, (void *)tx_buffer, tx_length, (void *)rx_buffer, rx_length, address, stop, _irq.entry(), event, _usage);
+    for (int i = 0; i < count; i++) {
+        if (i == 0 && idle) {
+            start_transfer(transfers[i]);
+        } else {
+#if MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+            _transfer_buffer.push(transfers[i]);
+            _stats.queued += 1;
+#endif
+        }
+    }
+
+#if MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+    if (_transfer_buffer.size() > _stats.max_queue_depth) {
+        _stats.max_queue_depth = _transfer_buffer.size();
+    }
+#endif
+
+    core_util_critical_section_exit();
     unlock();
     return 0;
 }
 
+void I2C::start_transfer(const Transfer &transfer)
+{
+    lock_deep_sleep();
+
+    // may run from the interrupt of the previous transfer, so the
+    // bus is claimed without taking the mutex
+    if (_owner != this) {
+        i2c_frequency(&_i2c, _hz);
+        _owner = this;
+    }
+
+    _callback = transfer.callback;
+    int stop = (transfer.repeated) ? 0 : 1;
+    _irq.callback(&I2C::irq_handler_asynch);
+    _transfer_start = us_ticker_read();
+    i2c_transfer_asynch(&_i2c, (void *)transfer.tx_buffer, transfer.tx_length, (void *)transfer.rx_buffer, transfer.rx_length,
+            transfer.address, stop, _irq.entry(), transfer.event, _usage);
+}
+
+#if MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+
+bool I2C::dequeue_transfer()
+{
+    Transfer t;
+    if (_transfer_buffer.pop(t)) {
+        start_transfer(t);
+        return true;
+    }
+    return false;
+}
+
+void I2C::dequeue_other_transfer(I2C *except)
+{
+    for (I2C *obj = _instances; obj; obj = obj->_next_instance) {
+        if (obj != except && !obj->_transfer_buffer.empty() && !i2c_active(&obj->_i2c)) {
+            obj->dequeue_transfer();
+            return;
+        }
+    }
+}
+
+#endif
+
 void I2C::abort_transfer(void)
 {
     lock();
+    core_util_critical_section_enter();
     i2c_abort_asynch(&_i2c);
     unlock_deep_sleep();
+#if MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+    if (!dequeue_transfer()) {
+        dequeue_other_transfer(this);
+    }
+#endif
+    core_util_critical_section_exit();
     unlock();
 }
 
+void I2C::clear_transfer_buffer(void)
+{
+#if MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+    _transfer_buffer.reset();
+#endif
+}
+
+void I2C::set_event_queue(events::EventQueue *queue)
+{
+    core_util_critical_section_enter();
+    _event_queue = queue;
+    core_util_critical_section_exit();
+}
+
+void I2C::get_stats(Stats *stats)
+{
+    core_util_critical_section_enter();
+    *stats = _stats;
+    core_util_critical_section_exit();
+}
+
+void I2C::reset_stats()
+{
+    core_util_critical_section_enter();
+    _stats = Stats();
+    core_util_critical_section_exit();
+}
+
 void I2C::irq_handler_asynch(void)
 {
     int event = i2c_irq_handler_asynch(&_i2c);
-    if (_callback && event) {
-        _callback.call(event);
+    if (!event) {
+        return;
+    }
+
+    _stats.transfers += 1;
+    _stats.busy_us += (uint32_t)(us_ticker_read() - _transfer_start);
+    if (event & (I2C_EVENT_ERROR | I2C_EVENT_ERROR_NO_SLAVE | I2C_EVENT_TRANSFER_EARLY_NACK)) {
+        _stats.errors += 1;
     }
-    if (event) {
-        unlock_deep_sleep();
+
+    // start the next transfer before the callback so the bus does not idle
+    event_callback_t callback = _callback;
+    unlock_deep_sleep();
+#if MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+    if (!dequeue_transfer()) {
+        // objects sharing this bus may have queued behind us
+        dequeue_other_transfer(this);
     }
+#endif
 
+    if (callback) {
+        if (!_event_queue) {
+            callback.call(event);
+        } else if (!_event_queue->call(callback, event)) {
+            _stats.dropped_callbacks += 1;
+        }
+    }
 }
 
 void I2C::lock_deep_sleep()
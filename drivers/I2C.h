@@ -29,6 +29,15 @@
 #include "platform/CThunk.h"
 #include "hal/dma_api.h"
 #include "platform/FunctionPointer.h"
+#include "platform/CircularBuffer.h"
+
+#ifndef MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+#define MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE 4
+#endif
+
+namespace events {
+class EventQueue;
+}
 #endif
 
 namespace mbed {
@@ -151,15 +160,41 @@ public:
      */
     virtual void unlock(void);
 
-    virtual ~I2C() {
-        // Do nothing
-    }
+    virtual ~I2C();
 
 #if DEVICE_I2C_ASYNCH
 
+    /** Transfer of a batch, writes the TX buffer and then reads into the RX buffer
+     */
+    struct Transfer {
+        int address;                /**< 8/10 bit I2C slave address */
+        const char *tx_buffer;      /**< The TX buffer with data to be transfered */
+        int tx_length;              /**< The length of TX buffer in bytes */
+        char *rx_buffer;            /**< The RX buffer which is used for received data */
+        int rx_length;              /**< The length of RX buffer in bytes */
+        event_callback_t callback;  /**< The event callback function, may be empty */
+        int event;                  /**< The logical OR of events to modify */
+        bool repeated;              /**< Repeated start, true - do not send stop at end */
+    };
+
+    /** Statistics of the non-blocking transfers of an I2C object
+     */
+    struct Stats {
+        uint32_t transfers;         /**< Transfers that completed, successfully or not */
+        uint32_t errors;            /**< Transfers that completed with an error event */
+        uint32_t queued;            /**< Transfers that had to wait in the queue */
+        uint32_t rejected;          /**< Transfers rejected because the queue was full */
+        uint32_t max_queue_depth;   /**< Most transfers waiting in the queue at once */
+        uint32_t dropped_callbacks; /**< Callbacks lost because the event queue was full */
+        uint64_t busy_us;           /**< Time the bus spent on transfers in microseconds */
+    };
+
     /** Start non-blocking I2C transfer.
      *
      * This function locks the deep sleep until any event has occurred
+     *
+     * If the peripheral is busy the transfer is queued and started from the
+     * interrupt that completes the transfer before it.
      * 
      * @param address   8/10 bit I2C slave address
      * @param tx_buffer The TX buffer with data to be transfered
@@ -169,14 +204,53 @@ public:
      * @param event     The logical OR of events to modify
      * @param callback  The event callback function
      * @param repeated Repeated start, true - do not send stop at end
-     * @return Zero if the transfer has started, or -1 if I2C peripheral is busy
+     * @return Zero if the transfer has started or was queued, or -1 if I2C peripheral is busy and the queue is full
      */
     int transfer(int address, const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length, const event_callback_t& callback, int event = I2C_EVENT_TRANSFER_COMPLETE, bool repeated = false);
 
-    /** Abort the on-going I2C transfer
+    /** Start a batch of non-blocking I2C transfers.
+     *
+     * The transfers are queued at once, for example to read a set of sensors
+     * with one call, and run back to back. Each transfer reports to its own
+     * callback, a failed transfer does not stop the rest of the batch.
+     *
+     * The size of a batch is limited by the drivers.i2c-transaction-queue-size
+     * configuration.
+     *
+     * @param transfers The transfers, copied before this returns
+     * @param count     The number of transfers
+     * @return Zero if the batch has started or was queued, or -1 if the queue can not hold all transfers
+     */
+    int transfer_batch(const Transfer *transfers, int count);
+
+    /** Abort the on-going I2C transfer, and continue with transfers in the queue if any.
      */
     void abort_transfer();
 
+    /** Clear the transfers waiting in the queue
+     */
+    void clear_transfer_buffer();
+
+    /** Deliver transfer callbacks through an event queue
+     *
+     * Callbacks are called in interrupt context unless an event queue is
+     * set, in which case they are posted to the queue and called from the
+     * thread dispatching it.
+     *
+     * @param queue The event queue, or NULL to call callbacks from the interrupt
+     */
+    void set_event_queue(events::EventQueue *queue);
+
+    /** Get the statistics of the non-blocking transfers
+     *
+     * @param stats Destination for the statistics
+     */
+    void get_stats(Stats *stats);
+
+    /** Reset the statistics of the non-blocking transfers
+     */
+    void reset_stats();
+
   protected:
     /** Lock deep sleep only if it is not yet locked */
     void lock_deep_sleep();
@@ -185,10 +259,35 @@ public:
     void unlock_deep_sleep();
 
     void irq_handler_asynch(void);
+
+    /** Configure the peripheral and start a transfer, without locking */
+    void start_transfer(const Transfer &transfer);
+
+#if MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE
+    /** Start the next queued transfer
+     *
+     *  @return True if a transfer was started
+     */
+    bool dequeue_transfer();
+
+    /** Start a transfer queued by another I2C object whose bus is idle
+     */
+    static void dequeue_other_transfer(I2C *except);
+
+    CircularBuffer<Transfer, MBED_CONF_DRIVERS_I2C_TRANSACTION_QUEUE_SIZE> _transfer_buffer;
+
+    // all I2C objects, so objects sharing a bus can take turns
+    static I2C *_instances;
+    I2C *_next_instance;
+#endif
+
     event_callback_t _callback;
     CThunk<I2C> _irq;
     DMAUsage _usage;
     bool _deep_sleep_locked;
+    events::EventQueue *_event_queue;
+    Stats _stats;
+    uint32_t _transfer_start;
 #endif
 
 protected:
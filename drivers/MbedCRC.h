@@ -54,8 +54,10 @@ typedef enum crc_polynomial {
 /** CRC object provides CRC generation through hardware/software
  *
  *  ROM polynomial tables for supported polynomials (:: crc_polynomial_t) will be used for
- *  software CRC computation, if ROM tables are not available then CRC is computed runtime
- *  bit by bit for all data input.
+ *  software CRC computation, if ROM tables are not available then tables are generated
+ *  at compile time for the polynomial (see "drivers.crc-table-size"). Reflected CRCs are
+ *  computed in the reflected domain, so data bytes are not reflected one by one.
+ *  CRCs narrower than 8 bits without a ROM table are computed bit by bit.
  *
  *  @tparam  polynomial CRC polynomial value in hex
  *  @tparam  width CRC polynomial width
@@ -178,12 +180,18 @@ public:
      */
     int32_t compute_partial(void *buffer, crc_data_size_t size, uint32_t *crc)
     {
-        if (NULL == _crc_table) {
+        if (is_reflected()) {
+            // Reflected CRC, data bytes are used without reflecting them
+            return engine_compute_partial<true>(buffer, size, crc);
+        } else if (has_rom_table()) {
+            // ROM table CRC
+            return table_compute_partial(buffer, size, crc);
+        } else if ((width >= 8) && !_reflect_data) {
+            // Table CRC with table generated at compile time
+            return engine_compute_partial<false>(buffer, size, crc);
+        } else {
             // Compute bitwise CRC
             return bitwise_compute_partial(buffer, size, crc);
-        } else {
-            // Table CRC
-            return table_compute_partial(buffer, size, crc);
         }
     }
 
@@ -200,7 +208,7 @@ public:
     int32_t compute_partial_start(uint32_t *crc)
     {
         MBED_ASSERT(crc != NULL);
-        *crc = _initial_value;
+        *crc = is_reflected() ? reflect(_initial_value, width) : _initial_value;
         return 0;
     }
 
@@ -216,7 +224,15 @@ public:
     {
         MBED_ASSERT(crc != NULL);
         uint32_t p_crc = *crc;
-        if ((width < 8) && (NULL == _crc_table)) {
+        if (is_reflected()) {
+            // Remainder is computed reflected already
+            if (!_reflect_remainder) {
+                p_crc = reflect(p_crc, width);
+            }
+            *crc = (p_crc ^ _final_xor) & get_crc_mask();
+            return 0;
+        }
+        if ((width < 8) && !has_rom_table()) {
             p_crc = (uint32_t)(p_crc << (8 - width));
         }
         *crc = (reflect_remainder(p_crc) ^ _final_xor) & get_crc_mask();
@@ -276,6 +292,47 @@ private:
         return (width < 8 ? ((1u << 8) - 1) : (uint32_t)((uint64_t)(1ull << width) - 1));
     }
 
+    /** Check if CRC is computed in the reflected domain
+     *
+     * @return  true if data is reflected and CRC is at least 8 bits wide
+     */
+    bool is_reflected(void) const
+    {
+        return (width >= 8) && _reflect_data;
+    }
+
+    /** Check if the polynomial has a ROM table in TableCRC.cpp
+     *
+     * @return  true for the supported polynomials :: crc_polynomial_t
+     */
+    bool has_rom_table(void) const
+    {
+        return ((polynomial == POLY_7BIT_SD) && (width == 7)) ||
+               ((polynomial == POLY_8BIT_CCITT) && (width == 8)) ||
+               ((polynomial == POLY_16BIT_CCITT) && (width == 16)) ||
+               ((polynomial == POLY_16BIT_IBM) && (width == 16)) ||
+               ((polynomial == POLY_32BIT_ANSI) && (width == 32));
+    }
+
+    /** Reflect the lower bits of a value
+     *
+     * @param  data value to be reflected
+     * @param  nBits number of bits to reflect
+     * @return  Reflected value
+     */
+    static uint32_t reflect(uint32_t data, uint8_t nBits)
+    {
+        uint32_t reflection = 0x0;
+
+        for (uint8_t bit = 0; bit < nBits; ++bit) {
+            if (data & 0x01) {
+                reflection |= (1u << ((nBits - 1) - bit));
+            }
+            data = (data >> 1);
+        }
+        return (reflection);
+    }
+
     /** Final value of CRC is reflected
      *
      * @param  data final crc value, which should be reflected
@@ -284,16 +341,7 @@ private:
     uint32_t reflect_remainder(uint32_t data) const
     {
         if (_reflect_remainder) {
-            uint32_t reflection = 0x0;
-            uint8_t const nBits = (width < 8 ? 8 : width);
-
-            for (uint8_t bit = 0; bit < nBits; ++bit) {
-                if (data & 0x01) {
-                    reflection |= (1 << ((nBits - 1) - bit));
-                }
-                data = (data >> 1);
-            }
-            return (reflection);
+            return reflect(data, (width < 8 ? 8 : width));
         } else {
             return data;
         }
@@ -405,6 +453,29 @@ private:
         return 0;
     }
 
+    /** CRC computation using the CRC engine
+     *
+     * Tables are generated at compile time, the reflected engine keeps
+     * the CRC value reflected, see MBED_CRC_GENERATED_TABLE_SIZE.
+     *
+     * @tparam  reflected  use the reflected engine
+     * @param  buffer  data buffer
+     * @param  size  size of the data
+     * @param  crc  CRC value is filled in, but the value is not the final
+     * @return  0  on success or a negative error code on failure
+     */
+    template <bool reflected>
+    int32_t engine_compute_partial(const void *buffer, crc_data_size_t size, uint32_t *crc) const
+    {
+        MBED_ASSERT(crc != NULL);
+        MBED_ASSERT(buffer != NULL);
+
+        const uint8_t *data = static_cast<const uint8_t *>(buffer);
+        *crc = internal::crc_engine<polynomial, width, reflected, MBED_CRC_GENERATED_TABLE_SIZE>::compute(
+                   *crc, data, data + size);
+        return 0;
+    }
+
     /** Constructor init called from all specialized cases of constructor
      *  Note: All construtor common code should be in this function.
      */
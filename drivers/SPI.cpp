@@ -25,13 +25,14 @@
 namespace mbed {
 
 #if DEVICE_SPI_ASYNCH && TRANSACTION_QUEUE_SIZE_SPI
-CircularBuffer<Transaction<SPI>, TRANSACTION_QUEUE_SIZE_SPI> SPI::_transaction_buffer;
+SPI *SPI::_instances = NULL;
 #endif
 
 SPI::SPI(PinName mosi, PinName miso, PinName sclk, PinName ssel) :
         _spi(),
 #if DEVICE_SPI_ASYNCH
         _irq(this),
+        _cs(NULL),
         _usage(DMA_USAGE_NEVER),
         _deep_sleep_locked(false),
 #endif
@@ -43,6 +44,26 @@ SPI::SPI(PinName mosi, PinName miso, PinName sclk, PinName ssel) :
 
     spi_init(&_spi, mosi, miso, sclk, ssel);
     _acquire();
+
+#if DEVICE_SPI_ASYNCH && TRANSACTION_QUEUE_SIZE_SPI
+    core_util_critical_section_enter();
+    _next_instance = _instances;
+    _instances = this;
+    core_util_critical_section_exit();
+#endif
+}
+
+SPI::~SPI() {
+#if DEVICE_SPI_ASYNCH && TRANSACTION_QUEUE_SIZE_SPI
+    core_util_critical_section_enter();
+    for (SPI **obj = &_instances; *obj; obj = &(*obj)->_next_instance) {
+        if (*obj == this) {
+            *obj = _next_instance;
+            break;
+        }
+    }
+    core_util_critical_section_exit();
+#endif
 }
 
 void SPI::format(int bits, int mode) {
@@ -140,11 +161,24 @@ int SPI::transfer(const void *tx_buffer, int tx_length, void *rx_buffer, int rx_
 
 void SPI::abort_transfer()
 {
+    core_util_critical_section_enter();
     spi_abort_asynch(&_spi);
     unlock_deep_sleep();
+    bool started = false;
 #if TRANSACTION_QUEUE_SIZE_SPI
-    dequeue_transaction();
+    // the rest of an aborted chain must not run with chip select still low
+    drop_chain(NULL);
+    if (_cs) {
+        _cs->write(1);
+        _cs = NULL;
+    }
+    started = dequeue_transaction();
 #endif
+    if (!started && _cs) {
+        _cs->write(1);
+        _cs = NULL;
+    }
+    core_util_critical_section_exit();
 }
 
 
@@ -170,24 +204,71 @@ int SPI::set_dma_usage(DMAUsage usage)
     return  0;
 }
 
+int SPI::transfer_chain(const Segment *segments, int count)
+{
+    if (count <= 0) {
+        return -1;
+    }
+
+    core_util_critical_section_enter();
+
+    // the first segment starts right away on an idle bus, the rest wait in the queue
+    bool idle = !spi_active(&_spi);
+#if TRANSACTION_QUEUE_SIZE_SPI
+    idle = idle && _transaction_buffer.empty();
+    int space = TRANSACTION_QUEUE_SIZE_SPI - _transaction_buffer.size();
+#else
+    int space = 0;
+#endif
+    if (count - (idle ? 1 : 0) > space) {
+        core_util_critical_section_exit();
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        QueuedTransaction t;
+        t.transaction.tx_buffer = const_cast<void *>(segments[i].tx_buffer);
+        t.transaction.tx_length = segments[i].tx_length;
+        t.transaction.rx_buffer = segments[i].rx_buffer;
+        t.transaction.rx_length = segments[i].rx_length;
+        t.transaction.event = segments[i].event;
+        t.transaction.callback = segments[i].callback;
+        t.transaction.width = 8;
+        t.cs = segments[i].cs;
+        t.chained = i > 0;
+
+        if (i == 0 && idle) {
+            start_transaction(&t);
+        } else {
+#if TRANSACTION_QUEUE_SIZE_SPI
+            _transaction_buffer.push(t);
+#endif
+        }
+    }
+
+    core_util_critical_section_exit();
+    return 0;
+}
+
 int SPI::queue_transfer(const void *tx_buffer, int tx_length, void *rx_buffer, int rx_length, unsigned char bit_width, const event_callback_t& callback, int event)
 {
 #if TRANSACTION_QUEUE_SIZE_SPI
-    transaction_t t;
-
-    t.tx_buffer = const_cast<void *>(tx_buffer);
-    t.tx_length = tx_length;
-    t.rx_buffer = rx_buffer;
-    t.rx_length = rx_length;
-    t.event = event;
-    t.callback = callback;
-    t.width = bit_width;
-    Transaction<SPI> transaction(this, t);
+    QueuedTransaction t;
+
+    t.transaction.tx_buffer = const_cast<void *>(tx_buffer);
+    t.transaction.tx_length = tx_length;
+    t.transaction.rx_buffer = rx_buffer;
+    t.transaction.rx_length = rx_length;
+    t.transaction.event = event;
+    t.transaction.callback = callback;
+    t.transaction.width = bit_width;
+    t.cs = NULL;
+    t.chained = false;
     if (_transaction_buffer.full()) {
         return -1; // the buffer is full
     } else {
         core_util_critical_section_enter();
-        _transaction_buffer.push(transaction);
+        _transaction_buffer.push(t);
         if (!spi_active(&_spi)) {
             dequeue_transaction();
         }
@@ -224,20 +305,51 @@ void SPI::unlock_deep_sleep()
     }
 }
 
+void SPI::start_transaction(QueuedTransaction *data)
+{
+    // chip select stays asserted only within a chain
+    if (_cs && (_cs != data->cs || !data->chained)) {
+        _cs->write(1);
+    }
+    _cs = data->cs;
+    if (_cs) {
+        _cs->write(0);
+    }
+
+    transaction_t *t = &data->transaction;
+    start_transfer(t->tx_buffer, t->tx_length, t->rx_buffer, t->rx_length, t->width, t->callback, t->event);
+}
+
 #if TRANSACTION_QUEUE_SIZE_SPI
 
-void SPI::start_transaction(transaction_t *data)
+bool SPI::dequeue_transaction()
 {
-    start_transfer(data->tx_buffer, data->tx_length, data->rx_buffer, data->rx_length, data->width, data->callback, data->event);
+    QueuedTransaction t;
+    if (_transaction_buffer.pop(t)) {
+        start_transaction(&t);
+        return true;
+    }
+    return false;
 }
 
-void SPI::dequeue_transaction()
+void SPI::drop_chain(event_callback_t *last)
 {
-    Transaction<SPI> t;
-    if (_transaction_buffer.pop(t)) {
-        SPI* obj = t.get_object();
-        transaction_t* data = t.get_transaction();
-        obj->start_transaction(data);
+    QueuedTransaction t;
+    while (_transaction_buffer.peek(t) && t.chained) {
+        _transaction_buffer.pop(t);
+        if (last) {
+            *last = (t.transaction.event & SPI_EVENT_ERROR) ? t.transaction.callback : event_callback_t();
+        }
+    }
+}
+
+void SPI::dequeue_other_transaction(SPI *except)
+{
+    for (SPI *obj = _instances; obj; obj = obj->_next_instance) {
+        if (obj != except && !obj->_transaction_buffer.empty() && !spi_active(&obj->_spi)) {
+            obj->dequeue_transaction();
+            return;
+        }
     }
 }
 
@@ -246,16 +358,45 @@ void SPI::dequeue_transaction()
 void SPI::irq_handler_asynch(void)
 {
     int event = spi_irq_handler_asynch(&_spi);
-    if (_callback && (event & SPI_EVENT_ALL)) {
-        unlock_deep_sleep();
-        _callback.call(event & SPI_EVENT_ALL);
+    if (!(event & (SPI_EVENT_ALL | SPI_EVENT_INTERNAL_TRANSFER_COMPLETE))) {
+        return;
     }
+
+    // SPI peripheral is free (event happened), start the next transaction
+    // before the callback so queued transfers follow without a gap
+    event_callback_t callback = _callback;
+    event_callback_t chain_callback;
+    unlock_deep_sleep();
+    bool started = false;
 #if TRANSACTION_QUEUE_SIZE_SPI
-    if (event & (SPI_EVENT_ALL | SPI_EVENT_INTERNAL_TRANSFER_COMPLETE)) {
-        // SPI peripheral is free (event happened), dequeue transaction
-        dequeue_transaction();
+    if (event & SPI_EVENT_ERROR) {
+        // drop what is left of a failed chain, its last segment is told once
+        drop_chain(&chain_callback);
+        if (_cs) {
+            _cs->write(1);
+            _cs = NULL;
+        }
     }
+    started = dequeue_transaction();
+#endif
+
+    if (!started) {
+        if (_cs) {
+            _cs->write(1);
+            _cs = NULL;
+        }
+#if TRANSACTION_QUEUE_SIZE_SPI
+        // objects sharing this bus may have queued behind us
+        dequeue_other_transaction(this);
 #endif
+    }
+
+    if (callback && (event & SPI_EVENT_ALL)) {
+        callback.call(event & SPI_EVENT_ALL);
+    }
+    if (chain_callback) {
+        chain_callback.call(SPI_EVENT_ERROR);
+    }
 }
 
 #endif
@@ -31,6 +31,7 @@
 #include "platform/CircularBuffer.h"
 #include "platform/FunctionPointer.h"
 #include "platform/Transaction.h"
+#include "drivers/DigitalOut.h"
 #endif
 
 namespace mbed {
@@ -177,7 +178,48 @@ public:
         return 0;
     }
 
+    /** Segment of a scatter-gather transfer
+     */
+    struct Segment {
+        const void *tx_buffer;      /**< TX buffer, or NULL to send the default SPI value */
+        int tx_length;              /**< Length of TX buffer in bytes */
+        void *rx_buffer;            /**< RX buffer, or NULL to ignore received data */
+        int rx_length;              /**< Length of RX buffer in bytes */
+        DigitalOut *cs;             /**< Chip select driven low during the segment, may be NULL */
+        event_callback_t callback;  /**< The event callback function, may be empty */
+        int event;                  /**< The logical OR of events to modify */
+    };
+
+    /** Start non-blocking scatter-gather SPI transfer using 8bit buffers.
+     *
+     * All segments are queued at once. Each segment is started from the
+     * interrupt that completes the previous one, before the callback of the
+     * previous segment runs, so the gap between segments is the interrupt
+     * latency rather than a round trip through the application.
+     * Consecutive segments of a chain with the same chip select keep it
+     * asserted.
+     *
+     * If a segment fails with SPI_EVENT_ERROR the rest of the chain is
+     * dropped. The callback of the failing segment gets the error as usual,
+     * and the callback of the last segment of the chain is then called once
+     * with SPI_EVENT_ERROR if its event mask asks for it. The callbacks of
+     * the other dropped segments are not called. abort_transfer also drops
+     * the rest of the chain, without calling any callbacks.
+     *
+     * The first segment on an idle bus starts right away and the rest wait
+     * in the transaction queue, so a chain can hold one more segment than
+     * TRANSACTION_QUEUE_SIZE_SPI. With TRANSACTION_QUEUE_SIZE_SPI set to 0,
+     * the default on most targets, only a single segment is accepted.
+     *
+     * @param segments  The segments to transfer, copied before this returns
+     * @param count     The number of segments
+     * @return Zero if the transfer has started or was added to the queue, or -1 if the queue can not hold all segments
+     */
+    int transfer_chain(const Segment *segments, int count);
+
     /** Abort the on-going SPI transfer, and continue with transfer's in the queue if any.
+     *
+     *  The rest of an aborted chain is dropped and its chip select released.
      */
     void abort_transfer();
 
@@ -254,26 +296,50 @@ private:
     void unlock_deep_sleep();
 
 
-#if TRANSACTION_QUEUE_SIZE_SPI
+    /** Queued transfer with its chip select
+     */
+    struct QueuedTransaction {
+        transaction_t transaction;
+        DigitalOut *cs;
+        bool chained;   // continues the chain of the previous transaction
+    };
 
     /** Start a new transaction
      *
      *  @param data Transaction data
     */
-    void start_transaction(transaction_t *data);
+    void start_transaction(QueuedTransaction *data);
+
+#if TRANSACTION_QUEUE_SIZE_SPI
 
     /** Dequeue a transaction
      *
+     *  @return True if a transaction was started
+    */
+    bool dequeue_transaction();
+
+    /** Drop the chained transactions at the head of the queue
+     *
+     *  @param last Set to the callback of the last dropped transaction if it
+     *              takes SPI_EVENT_ERROR, may be NULL
     */
-    void dequeue_transaction();
-    static CircularBuffer<Transaction<SPI>, TRANSACTION_QUEUE_SIZE_SPI> _transaction_buffer;
+    void drop_chain(event_callback_t *last);
+
+    /** Start a transaction queued by another SPI object whose bus is idle
+     */
+    static void dequeue_other_transaction(SPI *except);
+
+    CircularBuffer<QueuedTransaction, TRANSACTION_QUEUE_SIZE_SPI> _transaction_buffer;
+
+    // all SPI objects, so objects sharing a bus can take turns
+    static SPI *_instances;
+    SPI *_next_instance;
 #endif
 
 #endif
 
 public:
-    virtual ~SPI() {
-    }
+    virtual ~SPI();
 
 protected:
     spi_t _spi;
@@ -281,6 +347,7 @@ protected:
 #if DEVICE_SPI_ASYNCH
     CThunk<SPI> _irq;
     event_callback_t _callback;
+    DigitalOut *_cs;
     DMAUsage _usage;
     bool _deep_sleep_locked;
 #endif
@@ -25,11 +25,275 @@ namespace mbed {
 
 #define MBED_CRC_TABLE_SIZE     256
 
+#ifdef MBED_CONF_DRIVERS_CRC_TABLE_SLICES
+#define MBED_CRC_TABLE_SLICES   MBED_CONF_DRIVERS_CRC_TABLE_SLICES
+#else
+#define MBED_CRC_TABLE_SLICES   4
+#endif
+
+#if (MBED_CRC_TABLE_SLICES != 4) && (MBED_CRC_TABLE_SLICES != 8)
+#error "MBED_CRC_TABLE_SLICES must be 4 or 8"
+#endif
+
+/* Tables for polynomials without a ROM table are generated at compile time,
+ * either 256 entries (a byte per lookup) or 16 entries (a nibble per lookup),
+ * 0 disables generation and falls back to bitwise computation.
+ */
+#ifdef MBED_CONF_DRIVERS_CRC_TABLE_SIZE
+#define MBED_CRC_GENERATED_TABLE_SIZE   MBED_CONF_DRIVERS_CRC_TABLE_SIZE
+#else
+#define MBED_CRC_GENERATED_TABLE_SIZE   256
+#endif
+
+#if (MBED_CRC_GENERATED_TABLE_SIZE != 0) && (MBED_CRC_GENERATED_TABLE_SIZE != 16) && \
+    (MBED_CRC_GENERATED_TABLE_SIZE != 256)
+#error "MBED_CRC_GENERATED_TABLE_SIZE must be 0, 16 or 256"
+#endif
+
 extern const uint8_t Table_CRC_7Bit_SD[MBED_CRC_TABLE_SIZE];
 extern const uint8_t Table_CRC_8bit_CCITT[MBED_CRC_TABLE_SIZE];
 extern const uint16_t Table_CRC_16bit_CCITT[MBED_CRC_TABLE_SIZE];
 extern const uint16_t Table_CRC_16bit_IBM[MBED_CRC_TABLE_SIZE];
 extern const uint32_t Table_CRC_32bit_ANSI[MBED_CRC_TABLE_SIZE];
+extern const uint32_t Table_CRC_32bit_Rev_ANSI[MBED_CRC_TABLE_SLICES][MBED_CRC_TABLE_SIZE];
+
+namespace internal {
+/* Smallest type holding a CRC register of the given width */
+template <uint8_t width, bool byte = (width <= 8), bool half = (width <= 16)>
+struct crc_table_type { typedef uint32_t type; };
+template <uint8_t width, bool half>
+struct crc_table_type<width, true, half> { typedef uint8_t type; };
+template <uint8_t width>
+struct crc_table_type<width, false, true> { typedef uint16_t type; };
+
+/* Reflect the lower bits of a value at compile time */
+template <uint32_t data, uint8_t bits>
+struct crc_reflect {
+    static const uint32_t value = ((data & 1) << (bits - 1)) | crc_reflect<(data >> 1), bits - 1>::value;
+};
+template <uint32_t data>
+struct crc_reflect<data, 0> {
+    static const uint32_t value = 0;
+};
+
+/* CRC register layout, registers narrower than 8 bits are kept left-aligned in 8 bits */
+template <uint32_t polynomial, uint8_t width>
+struct crc_register {
+    static const uint8_t bits = (width < 8) ? 8 : width;
+    static const uint32_t top_bit = (uint32_t)1 << (bits - 1);
+    static const uint32_t mask = (uint32_t)(((uint64_t)1 << bits) - 1);
+    static const uint32_t poly = polynomial << (bits - width);
+    static const uint32_t rpoly = crc_reflect<polynomial, width>::value;
+};
+
+/* Shift a CRC register by a number of bits, MSB first or reflected (LSB first) */
+template <uint32_t polynomial, uint8_t width, bool reflected, uint32_t crc, uint8_t bits>
+struct crc_shift;
+template <uint32_t polynomial, uint8_t width, uint32_t crc, uint8_t bits>
+struct crc_shift<polynomial, width, false, crc, bits> {
+    typedef crc_register<polynomial, width> reg;
+    static const uint32_t value = crc_shift<polynomial, width, false,
+            ((crc & reg::top_bit) ? ((crc << 1) ^ reg::poly) : (crc << 1)) & reg::mask, bits - 1>::value;
+};
+template <uint32_t polynomial, uint8_t width, uint32_t crc, uint8_t bits>
+struct crc_shift<polynomial, width, true, crc, bits> {
+    typedef crc_register<polynomial, width> reg;
+    static const uint32_t value = crc_shift<polynomial, width, true,
+            ((crc & 1) ? ((crc >> 1) ^ reg::rpoly) : (crc >> 1)), bits - 1>::value;
+};
+template <uint32_t polynomial, uint8_t width, uint32_t crc>
+struct crc_shift<polynomial, width, false, crc, 0> {
+    static const uint32_t value = crc;
+};
+template <uint32_t polynomial, uint8_t width, uint32_t crc>
+struct crc_shift<polynomial, width, true, crc, 0> {
+    static const uint32_t value = crc;
+};
+
+/* Table entry: CRC of an index of the given number of bits */
+template <uint32_t polynomial, uint8_t width, bool reflected, uint8_t bits, uint32_t index>
+struct crc_table_entry {
+    typedef crc_register<polynomial, width> reg;
+    static const uint32_t value = crc_shift<polynomial, width, reflected,
+            (reflected ? index : (index << (reg::bits - bits))), bits>::value;
+};
+
+#define MBED_CRC_TABLE_ENTRY(bits, i) \
+    crc_table_entry<polynomial, width, reflected, bits, (i)>::value
+#define MBED_CRC_TABLE_ENTRIES_4(bits, i) \
+    MBED_CRC_TABLE_ENTRY(bits, (i)), MBED_CRC_TABLE_ENTRY(bits, (i) + 1), \
+    MBED_CRC_TABLE_ENTRY(bits, (i) + 2), MBED_CRC_TABLE_ENTRY(bits, (i) + 3)
+#define MBED_CRC_TABLE_ENTRIES_16(bits, i) \
+    MBED_CRC_TABLE_ENTRIES_4(bits, (i)), MBED_CRC_TABLE_ENTRIES_4(bits, (i) + 4), \
+    MBED_CRC_TABLE_ENTRIES_4(bits, (i) + 8), MBED_CRC_TABLE_ENTRIES_4(bits, (i) + 12)
+#define MBED_CRC_TABLE_ENTRIES_64(bits, i) \
+    MBED_CRC_TABLE_ENTRIES_16(bits, (i)), MBED_CRC_TABLE_ENTRIES_16(bits, (i) + 16), \
+    MBED_CRC_TABLE_ENTRIES_16(bits, (i) + 32), MBED_CRC_TABLE_ENTRIES_16(bits, (i) + 48)
+
+/* Lookup tables generated at compile time, placed in ROM */
+template <uint32_t polynomial, uint8_t width, bool reflected, uint32_t size>
+struct crc_table;
+template <uint32_t polynomial, uint8_t width, bool reflected>
+struct crc_table<polynomial, width, reflected, 16> {
+    typedef typename crc_table_type<width>::type type;
+    static const type table[16];
+};
+template <uint32_t polynomial, uint8_t width, bool reflected>
+const typename crc_table<polynomial, width, reflected, 16>::type
+crc_table<polynomial, width, reflected, 16>::table[16] = {
+    MBED_CRC_TABLE_ENTRIES_16(4, 0)
+};
+template <uint32_t polynomial, uint8_t width, bool reflected>
+struct crc_table<polynomial, width, reflected, 256> {
+    typedef typename crc_table_type<width>::type type;
+    static const type table[256];
+};
+template <uint32_t polynomial, uint8_t width, bool reflected>
+const typename crc_table<polynomial, width, reflected, 256>::type
+crc_table<polynomial, width, reflected, 256>::table[256] = {
+    MBED_CRC_TABLE_ENTRIES_64(8, 0), MBED_CRC_TABLE_ENTRIES_64(8, 64),
+    MBED_CRC_TABLE_ENTRIES_64(8, 128), MBED_CRC_TABLE_ENTRIES_64(8, 192)
+};
+
+#undef MBED_CRC_TABLE_ENTRY
+#undef MBED_CRC_TABLE_ENTRIES_4
+#undef MBED_CRC_TABLE_ENTRIES_16
+#undef MBED_CRC_TABLE_ENTRIES_64
+
+/* CRC engine, updates a CRC register with data
+ *
+ * Reflected engines keep the register reflected, so data bytes are used
+ * as they are. The size selects bitwise (0), nibble (16) or byte (256)
+ * table computation.
+ */
+template <uint32_t polynomial, uint8_t width, bool reflected, uint32_t size>
+struct crc_engine;
+
+template <uint32_t polynomial, uint8_t width>
+struct crc_engine<polynomial, width, false, 0> {
+    static uint32_t compute(uint32_t crc, const uint8_t *data, const uint8_t *end)
+    {
+        typedef crc_register<polynomial, width> reg;
+        for (; data != end; data++) {
+            crc ^= (uint32_t)*data << (reg::bits - 8);
+            for (uint8_t bit = 8; bit > 0; --bit) {
+                crc = (crc & reg::top_bit) ? ((crc << 1) ^ reg::poly) : (crc << 1);
+            }
+        }
+        return crc & reg::mask;
+    }
+};
+
+template <uint32_t polynomial, uint8_t width>
+struct crc_engine<polynomial, width, false, 16> {
+    static uint32_t compute(uint32_t crc, const uint8_t *data, const uint8_t *end)
+    {
+        typedef crc_register<polynomial, width> reg;
+        const typename crc_table<polynomial, width, false, 16>::type *table =
+                crc_table<polynomial, width, false, 16>::table;
+        for (; data != end; data++) {
+            crc = table[((crc >> (reg::bits - 4)) ^ (*data >> 4)) & 0xF] ^ (crc << 4);
+            crc = table[((crc >> (reg::bits - 4)) ^ *data) & 0xF] ^ (crc << 4);
+        }
+        return crc & reg::mask;
+    }
+};
+
+template <uint32_t polynomial, uint8_t width>
+struct crc_engine<polynomial, width, false, 256> {
+    static uint32_t compute(uint32_t crc, const uint8_t *data, const uint8_t *end)
+    {
+        typedef crc_register<polynomial, width> reg;
+        const typename crc_table<polynomial, width, false, 256>::type *table =
+                crc_table<polynomial, width, false, 256>::table;
+        for (; data != end; data++) {
+            crc = table[((crc >> (reg::bits - 8)) ^ *data) & 0xFF] ^ (crc << 8);
+        }
+        return crc & reg::mask;
+    }
+};
+
+template <uint32_t polynomial, uint8_t width>
+struct crc_engine<polynomial, width, true, 0> {
+    static uint32_t compute(uint32_t crc, const uint8_t *data, const uint8_t *end)
+    {
+        typedef crc_register<polynomial, width> reg;
+        for (; data != end; data++) {
+            crc ^= *data;
+            for (uint8_t bit = 8; bit > 0; --bit) {
+                crc = (crc & 1) ? ((crc >> 1) ^ reg::rpoly) : (crc >> 1);
+            }
+        }
+        return crc & reg::mask;
+    }
+};
+
+template <uint32_t polynomial, uint8_t width>
+struct crc_engine<polynomial, width, true, 16> {
+    static uint32_t compute(uint32_t crc, const uint8_t *data, const uint8_t *end)
+    {
+        typedef crc_register<polynomial, width> reg;
+        const typename crc_table<polynomial, width, true, 16>::type *table =
+                crc_table<polynomial, width, true, 16>::table;
+        for (; data != end; data++) {
+            crc ^= *data;
+            crc = table[crc & 0xF] ^ (crc >> 4);
+            crc = table[crc & 0xF] ^ (crc >> 4);
+        }
+        return crc & reg::mask;
+    }
+};
+
+template <uint32_t polynomial, uint8_t width>
+struct crc_engine<polynomial, width, true, 256> {
+    static uint32_t compute(uint32_t crc, const uint8_t *data, const uint8_t *end)
+    {
+        typedef crc_register<polynomial, width> reg;
+        const typename crc_table<polynomial, width, true, 256>::type *table =
+                crc_table<polynomial, width, true, 256>::table;
+        for (; data != end; data++) {
+            crc = table[(crc ^ *data) & 0xFF] ^ (crc >> 8);
+        }
+        return crc & reg::mask;
+    }
+};
+
+/* Reflected 32-bit ANSI CRC uses the slicing-by-4/8 ROM tables,
+ * whatever the size of the generated tables */
+struct crc_engine_32bit_rev_ansi {
+    static uint32_t compute(uint32_t crc, const uint8_t *data, const uint8_t *end)
+    {
+        const uint32_t (*table)[MBED_CRC_TABLE_SIZE] = Table_CRC_32bit_Rev_ANSI;
+
+        while (end - data >= MBED_CRC_TABLE_SLICES) {
+            crc ^= ((uint32_t)data[0]) | ((uint32_t)data[1] << 8) |
+                   ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+#if MBED_CRC_TABLE_SLICES == 8
+            crc = table[7][crc & 0xFF] ^ table[6][(crc >> 8) & 0xFF] ^
+                  table[5][(crc >> 16) & 0xFF] ^ table[4][crc >> 24] ^
+                  table[3][data[4]] ^ table[2][data[5]] ^
+                  table[1][data[6]] ^ table[0][data[7]];
+#else
+            crc = table[3][crc & 0xFF] ^ table[2][(crc >> 8) & 0xFF] ^
+                  table[1][(crc >> 16) & 0xFF] ^ table[0][crc >> 24];
+#endif
+            data += MBED_CRC_TABLE_SLICES;
+        }
+
+        for (; data != end; data++) {
+            crc = table[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+};
+
+template <>
+struct crc_engine<0x04C11DB7, 32, true, 0> : crc_engine_32bit_rev_ansi {};
+template <>
+struct crc_engine<0x04C11DB7, 32, true, 16> : crc_engine_32bit_rev_ansi {};
+template <>
+struct crc_engine<0x04C11DB7, 32, true, 256> : crc_engine_32bit_rev_ansi {};
+} // namespace internal
 
 /** @}*/
 } // namespace mbed
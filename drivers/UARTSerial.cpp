@@ -26,21 +26,67 @@
 #include "platform/mbed_wait_api.h"
 #endif
 
+#if UART_SERIAL_DMA
+#include "platform/mbed_power_mgmt.h"
+#endif
+
 namespace mbed {
 
+#if UART_SERIAL_DMA
+/* Receive transfers never ask for more than the RX buffer can take. */
+static const uint32_t rx_chunk_length =
+    UART_SERIAL_DMA_RX_CHUNK < MBED_CONF_DRIVERS_UART_SERIAL_RXBUF_SIZE ?
+    UART_SERIAL_DMA_RX_CHUNK : MBED_CONF_DRIVERS_UART_SERIAL_RXBUF_SIZE;
+#endif
+
 UARTSerial::UARTSerial(PinName tx, PinName rx, int baud) :
         SerialBase(tx, rx, baud),
         _blocking(true),
         _tx_irq_enabled(false),
-        _rx_irq_enabled(true),
+        _rx_irq_enabled(!UART_SERIAL_DMA),
         _dcd_irq(NULL)
+#if UART_SERIAL_DMA
+        , _tx_chunk_length(0),
+        _rx_chunk_length(0),
+        _tx_dma_active(false),
+        _rx_dma_active(false),
+        _rx_dma_counted(false),
+        _rx_dma_irq(false)
+#endif
 {
+#if UART_SERIAL_DMA
+    /* Receive through non-blocking transfers instead of IRQ routines. */
+    SerialBase::set_dma_usage_tx(DMA_USAGE_OPPORTUNISTIC);
+    SerialBase::set_dma_usage_rx(DMA_USAGE_NEVER);
+
+    core_util_critical_section_enter();
+    start_rx_dma();
+    core_util_critical_section_exit();
+#else
     /* Attatch IRQ routines to the serial device. */
     SerialBase::attach(callback(this, &UARTSerial::rx_irq), RxIrq);
+#endif
 }
 
 UARTSerial::~UARTSerial()
 {
+#if UART_SERIAL_DMA
+    _rx_flush.detach();
+
+    core_util_critical_section_enter();
+    if (_rx_dma_active) {
+        _rx_callback = NULL;
+        serial_rx_abort_asynch(&_serial);
+        sleep_manager_unlock_deep_sleep();
+    }
+    if (_tx_dma_active) {
+        _tx_callback = NULL;
+        serial_tx_abort_asynch(&_serial);
+        sleep_manager_unlock_deep_sleep();
+    }
+    core_util_critical_section_exit();
+#endif
+
     delete _dcd_irq;
 }
 
@@ -109,7 +155,11 @@ int UARTSerial::sync()
 {
     api_lock();
 
+#if UART_SERIAL_DMA
+    while (!_txbuf.empty() || _tx_chunk_length) {
+#else
     while (!_txbuf.empty()) {
+#endif
         api_unlock();
         // Doing better than wait would require TxIRQ to also do wake() when becoming empty. Worth it?
         wait_ms(1);
@@ -134,14 +184,26 @@ void UARTSerial::sigio(Callback<void()> func) {
 }
 
 ssize_t UARTSerial::write(const void* buffer, size_t length)
+{
+    struct iovec iov = { const_cast<void *>(buffer), length };
+    return writev(&iov, 1);
+}
+
+ssize_t UARTSerial::writev(const struct iovec *iov, int iovcnt)
 {
     size_t data_written = 0;
-    const char *buf_ptr = static_cast<const char *>(buffer);
+    size_t length = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        length += iov[i].iov_len;
+    }
 
     if (length == 0) {
         return 0;
     }
 
+    int iov_index = 0;
+    size_t iov_off = 0;
+
     api_lock();
 
     // Unlike read, we should write the whole thing if blocking. POSIX only
@@ -161,11 +223,22 @@ ssize_t UARTSerial::write(const void* buffer, size_t length)
         }
 
         while (data_written < length && !_txbuf.full()) {
-            _txbuf.push(*buf_ptr++);
-            data_written++;
+            while (iov_off == iov[iov_index].iov_len) {
+                iov_index++;
+                iov_off = 0;
+            }
+            size_t n = _txbuf.push(static_cast<const char *>(iov[iov_index].iov_base) + iov_off,
+                                   iov[iov_index].iov_len - iov_off);
+            iov_off += n;
+            data_written += n;
         }
 
         core_util_critical_section_enter();
+#if UART_SERIAL_DMA
+        if (!_tx_dma_active) {
+            start_tx_dma();
+        }
+#else
         if (!_tx_irq_enabled) {
             UARTSerial::tx_irq();                // only write to hardware in one place
             if (!_txbuf.empty()) {
@@ -173,6 +246,7 @@ ssize_t UARTSerial::write(const void* buffer, size_t length)
                 _tx_irq_enabled = true;
             }
         }
+#endif
         core_util_critical_section_exit();
     }
 
@@ -183,14 +257,25 @@ ssize_t UARTSerial::write(const void* buffer, size_t length)
 
 ssize_t UARTSerial::read(void* buffer, size_t length)
 {
-    size_t data_read = 0;
+    struct iovec iov = { buffer, length };
+    return readv(&iov, 1);
+}
 
-    char *ptr = static_cast<char *>(buffer);
+ssize_t UARTSerial::readv(const struct iovec *iov, int iovcnt)
+{
+    size_t data_read = 0;
+    size_t length = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        length += iov[i].iov_len;
+    }
 
     if (length == 0) {
         return 0;
     }
 
+    int iov_index = 0;
+    size_t iov_off = 0;
+
     api_lock();
 
     while (_rxbuf.empty()) {
@@ -204,11 +289,24 @@ ssize_t UARTSerial::read(void* buffer, size_t length)
     }
 
     while (data_read < length && !_rxbuf.empty()) {
-        _rxbuf.pop(*ptr++);
-        data_read++;
+        while (iov_off == iov[iov_index].iov_len) {
+            iov_index++;
+            iov_off = 0;
+        }
+        size_t n = _rxbuf.pop(static_cast<char *>(iov[iov_index].iov_base) + iov_off,
+                              iov[iov_index].iov_len - iov_off);
+        iov_off += n;
+        data_read += n;
     }
 
     core_util_critical_section_enter();
+#if UART_SERIAL_DMA
+    if (!_rx_dma_irq) {
+        if (!_rx_dma_active) {
+            start_rx_dma();                 // restart once there is room for a chunk
+        }
+    } else
+#endif
     if (!_rx_irq_enabled) {
         UARTSerial::rx_irq();               // only read from hardware in one place
         if (!_rxbuf.full()) {
@@ -284,10 +382,15 @@ void UARTSerial::rx_irq(void)
     bool was_empty = _rxbuf.empty();
 
     /* Fill in the receive buffer if the peripheral is readable
-     * and receive buffer is not full. */
+     * and receive buffer is not full, publishing the data in chunks. */
     while (!_rxbuf.full() && SerialBase::readable()) {
-        char data = SerialBase::_base_getc();
-        _rxbuf.push(data);
+        char data[16];
+        uint32_t space = MBED_CONF_DRIVERS_UART_SERIAL_RXBUF_SIZE - _rxbuf.size();
+        uint32_t count = 0;
+        while (count < sizeof(data) && count < space && SerialBase::readable()) {
+            data[count++] = SerialBase::_base_getc();
+        }
+        _rxbuf.push(data, count);
     }
 
     if (_rx_irq_enabled && _rxbuf.full()) {
@@ -324,6 +427,136 @@ void UARTSerial::tx_irq(void)
     }
 }
 
+#if UART_SERIAL_DMA
+
+// Called with interrupts disabled, or from the event of the previous transfer
+void UARTSerial::start_tx_dma(void)
+{
+    /* A chunk that could not be started before is sent first. */
+    if (_tx_chunk_length == 0) {
+        _tx_chunk_length = _txbuf.pop(reinterpret_cast<char *>(_tx_chunk), sizeof(_tx_chunk));
+        if (_tx_chunk_length == 0) {
+            return;
+        }
+    }
+
+    if (SerialBase::write(_tx_chunk, _tx_chunk_length, callback(this, &UARTSerial::tx_dma_event), SERIAL_EVENT_TX_COMPLETE)) {
+        return;
+    }
+
+    _tx_dma_active = true;
+}
+
+void UARTSerial::tx_dma_event(int event)
+{
+    bool was_full = _txbuf.full();
+
+    _tx_chunk_length = 0;
+    _tx_dma_active = false;
+    start_tx_dma();
+
+    /* Report the File handler that data can be written to peripheral. */
+    if (was_full && !_txbuf.full() && !hup()) {
+        wake();
+    }
+}
+
+// Called with interrupts disabled, or from the event of the previous transfer
+void UARTSerial::start_rx_dma(void)
+{
+    /* Only receive when the whole chunk fits, readv restarts the transfer
+     * once enough has been read. */
+    uint32_t length = _rx_dma_counted ? rx_chunk_length : 1;
+    if (MBED_CONF_DRIVERS_UART_SERIAL_RXBUF_SIZE - _rxbuf.size() < length) {
+        return;
+    }
+
+    if (SerialBase::read(_rx_chunk, length, callback(this, &UARTSerial::rx_dma_event), SERIAL_EVENT_RX_ALL)) {
+        return;
+    }
+
+    _rx_chunk_length = length;
+    _rx_dma_active = true;
+
+    /* There is no idle line event in the HAL, so a chunk that is still
+     * filling after twice the time it takes to receive is passed on as is. */
+    if (length > 1) {
+        _rx_flush.attach_us(callback(this, &UARTSerial::rx_dma_flush), rx_flush_us());
+    }
+}
+
+us_timestamp_t UARTSerial::rx_flush_us(void)
+{
+    /* Ten bits per character, at least a millisecond. */
+    uint32_t flush_us = 2 * rx_chunk_length * 10 * 1000000 / _baud;
+    return flush_us > 1000 ? flush_us : 1000;
+}
+
+void UARTSerial::rx_dma_event(int event)
+{
+    core_util_critical_section_enter();
+    _rx_flush.detach();
+
+    uint32_t count = _serial.rx_buff.pos;
+    if (event & SERIAL_EVENT_RX_COMPLETE) {
+        /* A HAL that counted the whole transfer can be trusted to count
+         * a partly filled chunk for the flush. One that didn't would be
+         * left moving a character per transfer, so the ISR takes over. */
+        if (!_rx_dma_counted) {
+            if (count == _rx_chunk_length) {
+                _rx_dma_counted = true;
+            } else {
+                _rx_dma_irq = true;
+            }
+        }
+        count = _rx_chunk_length;
+    }
+    rx_dma_done(count);
+    core_util_critical_section_exit();
+}
+
+void UARTSerial::rx_dma_flush(void)
+{
+    core_util_critical_section_enter();
+    if (_rx_dma_active && serial_rx_active(&_serial)) {
+        if (_serial.rx_buff.pos == 0) {
+            /* Nothing arrived, keep waiting. */
+            _rx_flush.attach_us(callback(this, &UARTSerial::rx_dma_flush), rx_flush_us());
+        } else {
+            _rx_callback = NULL;
+            serial_rx_abort_asynch(&_serial);
+            sleep_manager_unlock_deep_sleep();
+            rx_dma_done(_serial.rx_buff.pos);
+        }
+    }
+    core_util_critical_section_exit();
+}
+
+void UARTSerial::rx_dma_done(uint32_t count)
+{
+    bool was_empty = _rxbuf.empty();
+
+    if (count > _rx_chunk_length) {
+        count = _rx_chunk_length;
+    }
+    _rxbuf.push(reinterpret_cast<char *>(_rx_chunk), count);
+
+    _rx_dma_active = false;
+    if (!_rx_dma_irq) {
+        start_rx_dma();
+    } else if (!_rx_irq_enabled && !_rxbuf.full()) {
+        SerialBase::attach(callback(this, &UARTSerial::rx_irq), RxIrq);
+        _rx_irq_enabled = true;
+    }
+
+    /* Report the File handler that data is ready to be read from the buffer. */
+    if (was_empty && !_rxbuf.empty()) {
+        wake();
+    }
+}
+
+#endif
+
 void UARTSerial::wait_ms(uint32_t millisec)
 {
     /* wait_ms implementation for RTOS spins until exact microseconds - we
@@ -26,7 +26,7 @@
 #include "InterruptIn.h"
 #include "PlatformMutex.h"
 #include "serial_api.h"
-#include "CircularBuffer.h"
+#include "SPSCCircularBuffer.h"
 #include "platform/NonCopyable.h"
 
 #ifndef MBED_CONF_DRIVERS_UART_SERIAL_RXBUF_SIZE
@@ -37,6 +37,21 @@
 #define MBED_CONF_DRIVERS_UART_SERIAL_TXBUF_SIZE  256
 #endif
 
+#ifndef MBED_CONF_DRIVERS_UART_SERIAL_DMA
+#define MBED_CONF_DRIVERS_UART_SERIAL_DMA  0
+#endif
+
+#if DEVICE_SERIAL_ASYNCH && MBED_CONF_DRIVERS_UART_SERIAL_DMA
+#define UART_SERIAL_DMA 1
+#include "Timeout.h"
+
+/** Size of the chunks moved by each non-blocking transfer */
+#define UART_SERIAL_DMA_RX_CHUNK 32
+#define UART_SERIAL_DMA_TX_CHUNK 64
+#else
+#define UART_SERIAL_DMA 0
+#endif
+
 namespace mbed {
 
 /** \addtogroup drivers */
@@ -97,6 +112,28 @@ public:
      */
     virtual ssize_t read(void* buffer, size_t length);
 
+    /** Write the contents of a list of buffers to a file
+     *
+     *  Buffers are written in order, with the same semantics as write of
+     *  their total size, and only take the transmit lock once
+     *
+     *  @param iov      Array of buffers to write from
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         The number of bytes written, negative error on failure
+     */
+    virtual ssize_t writev(const struct iovec *iov, int iovcnt);
+
+    /** Read the contents of a file into a list of buffers
+     *
+     *  Buffers are filled in order, with the same semantics as read of
+     *  their total size
+     *
+     *  @param iov      Array of buffers to read in to
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         The number of bytes read, 0 at end of file, negative error on failure
+     */
+    virtual ssize_t readv(const struct iovec *iov, int iovcnt);
+
     /** Close a file
      *
      *  @return         0 on success, negative error code on failure
@@ -231,9 +268,11 @@ private:
 
     /** Software serial buffers
      *  By default buffer size is 256 for TX and 256 for RX. Configurable through mbed_app.json
+     *  Each buffer has a single producer and consumer, the interrupt handler on
+     *  one side and the file API, under the mutex, on the other.
      */
-    CircularBuffer<char, MBED_CONF_DRIVERS_UART_SERIAL_RXBUF_SIZE> _rxbuf;
-    CircularBuffer<char, MBED_CONF_DRIVERS_UART_SERIAL_TXBUF_SIZE> _txbuf;
+    SPSCCircularBuffer<char, MBED_CONF_DRIVERS_UART_SERIAL_RXBUF_SIZE> _rxbuf;
+    SPSCCircularBuffer<char, MBED_CONF_DRIVERS_UART_SERIAL_TXBUF_SIZE> _txbuf;
 
     PlatformMutex _mutex;
 
@@ -263,6 +302,35 @@ private:
 
     void dcd_irq(void);
 
+#if UART_SERIAL_DMA
+    /** Non-blocking transfers
+     *  Used instead of the ISRs when configured. Data moves between the
+     *  circular buffers and the chunks below in one copy per transfer.
+     *  TX asks for DMA. RX never uses DMA on any HAL, because a partly
+     *  filled chunk is only flushed when the HAL keeps rx_buff.pos
+     *  current, which DMA transfers don't. The first RX transfer moves a
+     *  single character to see whether the HAL counts; if it does, RX
+     *  continues in chunks, otherwise RX falls back to the ISR.
+     */
+    void start_tx_dma(void);
+    void start_rx_dma(void);
+    void tx_dma_event(int event);
+    void rx_dma_event(int event);
+    void rx_dma_flush(void);
+    us_timestamp_t rx_flush_us(void);
+    void rx_dma_done(uint32_t count);
+
+    uint8_t _tx_chunk[UART_SERIAL_DMA_TX_CHUNK];
+    uint8_t _rx_chunk[UART_SERIAL_DMA_RX_CHUNK];
+    uint32_t _tx_chunk_length;
+    uint32_t _rx_chunk_length;
+    bool _tx_dma_active;
+    bool _rx_dma_active;
+    bool _rx_dma_counted;
+    bool _rx_dma_irq;
+    Timeout _rx_flush;
+#endif
+
 };
 } //namespace mbed
 
@@ -57,6 +57,7 @@ public:
             _event->id = 0;
             _event->delay = 0;
             _event->period = -1;
+            _event->affinity = 0;
 
             _event->post = &Event::event_post<F>;
             _event->dtor = &Event::event_dtor<F>;
@@ -120,6 +121,19 @@ public:
         }
     }
 
+    /** Configure the affinity key of an event
+     *
+     *  Events sharing a non-zero affinity key are never executed
+     *  concurrently by EventQueue::dispatch_shared.
+     *
+     *  @param key      Affinity key, 0 for no affinity
+     */
+    void affinity(uint16_t key) {
+        if (_event) {
+            _event->affinity = key;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -189,6 +203,7 @@ private:
 
         int delay;
         int period;
+        uint16_t affinity;
 
         int (*post)(struct event *);
         void (*dtor)(struct event *);
@@ -208,6 +223,7 @@ private:
         new (p) C(*(F*)(e + 1));
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_affinity(p, e->affinity);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -471,6 +487,7 @@ public:
             _event->id = 0;
             _event->delay = 0;
             _event->period = -1;
+            _event->affinity = 0;
 
             _event->post = &Event::event_post<F>;
             _event->dtor = &Event::event_dtor<F>;
@@ -534,6 +551,19 @@ public:
         }
     }
 
+    /** Configure the affinity key of an event
+     *
+     *  Events sharing a non-zero affinity key are never executed
+     *  concurrently by EventQueue::dispatch_shared.
+     *
+     *  @param key      Affinity key, 0 for no affinity
+     */
+    void affinity(uint16_t key) {
+        if (_event) {
+            _event->affinity = key;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -607,6 +637,7 @@ private:
 
         int delay;
         int period;
+        uint16_t affinity;
 
         int (*post)(struct event *, A0 a0);
         void (*dtor)(struct event *);
@@ -626,6 +657,7 @@ private:
         new (p) C(*(F*)(e + 1), a0);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_affinity(p, e->affinity);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -889,6 +921,7 @@ public:
             _event->id = 0;
             _event->delay = 0;
             _event->period = -1;
+            _event->affinity = 0;
 
             _event->post = &Event::event_post<F>;
             _event->dtor = &Event::event_dtor<F>;
@@ -952,6 +985,19 @@ public:
         }
     }
 
+    /** Configure the affinity key of an event
+     *
+     *  Events sharing a non-zero affinity key are never executed
+     *  concurrently by EventQueue::dispatch_shared.
+     *
+     *  @param key      Affinity key, 0 for no affinity
+     */
+    void affinity(uint16_t key) {
+        if (_event) {
+            _event->affinity = key;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -1025,6 +1071,7 @@ private:
 
         int delay;
         int period;
+        uint16_t affinity;
 
         int (*post)(struct event *, A0 a0, A1 a1);
         void (*dtor)(struct event *);
@@ -1044,6 +1091,7 @@ private:
         new (p) C(*(F*)(e + 1), a0, a1);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_affinity(p, e->affinity);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -1307,6 +1355,7 @@ public:
             _event->id = 0;
             _event->delay = 0;
             _event->period = -1;
+            _event->affinity = 0;
 
             _event->post = &Event::event_post<F>;
             _event->dtor = &Event::event_dtor<F>;
@@ -1370,6 +1419,19 @@ public:
         }
     }
 
+    /** Configure the affinity key of an event
+     *
+     *  Events sharing a non-zero affinity key are never executed
+     *  concurrently by EventQueue::dispatch_shared.
+     *
+     *  @param key      Affinity key, 0 for no affinity
+     */
+    void affinity(uint16_t key) {
+        if (_event) {
+            _event->affinity = key;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -1443,6 +1505,7 @@ private:
 
         int delay;
         int period;
+        uint16_t affinity;
 
         int (*post)(struct event *, A0 a0, A1 a1, A2 a2);
         void (*dtor)(struct event *);
@@ -1462,6 +1525,7 @@ private:
         new (p) C(*(F*)(e + 1), a0, a1, a2);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_affinity(p, e->affinity);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -1725,6 +1789,7 @@ public:
             _event->id = 0;
             _event->delay = 0;
             _event->period = -1;
+            _event->affinity = 0;
 
             _event->post = &Event::event_post<F>;
             _event->dtor = &Event::event_dtor<F>;
@@ -1788,6 +1853,19 @@ public:
         }
     }
 
+    /** Configure the affinity key of an event
+     *
+     *  Events sharing a non-zero affinity key are never executed
+     *  concurrently by EventQueue::dispatch_shared.
+     *
+     *  @param key      Affinity key, 0 for no affinity
+     */
+    void affinity(uint16_t key) {
+        if (_event) {
+            _event->affinity = key;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -1861,6 +1939,7 @@ private:
 
         int delay;
         int period;
+        uint16_t affinity;
 
         int (*post)(struct event *, A0 a0, A1 a1, A2 a2, A3 a3);
         void (*dtor)(struct event *);
@@ -1880,6 +1959,7 @@ private:
         new (p) C(*(F*)(e + 1), a0, a1, a2, a3);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_affinity(p, e->affinity);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -2143,6 +2223,7 @@ public:
             _event->id = 0;
             _event->delay = 0;
             _event->period = -1;
+            _event->affinity = 0;
 
             _event->post = &Event::event_post<F>;
             _event->dtor = &Event::event_dtor<F>;
@@ -2206,6 +2287,19 @@ public:
         }
     }
 
+    /** Configure the affinity key of an event
+     *
+     *  Events sharing a non-zero affinity key are never executed
+     *  concurrently by EventQueue::dispatch_shared.
+     *
+     *  @param key      Affinity key, 0 for no affinity
+     */
+    void affinity(uint16_t key) {
+        if (_event) {
+            _event->affinity = key;
+        }
+    }
+
     /** Posts an event onto the underlying event queue
      *
      *  The event is posted to the underlying queue and is executed in the
@@ -2279,6 +2373,7 @@ private:
 
         int delay;
         int period;
+        uint16_t affinity;
 
         int (*post)(struct event *, A0 a0, A1 a1, A2 a2, A3 a3, A4 a4);
         void (*dtor)(struct event *);
@@ -2298,6 +2393,7 @@ private:
         new (p) C(*(F*)(e + 1), a0, a1, a2, a3, a4);
         equeue_event_delay(p, e->delay);
         equeue_event_period(p, e->period);
+        equeue_event_affinity(p, e->affinity);
         equeue_event_dtor(p, &EventQueue::function_dtor<C>);
         return equeue_post(e->equeue, &EventQueue::function_call<C>, p);
     }
@@ -35,6 +35,10 @@ void EventQueue::dispatch(int ms) {
     return equeue_dispatch(&_equeue, ms);
 }
 
+void EventQueue::dispatch_shared(int ms) {
+    return equeue_dispatch_shared(&_equeue, ms);
+}
+
 void EventQueue::break_dispatch() {
     return equeue_break(&_equeue);
 }
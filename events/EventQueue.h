@@ -91,6 +91,25 @@ public:
      */
     void dispatch_forever() { dispatch(); }
 
+    /** Dispatch events from multiple threads
+     *
+     *  Behaves like EventQueue::dispatch, but may be called from several
+     *  threads at once. Each thread acts as a worker pulling ready events
+     *  from the queue, so independent events execute concurrently.
+     *
+     *  Events sharing a non-zero affinity key (see Event::affinity) are
+     *  never executed concurrently and execute in the order they were
+     *  dispatched. break_dispatch stops all of the workers.
+     *
+     *  Shared dispatch should not be mixed with EventQueue::dispatch on
+     *  the same queue.
+     *
+     *  @param ms       Time to wait for events in milliseconds, a negative
+     *                  value will dispatch events indefinitely
+     *                  (default to -1)
+     */
+    void dispatch_shared(int ms=-1);
+
     /** Break out of a running event loop
      *
      *  Forces the specified event queue's dispatch loop to terminate. Pending
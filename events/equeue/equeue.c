@@ -34,6 +34,16 @@ static inline int equeue_clampdiff(unsigned a, unsigned b) {
     return ~(diff >> (8*sizeof(int)-1)) & diff;
 }
 
+// find the power-of-two size class that fits a chunk, bounded by the
+// number of bits in a size_t
+static inline unsigned equeue_sizeclass(size_t size) {
+    unsigned npw2 = 0;
+    for (size_t s = size-1; s; s >>= 1) {
+        npw2++;
+    }
+    return npw2;
+}
+
 // Increment the unique id in an event, hiding the event from cancel
 static inline void equeue_incid(equeue_t *q, struct equeue_event *e) {
     e->id += 1;
@@ -57,6 +67,11 @@ int equeue_create(equeue_t *q, size_t size) {
 }
 
 int equeue_create_inplace(equeue_t *q, size_t size, void *buffer) {
+    return equeue_create_inplace_flags(q, size, buffer, 0);
+}
+
+int equeue_create_inplace_flags(equeue_t *q, size_t size, void *buffer,
+        unsigned flags) {
     // setup queue around provided buffer
     q->buffer = buffer;
     q->allocated = 0;
@@ -66,14 +81,36 @@ int equeue_create_inplace(equeue_t *q, size_t size, void *buffer) {
         q->npw2++;
     }
 
+    q->ready = 0;
+    q->ready_tail = &q->ready;
+    q->workers = 0;
+    q->collecting = false;
+
     q->chunks = 0;
+    q->classes = 0;
     q->slab.size = size;
     q->slab.data = buffer;
 
+    // carve out a free list for each size class that fits in the buffer
+    if (flags & EQUEUE_SIZECLASS) {
+        size_t csize = q->npw2*sizeof(struct equeue_event *);
+        if (q->slab.size < csize) {
+            return -1;
+        }
+
+        q->classes = (struct equeue_event **)q->slab.data;
+        memset(q->classes, 0, csize);
+        q->slab.data += csize;
+        q->slab.size -= csize;
+    }
+
     q->queue = 0;
     q->tick = equeue_tick();
     q->generation = 0;
     q->break_requested = false;
+#ifdef EQUEUE_PAIRING_HEAP
+    q->order = 0;
+#endif
 
     q->background.active = false;
     q->background.update = 0;
@@ -99,8 +136,21 @@ int equeue_create_inplace(equeue_t *q, size_t size, void *buffer) {
     return 0;
 }
 
+#ifdef EQUEUE_PAIRING_HEAP
+static void equeue_heap_remove(equeue_t *q, struct equeue_event *e);
+#endif
+
 void equeue_destroy(equeue_t *q) {
     // call destructors on pending events
+#ifdef EQUEUE_PAIRING_HEAP
+    while (q->queue) {
+        struct equeue_event *e = q->queue;
+        equeue_heap_remove(q, e);
+        if (e->dtor) {
+            e->dtor(e + 1);
+        }
+    }
+#else
     for (struct equeue_event *es = q->queue; es; es = es->next) {
         for (struct equeue_event *e = q->queue; e; e = e->sibling) {
             if (e->dtor) {
@@ -108,6 +158,14 @@ void equeue_destroy(equeue_t *q) {
             }
         }
     }
+#endif
+
+    // including events left over from shared dispatch
+    for (struct equeue_event *e = q->ready; e; e = e->next) {
+        if (e->dtor) {
+            e->dtor(e + 1);
+        }
+    }
 
     // notify background timer
     if (q->background.update) {
@@ -130,20 +188,38 @@ static struct equeue_event *equeue_mem_alloc(equeue_t *q, size_t size) {
 
     equeue_mutex_lock(&q->memlock);
 
-    // check if a good chunk is available
-    for (struct equeue_event **p = &q->chunks; *p; p = &(*p)->next) {
-        if ((*p)->size >= size) {
-            struct equeue_event *e = *p;
-            if (e->sibling) {
-                *p = e->sibling;
-                (*p)->next = e->next;
-            } else {
-                *p = e->next;
-            }
+    if (q->classes) {
+        // round up to a size class, which has its own list of chunks
+        unsigned sc = equeue_sizeclass(size);
+        if (sc >= q->npw2) {
+            equeue_mutex_unlock(&q->memlock);
+            return 0;
+        }
+
+        size = 1 << sc;
+        struct equeue_event *e = q->classes[sc];
+        if (e) {
+            q->classes[sc] = e->next;
 
             equeue_mutex_unlock(&q->memlock);
             return e;
         }
+    } else {
+        // check if a good chunk is available
+        for (struct equeue_event **p = &q->chunks; *p; p = &(*p)->next) {
+            if ((*p)->size >= size) {
+                struct equeue_event *e = *p;
+                if (e->sibling) {
+                    *p = e->sibling;
+                    (*p)->next = e->next;
+                } else {
+                    *p = e->next;
+                }
+
+                equeue_mutex_unlock(&q->memlock);
+                return e;
+            }
+        }
     }
 
     // otherwise allocate a new chunk out of the slab
@@ -165,6 +241,16 @@ static struct equeue_event *equeue_mem_alloc(equeue_t *q, size_t size) {
 static void equeue_mem_dealloc(equeue_t *q, struct equeue_event *e) {
     equeue_mutex_lock(&q->memlock);
 
+    // size classes only need the chunk pushed onto its list
+    if (q->classes) {
+        unsigned sc = equeue_sizeclass(e->size);
+        e->next = q->classes[sc];
+        q->classes[sc] = e;
+
+        equeue_mutex_unlock(&q->memlock);
+        return;
+    }
+
     // stick chunk into list of chunks
     struct equeue_event **p = &q->chunks;
     while (*p && (*p)->size < e->size) {
@@ -192,6 +278,7 @@ void *equeue_alloc(equeue_t *q, size_t size) {
     e->target = 0;
     e->period = -1;
     e->dtor = 0;
+    e->affinity = 0;
 
     return e + 1;
 }
@@ -207,6 +294,93 @@ void equeue_dealloc(equeue_t *q, void *p) {
 }
 
 
+// equeue pairing heap functions
+#ifdef EQUEUE_PAIRING_HEAP
+// events are ordered by target, and then by the order they were posted,
+// the sibling pointer doubles as the first child of a heap node
+static inline bool equeue_heap_before(
+        struct equeue_event *a, struct equeue_event *b) {
+    int diff = equeue_tickdiff(a->target, b->target);
+    return diff < 0 || (diff == 0 && (int)(a->order - b->order) < 0);
+}
+
+static struct equeue_event *equeue_heap_link(
+        struct equeue_event *a, struct equeue_event *b) {
+    if (!a) {
+        return b;
+    } else if (!b) {
+        return a;
+    }
+
+    if (equeue_heap_before(b, a)) {
+        struct equeue_event *t = a;
+        a = b;
+        b = t;
+    }
+
+    // b becomes the first child of a
+    b->next = a->sibling;
+    if (b->next) {
+        b->next->ref = &b->next;
+    }
+
+    a->sibling = b;
+    b->ref = &a->sibling;
+    return a;
+}
+
+static struct equeue_event *equeue_heap_merge(struct equeue_event *es) {
+    // link siblings in pairs from left to right
+    struct equeue_event *pairs = 0;
+    while (es) {
+        struct equeue_event *a = es;
+        struct equeue_event *b = a->next;
+        es = b ? b->next : 0;
+
+        a = equeue_heap_link(a, b);
+        a->next = pairs;
+        pairs = a;
+    }
+
+    // and then link the pairs from right to left
+    struct equeue_event *root = 0;
+    while (pairs) {
+        struct equeue_event *a = pairs;
+        pairs = a->next;
+        root = equeue_heap_link(root, a);
+    }
+
+    return root;
+}
+
+static inline void equeue_heap_setroot(equeue_t *q, struct equeue_event *e) {
+    q->queue = e;
+    if (e) {
+        e->next = 0;
+        e->ref = &q->queue;
+    }
+}
+
+static void equeue_heap_insert(equeue_t *q, struct equeue_event *e) {
+    e->order = q->order++;
+    e->sibling = 0;
+    equeue_heap_setroot(q, equeue_heap_link(q->queue, e));
+}
+
+static void equeue_heap_remove(equeue_t *q, struct equeue_event *e) {
+    // cut the event out of its sibling list
+    *e->ref = e->next;
+    if (e->next) {
+        e->next->ref = e->ref;
+    }
+
+    // and link its children back into the heap
+    struct equeue_event *children = equeue_heap_merge(e->sibling);
+    equeue_heap_setroot(q, equeue_heap_link(q->queue, children));
+}
+#endif
+
+
 // equeue scheduling functions
 static int equeue_enqueue(equeue_t *q, struct equeue_event *e, unsigned tick) {
     // setup event and hash local id with buffer offset for unique id
@@ -216,6 +390,10 @@ static int equeue_enqueue(equeue_t *q, struct equeue_event *e, unsigned tick) {
 
     equeue_mutex_lock(&q->queuelock);
 
+#ifdef EQUEUE_PAIRING_HEAP
+    equeue_heap_insert(q, e);
+    bool head = (q->queue == e);
+#else
     // find the event slot
     struct equeue_event **p = &q->queue;
     while (*p && equeue_tickdiff((*p)->target, e->target) < 0) {
@@ -242,10 +420,11 @@ static int equeue_enqueue(equeue_t *q, struct equeue_event *e, unsigned tick) {
 
     *p = e;
     e->ref = p;
+    bool head = (q->queue == e && !e->sibling);
+#endif
 
     // notify background timer
-    if ((q->background.update && q->background.active) &&
-        (q->queue == e && !e->sibling)) {
+    if (q->background.update && q->background.active && head) {
         q->background.update(q->background.timer,
                 equeue_clampdiff(e->target, tick));
     }
@@ -277,6 +456,9 @@ static struct equeue_event *equeue_unqueue(equeue_t *q, int id) {
     }
 
     // disentangle from queue
+#ifdef EQUEUE_PAIRING_HEAP
+    equeue_heap_remove(q, e);
+#else
     if (e->sibling) {
         e->sibling->next = e->next;
         if (e->sibling->next) {
@@ -291,6 +473,7 @@ static struct equeue_event *equeue_unqueue(equeue_t *q, int id) {
             e->next->ref = e->ref;
         }
     }
+#endif
 
     equeue_incid(q, e);
     equeue_mutex_unlock(&q->queuelock);
@@ -307,6 +490,22 @@ static struct equeue_event *equeue_dequeue(equeue_t *q, unsigned target) {
         q->tick = target;
     }
 
+#ifdef EQUEUE_PAIRING_HEAP
+    // pop expired events off the heap, already in dispatch order
+    struct equeue_event *head = 0;
+    struct equeue_event **tail = &head;
+    while (q->queue && equeue_tickdiff(q->queue->target, target) <= 0) {
+        struct equeue_event *e = q->queue;
+        equeue_heap_remove(q, e);
+
+        *tail = e;
+        tail = &e->next;
+    }
+
+    *tail = 0;
+
+    equeue_mutex_unlock(&q->queuelock);
+#else
     struct equeue_event *head = q->queue;
     struct equeue_event **p = &head;
     while (*p && equeue_tickdiff((*p)->target, target) <= 0) {
@@ -338,6 +537,7 @@ static struct equeue_event *equeue_dequeue(equeue_t *q, unsigned target) {
         *tail = prev;
         tail = &es->next;
     }
+#endif
 
     return head;
 }
@@ -371,6 +571,23 @@ void equeue_break(equeue_t *q) {
     equeue_sema_signal(&q->eventsema);
 }
 
+static void equeue_dispatch_event(equeue_t *q, struct equeue_event *e) {
+    // actually dispatch the callbacks
+    void (*cb)(void *) = e->cb;
+    if (cb) {
+        cb(e + 1);
+    }
+
+    // reenqueue periodic events or deallocate
+    if (e->period >= 0) {
+        e->target += e->period;
+        equeue_enqueue(q, e, equeue_tick());
+    } else {
+        equeue_incid(q, e);
+        equeue_dealloc(q, e+1);
+    }
+}
+
 void equeue_dispatch(equeue_t *q, int ms) {
     unsigned tick = equeue_tick();
     unsigned timeout = tick + ms;
@@ -385,20 +602,7 @@ void equeue_dispatch(equeue_t *q, int ms) {
             struct equeue_event *e = es;
             es = e->next;
 
-            // actually dispatch the callbacks
-            void (*cb)(void *) = e->cb;
-            if (cb) {
-                cb(e + 1);
-            }
-
-            // reenqueue periodic events or deallocate
-            if (e->period >= 0) {
-                e->target += e->period;
-                equeue_enqueue(q, e, equeue_tick());
-            } else {
-                equeue_incid(q, e);
-                equeue_dealloc(q, e+1);
-            }
+            equeue_dispatch_event(q, e);
         }
 
         int deadline = -1;
@@ -453,6 +657,165 @@ void equeue_dispatch(equeue_t *q, int ms) {
 }
 
 
+// shared dispatch
+struct equeue_worker {
+    struct equeue_worker *next;
+    uint16_t affinity;
+};
+
+static struct equeue_event *equeue_ready_pop(equeue_t *q,
+        struct equeue_worker *w) {
+    for (struct equeue_event **p = &q->ready; *p; p = &(*p)->next) {
+        struct equeue_event *e = *p;
+
+        // skip events whose affinity key is held by another worker
+        bool busy = false;
+        if (e->affinity) {
+            for (struct equeue_worker *o = q->workers; o; o = o->next) {
+                if (o->affinity == e->affinity) {
+                    busy = true;
+                    break;
+                }
+            }
+        }
+
+        if (!busy) {
+            *p = e->next;
+            if (!*p) {
+                q->ready_tail = p;
+            }
+
+            w->affinity = e->affinity;
+            return e;
+        }
+    }
+
+    return 0;
+}
+
+void equeue_dispatch_shared(equeue_t *q, int ms) {
+    unsigned tick = equeue_tick();
+    unsigned timeout = tick + ms;
+    bool timedout = false;
+
+    // register as a worker so others can see which key we are holding
+    struct equeue_worker w;
+    w.affinity = 0;
+
+    equeue_mutex_lock(&q->queuelock);
+    w.next = q->workers;
+    q->workers = &w;
+    q->background.active = false;
+    equeue_mutex_unlock(&q->queuelock);
+
+    while (1) {
+        equeue_mutex_lock(&q->queuelock);
+
+        // move expired events onto the ready list, only one worker collects
+        // at a time so events stay in dispatch order
+        if (!q->collecting) {
+            q->collecting = true;
+            equeue_mutex_unlock(&q->queuelock);
+
+            struct equeue_event *es = equeue_dequeue(q, tick);
+
+            equeue_mutex_lock(&q->queuelock);
+            *q->ready_tail = es;
+            while (*q->ready_tail) {
+                q->ready_tail = &(*q->ready_tail)->next;
+            }
+            q->collecting = false;
+        }
+
+        // check if we were notified to break out of dispatch
+        if (q->break_requested) {
+            equeue_mutex_unlock(&q->queuelock);
+            break;
+        }
+
+        struct equeue_event *e = equeue_ready_pop(q, &w);
+        bool pending = q->ready;
+        equeue_mutex_unlock(&q->queuelock);
+
+        if (e) {
+            // wake up another worker to share the remaining events
+            if (pending) {
+                equeue_sema_signal(&q->eventsema);
+            }
+
+            equeue_dispatch_event(q, e);
+
+            // releasing a key may unblock events for other workers
+            if (w.affinity) {
+                equeue_mutex_lock(&q->queuelock);
+                w.affinity = 0;
+                equeue_mutex_unlock(&q->queuelock);
+                equeue_sema_signal(&q->eventsema);
+            }
+        }
+
+        int deadline = -1;
+        tick = equeue_tick();
+
+        // check if we should stop dispatching soon
+        if (ms >= 0) {
+            deadline = equeue_tickdiff(timeout, tick);
+            if (deadline <= 0) {
+                timedout = true;
+                break;
+            }
+        }
+
+        if (e) {
+            continue;
+        }
+
+        // find closest deadline
+        equeue_mutex_lock(&q->queuelock);
+        if (q->queue) {
+            int diff = equeue_clampdiff(q->queue->target, tick);
+            if ((unsigned)diff < (unsigned)deadline) {
+                deadline = diff;
+            }
+        }
+        equeue_mutex_unlock(&q->queuelock);
+
+        // wait for events
+        equeue_sema_wait(&q->eventsema, deadline);
+
+        // update tick for next iteration
+        tick = equeue_tick();
+    }
+
+    // unregister, the last worker out clears any break request and hands
+    // the queue back to the background timer
+    equeue_mutex_lock(&q->queuelock);
+    struct equeue_worker **p = &q->workers;
+    while (*p != &w) {
+        p = &(*p)->next;
+    }
+    *p = w.next;
+
+    bool last = !q->workers;
+    if (last) {
+        if (timedout) {
+            if (q->background.update && q->queue) {
+                q->background.update(q->background.timer,
+                        equeue_clampdiff(q->queue->target, tick));
+            }
+            q->background.active = true;
+        }
+        q->break_requested = false;
+    }
+    equeue_mutex_unlock(&q->queuelock);
+
+    // pass a break request along to the remaining workers
+    if (!last) {
+        equeue_sema_signal(&q->eventsema);
+    }
+}
+
+
 // event functions
 void equeue_event_delay(void *p, int ms) {
     struct equeue_event *e = (struct equeue_event*)p - 1;
@@ -469,6 +832,11 @@ void equeue_event_dtor(void *p, void (*dtor)(void *)) {
     e->dtor = dtor;
 }
 
+void equeue_event_affinity(void *p, uint16_t key) {
+    struct equeue_event *e = (struct equeue_event*)p - 1;
+    e->affinity = key;
+}
+
 
 // simple callbacks
 struct ecallback {
@@ -32,6 +32,19 @@ extern "C" {
 #include <stdint.h>
 
 
+// Scheduler selection
+//
+// By default pending events are kept in a list sorted by target time, which
+// makes posting a timed event linear in the number of distinct pending
+// targets. Defining EQUEUE_PAIRING_HEAP keeps pending events in a pairing
+// heap instead, giving constant-time post and logarithmic cancel and
+// dispatch at the cost of an extra word per event.
+#if !defined(EQUEUE_PAIRING_HEAP)               \
+ && defined(MBED_CONF_EVENTS_USE_PAIRING_HEAP)  \
+ && MBED_CONF_EVENTS_USE_PAIRING_HEAP
+#define EQUEUE_PAIRING_HEAP
+#endif
+
 // The minimum size of an event
 // This size is guaranteed to fit events created by event_call
 #define EQUEUE_EVENT_SIZE (sizeof(struct equeue_event) + 2*sizeof(void*))
@@ -41,12 +54,16 @@ struct equeue_event {
     unsigned size;
     uint8_t id;
     uint8_t generation;
+    uint16_t affinity;
 
     struct equeue_event *next;
     struct equeue_event *sibling;
     struct equeue_event **ref;
 
     unsigned target;
+#ifdef EQUEUE_PAIRING_HEAP
+    unsigned order;
+#endif
     int period;
     void (*dtor)(void *);
 
@@ -60,12 +77,21 @@ typedef struct equeue {
     unsigned tick;
     bool break_requested;
     uint8_t generation;
+#ifdef EQUEUE_PAIRING_HEAP
+    unsigned order;
+#endif
 
     unsigned char *buffer;
     unsigned npw2;
     void *allocated;
 
+    struct equeue_event *ready;
+    struct equeue_event **ready_tail;
+    struct equeue_worker *workers;
+    bool collecting;
+
     struct equeue_event *chunks;
+    struct equeue_event **classes;
     struct equeue_slab {
         size_t size;
         unsigned char *data;
@@ -83,16 +109,32 @@ typedef struct equeue {
 } equeue_t;
 
 
+// Queue creation flags
+//
+// EQUEUE_SIZECLASS - Round events up to power-of-two size classes, each with
+//                    its own free list. Allocation and deallocation become
+//                    constant time regardless of how many different sizes
+//                    of events are in use, at the cost of some internal
+//                    fragmentation and a small table carved from the buffer.
+enum equeue_flags {
+    EQUEUE_SIZECLASS = 0x1,
+};
+
 // Queue lifetime operations
 //
 // Creates and destroys an event queue. The event queue either allocates a
 // buffer of the specified size with malloc or uses a user provided buffer
 // if constructed with equeue_create_inplace.
 //
+// The equeue_create_inplace_flags function additionally accepts a bitwise-or
+// of equeue_flags to select how the queue manages its buffer.
+//
 // If the event queue creation fails, equeue_create returns a negative,
 // platform-specific error code.
 int equeue_create(equeue_t *queue, size_t size);
 int equeue_create_inplace(equeue_t *queue, size_t size, void *buffer);
+int equeue_create_inplace_flags(equeue_t *queue, size_t size, void *buffer,
+        unsigned flags);
 void equeue_destroy(equeue_t *queue);
 
 // Dispatch events
@@ -106,6 +148,22 @@ void equeue_destroy(equeue_t *queue);
 // equeue_dispatch does not wait and is irq safe.
 void equeue_dispatch(equeue_t *queue, int ms);
 
+// Dispatch events from multiple threads
+//
+// Behaves like equeue_dispatch, but may be called from several threads
+// at once on the same queue. Each thread acts as a worker that pulls
+// ready events from a shared list, so independent events can execute
+// concurrently.
+//
+// Events with a non-zero affinity key, set with equeue_event_affinity, are
+// never executed concurrently with other events sharing the same key and
+// execute in the order they were dispatched. Events with no affinity key
+// are executed by whichever worker is available.
+//
+// A call to equeue_break stops all of the workers. Shared dispatch does
+// not mix with equeue_dispatch on the same queue.
+void equeue_dispatch_shared(equeue_t *queue, int ms);
+
 // Break out of a running event loop
 //
 // Forces the specified event queue's dispatch loop to terminate. Pending
@@ -144,6 +202,8 @@ int equeue_call_every(equeue_t *queue, int ms, void (*cb)(void *), void *data);
 // well as avoid memory fragmentation on small devices. The allocator achieves
 // both constant-runtime and zero-fragmentation for fixed-size events, however
 // grows linearly as the quantity of different sized allocations increases.
+// Queues created with the EQUEUE_SIZECLASS flag trade some memory for
+// constant-runtime allocation with any mix of event sizes.
 //
 // The equeue_alloc function returns a pointer to the event's allocated memory
 // and acts as a handle to the underlying event. If there is not enough memory
@@ -156,9 +216,11 @@ void equeue_dealloc(equeue_t *queue, void *event);
 // equeue_event_delay  - Millisecond delay before dispatching an event
 // equeue_event_period - Millisecond period for repeating dispatching an event
 // equeue_event_dtor   - Destructor to run when the event is deallocated
+// equeue_event_affinity - Key serializing events in equeue_dispatch_shared
 void equeue_event_delay(void *event, int ms);
 void equeue_event_period(void *event, int ms);
 void equeue_event_dtor(void *event, void (*dtor)(void *));
+void equeue_event_affinity(void *event, uint16_t key);
 
 // Post an event onto the event queue
 //
@@ -175,6 +175,77 @@ void equeue_alloc_many_prof(int count) {
     equeue_destroy(&q);
 }
 
+void equeue_alloc_mixed_prof(int count) {
+    struct equeue q;
+    equeue_create(&q, count*(EQUEUE_EVENT_SIZE + 32*sizeof(int)));
+
+    void *es[count];
+
+    for (int i = 0; i < count; i++) {
+        es[i] = equeue_alloc(&q, (i % 32) * sizeof(int));
+    }
+
+    for (int i = 0; i < count; i++) {
+        equeue_dealloc(&q, es[i]);
+    }
+
+    prof_loop() {
+        prof_start();
+        void *e = equeue_alloc(&q, 31 * sizeof(int));
+        prof_stop();
+
+        equeue_dealloc(&q, e);
+    }
+
+    equeue_destroy(&q);
+}
+
+void equeue_alloc_sizeclass_prof(void) {
+    struct equeue q;
+    size_t size = 32*EQUEUE_EVENT_SIZE;
+    void *buffer = malloc(size);
+    equeue_create_inplace_flags(&q, size, buffer, EQUEUE_SIZECLASS);
+
+    prof_loop() {
+        prof_start();
+        void *e = equeue_alloc(&q, 8 * sizeof(int));
+        prof_stop();
+
+        equeue_dealloc(&q, e);
+    }
+
+    equeue_destroy(&q);
+    free(buffer);
+}
+
+void equeue_alloc_mixed_sizeclass_prof(int count) {
+    struct equeue q;
+    size_t size = 2*count*(EQUEUE_EVENT_SIZE + 32*sizeof(int));
+    void *buffer = malloc(size);
+    equeue_create_inplace_flags(&q, size, buffer, EQUEUE_SIZECLASS);
+
+    void *es[count];
+
+    for (int i = 0; i < count; i++) {
+        es[i] = equeue_alloc(&q, (i % 32) * sizeof(int));
+    }
+
+    for (int i = 0; i < count; i++) {
+        equeue_dealloc(&q, es[i]);
+    }
+
+    prof_loop() {
+        prof_start();
+        void *e = equeue_alloc(&q, 31 * sizeof(int));
+        prof_stop();
+
+        equeue_dealloc(&q, e);
+    }
+
+    equeue_destroy(&q);
+    free(buffer);
+}
+
 void equeue_post_prof(void) {
     struct equeue q;
     equeue_create(&q, EQUEUE_EVENT_SIZE);
@@ -253,6 +324,47 @@ void equeue_post_future_many_prof(int count) {
     equeue_destroy(&q);
 }
 
+void equeue_post_future_spread_prof(int count) {
+    struct equeue q;
+    equeue_create(&q, count*EQUEUE_EVENT_SIZE);
+
+    for (int i = 0; i < count-1; i++) {
+        equeue_call_in(&q, 1000 + i, no_func, 0);
+    }
+
+    prof_loop() {
+        void *e = equeue_alloc(&q, 0);
+        equeue_event_delay(e, 1000 + count);
+
+        prof_start();
+        int id = equeue_post(&q, no_func, e);
+        prof_stop();
+
+        equeue_cancel(&q, id);
+    }
+
+    equeue_destroy(&q);
+}
+
+void equeue_cancel_future_spread_prof(int count) {
+    struct equeue q;
+    equeue_create(&q, count*EQUEUE_EVENT_SIZE);
+
+    for (int i = 0; i < count-1; i++) {
+        equeue_call_in(&q, 1000 + i, no_func, 0);
+    }
+
+    prof_loop() {
+        int id = equeue_call_in(&q, 1000 + count/2, no_func, 0);
+
+        prof_start();
+        equeue_cancel(&q, id);
+        prof_stop();
+    }
+
+    equeue_destroy(&q);
+}
+
 void equeue_dispatch_prof(void) {
     struct equeue q;
     equeue_create(&q, EQUEUE_EVENT_SIZE);
@@ -379,6 +491,41 @@ void equeue_alloc_fragmented_size_prof(int count) {
     equeue_destroy(&q);
 }
 
+void equeue_alloc_fragmented_sizeclass_size_prof(int count) {
+    size_t size = 2*count*EQUEUE_EVENT_SIZE;
+    void *buffer = malloc(size);
+
+    struct equeue q;
+    equeue_create_inplace_flags(&q, size, buffer, EQUEUE_SIZECLASS);
+
+    void *es[count];
+
+    for (int i = 0; i < count; i++) {
+        es[i] = equeue_alloc(&q, (i % 4) * sizeof(int));
+    }
+
+    for (int i = 0; i < count; i++) {
+        equeue_dealloc(&q, es[i]);
+    }
+
+    for (int i = count-1; i >= 0; i--) {
+        es[i] = equeue_alloc(&q, (i % 4) * sizeof(int));
+    }
+
+    for (int i = count-1; i >= 0; i--) {
+        equeue_dealloc(&q, es[i]);
+    }
+
+    for (int i = 0; i < count; i++) {
+        equeue_alloc(&q, (i % 4) * sizeof(int));
+    }
+
+    prof_result(size - q.slab.size, "bytes");
+
+    equeue_destroy(&q);
+    free(buffer);
+}
+
 
 // Entry point
 int main() {
@@ -393,15 +540,22 @@ int main() {
     prof_measure(equeue_dispatch_prof);
     prof_measure(equeue_cancel_prof);
 
+    prof_measure(equeue_alloc_sizeclass_prof);
+
     prof_measure(equeue_alloc_many_prof, 1000);
+    prof_measure(equeue_alloc_mixed_prof, 1000);
+    prof_measure(equeue_alloc_mixed_sizeclass_prof, 1000);
     prof_measure(equeue_post_many_prof, 1000);
     prof_measure(equeue_post_future_many_prof, 1000);
+    prof_measure(equeue_post_future_spread_prof, 1000);
+    prof_measure(equeue_cancel_future_spread_prof, 1000);
     prof_measure(equeue_dispatch_many_prof, 100);
     prof_measure(equeue_cancel_many_prof, 100);
 
     prof_measure(equeue_alloc_size_prof);
     prof_measure(equeue_alloc_many_size_prof, 1000);
     prof_measure(equeue_alloc_fragmented_size_prof, 1000);
+    prof_measure(equeue_alloc_fragmented_sizeclass_size_prof, 1000);
 
     printf("done!\n");
 }
@@ -615,6 +615,165 @@ void unchain_test(void) {
     equeue_destroy(&q2);
 }
 
+struct order {
+    int *count;
+    int expected;
+};
+
+void order_func(void *p) {
+    struct order *order = (struct order *)p;
+    test_assert(*order->count == order->expected);
+    (*order->count)++;
+}
+
+void order_test(int N) {
+    equeue_t q;
+    int err = equeue_create(&q, 2*N*(EQUEUE_EVENT_SIZE+sizeof(struct order)));
+    test_assert(!err);
+
+    // events with later targets are posted first, events sharing a target
+    // must still dispatch in the order they were posted
+    int count = 0;
+    for (int i = 0; i < N; i++) {
+        struct order *order = equeue_alloc(&q, sizeof(struct order));
+        test_assert(order);
+
+        order->count = &count;
+        order->expected = (N/2-1-i/2)*2 + (i%2);
+        equeue_event_delay(order, 10*(N/2-i/2));
+
+        int id = equeue_post(&q, order_func, order);
+        test_assert(id);
+    }
+
+    equeue_dispatch(&q, 10*(N/2+1));
+    test_assert(count == N);
+
+    equeue_destroy(&q);
+}
+
+// Shared dispatch tests
+struct sworker {
+    pthread_t thread;
+    equeue_t *q;
+    int ms;
+};
+
+static void *sworker_dispatch(void *p) {
+    struct sworker *t = (struct sworker*)p;
+    equeue_dispatch_shared(t->q, t->ms);
+    return 0;
+}
+
+struct shared {
+    pthread_mutex_t lock;
+    int running[3];
+    int count[3];
+    int peak;
+    bool failed;
+};
+
+struct sevent {
+    struct shared *shared;
+    uint16_t key;
+    int expected;
+};
+
+void sevent_func(void *p) {
+    struct sevent *e = (struct sevent *)p;
+    struct shared *s = e->shared;
+
+    pthread_mutex_lock(&s->lock);
+    if (e->key && (s->running[e->key] || s->count[e->key] != e->expected)) {
+        s->failed = true;
+    }
+    s->running[e->key] += 1;
+    int total = s->running[0] + s->running[1] + s->running[2];
+    if (total > s->peak) {
+        s->peak = total;
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    usleep(5000);
+
+    pthread_mutex_lock(&s->lock);
+    s->running[e->key] -= 1;
+    s->count[e->key] += 1;
+    pthread_mutex_unlock(&s->lock);
+}
+
+void shared_dispatch_test(int N) {
+    equeue_t q;
+    int err = equeue_create(&q, 3*N*(EQUEUE_EVENT_SIZE+sizeof(struct sevent)));
+    test_assert(!err);
+
+    struct shared s = {.peak = 0, .failed = false};
+    pthread_mutex_init(&s.lock, 0);
+
+    // interleave events with no key and with two different keys
+    for (int i = 0; i < 3*N; i++) {
+        struct sevent *e = equeue_alloc(&q, sizeof(struct sevent));
+        test_assert(e);
+
+        e->shared = &s;
+        e->key = i % 3;
+        e->expected = i / 3;
+        equeue_event_affinity(e, e->key);
+
+        int id = equeue_post(&q, sevent_func, e);
+        test_assert(id);
+    }
+
+    struct sworker t[4];
+    for (int i = 0; i < 4; i++) {
+        t[i].q = &q;
+        t[i].ms = 5*N*3;
+        err = pthread_create(&t[i].thread, 0, sworker_dispatch, &t[i]);
+        test_assert(!err);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        err = pthread_join(t[i].thread, 0);
+        test_assert(!err);
+    }
+
+    test_assert(!s.failed);
+    test_assert(s.count[0] == N && s.count[1] == N && s.count[2] == N);
+    test_assert(s.peak > 1);
+
+    pthread_mutex_destroy(&s.lock);
+    equeue_destroy(&q);
+}
+
+void shared_break_test(void) {
+    equeue_t q;
+    int err = equeue_create(&q, 2048);
+    test_assert(!err);
+
+    struct sworker t[4];
+    for (int i = 0; i < 4; i++) {
+        t[i].q = &q;
+        t[i].ms = -1;
+        err = pthread_create(&t[i].thread, 0, sworker_dispatch, &t[i]);
+        test_assert(!err);
+    }
+
+    int touched = 0;
+    equeue_call(&q, simple_func, &touched);
+    usleep(10000);
+    equeue_break(&q);
+
+    for (int i = 0; i < 4; i++) {
+        err = pthread_join(t[i].thread, 0);
+        test_assert(!err);
+    }
+
+    test_assert(touched == 1);
+    test_assert(!q.break_requested);
+
+    equeue_destroy(&q);
+}
+
 // Barrage tests
 void simple_barrage_test(int N) {
     equeue_t q;
@@ -707,6 +866,70 @@ void multithreaded_barrage_test(int N) {
     equeue_destroy(&q);
 }
 
+// Allocator tests
+void sizeclass_test(void) {
+    equeue_t q;
+    void *buffer = malloc(2048);
+    int err = equeue_create_inplace_flags(&q, 2048, buffer, EQUEUE_SIZECLASS);
+    test_assert(!err);
+
+    void *es[8];
+    for (int i = 0; i < 8; i++) {
+        es[i] = equeue_alloc(&q, i*sizeof(int));
+        test_assert(es[i]);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        equeue_dealloc(&q, es[i]);
+    }
+
+    // chunks are reused from their own size class
+    for (int i = 7; i >= 0; i--) {
+        void *e = equeue_alloc(&q, i*sizeof(int));
+        test_assert(e == es[i]);
+    }
+
+    void *p = equeue_alloc(&q, 4096);
+    test_assert(!p);
+
+    int touched = 0;
+    int id = equeue_call(&q, simple_func, &touched);
+    test_assert(id);
+    equeue_dispatch(&q, 0);
+    test_assert(touched == 1);
+
+    equeue_destroy(&q);
+    free(buffer);
+}
+
+void sizeclass_barrage_test(int N) {
+    equeue_t q;
+    size_t size = 4*N*(EQUEUE_EVENT_SIZE+sizeof(struct fragment)+N*sizeof(int));
+    void *buffer = malloc(size);
+    int err = equeue_create_inplace_flags(&q, size, buffer, EQUEUE_SIZECLASS);
+    test_assert(!err);
+
+    for (int i = 0; i < N; i++) {
+        size_t size = sizeof(struct fragment) + i*sizeof(int);
+        struct fragment *fragment = equeue_alloc(&q, size);
+        test_assert(fragment);
+
+        fragment->q = &q;
+        fragment->size = size;
+        fragment->timing.tick = equeue_tick();
+        fragment->timing.delay = (i+1)*100;
+        equeue_event_delay(fragment, fragment->timing.delay);
+
+        int id = equeue_post(&q, fragment_func, fragment);
+        test_assert(id);
+    }
+
+    equeue_dispatch(&q, N*100);
+
+    equeue_destroy(&q);
+    free(buffer);
+}
+
 struct count_and_queue
 {
     int p;
@@ -767,10 +990,15 @@ int main() {
     test_run(chain_test);
     test_run(unchain_test);
     test_run(multithread_test);
+    test_run(order_test, 20);
+    test_run(shared_dispatch_test, 10);
+    test_run(shared_break_test);
     test_run(simple_barrage_test, 20);
     test_run(fragmenting_barrage_test, 20);
     test_run(multithreaded_barrage_test, 20);
     test_run(break_request_cleared_on_timeout);
+    test_run(sizeclass_test);
+    test_run(sizeclass_barrage_test, 20);
 
     printf("done!\n");
     return test_failure;
@@ -17,6 +17,7 @@
 #include "nsapi.h"
 #include "mbed_interface.h"
 #include "mbed_assert.h"
+#include "mbed_critical.h"
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
@@ -29,6 +30,7 @@
 #include "lwip/netif.h"
 #include "lwip/dhcp.h"
 #include "lwip/tcpip.h"
+#include "lwip/priv/tcpip_priv.h"
 #include "lwip/tcp.h"
 #include "lwip/ip.h"
 #include "lwip/mld6.h"
@@ -60,6 +62,10 @@ static struct lwip_socket {
     struct netbuf *buf;
     u16_t offset;
 
+    // Receive events not yet matched by a receive, a lower bound on the
+    // number of buffers queued in the netconn's receive mailbox
+    volatile u16_t rx_queued;
+
     void (*cb)(void *);
     void *data;
 
@@ -141,9 +147,17 @@ static void mbed_lwip_socket_callback(struct netconn *nc, enum netconn_evt eh, u
 
     for (int i = 0; i < MEMP_NUM_NETCONN; i++) {
         if (lwip_arena[i].in_use
-            && lwip_arena[i].conn == nc
-            && lwip_arena[i].cb) {
-            lwip_arena[i].cb(lwip_arena[i].data);
+            && lwip_arena[i].conn == nc) {
+            // rx_queued is read by recvmmsg without the lock
+            if (eh == NETCONN_EVT_RCVPLUS) {
+                core_util_atomic_incr_u16(&lwip_arena[i].rx_queued, 1);
+            } else if (eh == NETCONN_EVT_RCVMINUS && lwip_arena[i].rx_queued) {
+                core_util_atomic_decr_u16(&lwip_arena[i].rx_queued, 1);
+            }
+
+            if (lwip_arena[i].cb) {
+                lwip_arena[i].cb(lwip_arena[i].data);
+            }
         }
     }
 
@@ -1168,9 +1182,15 @@ static nsapi_error_t mbed_lwip_socket_connect(nsapi_stack_t *stack, nsapi_socket
         return NSAPI_ERROR_PARAMETER;
     }
 
-    netconn_set_nonblocking(s->conn, false);
-    err_t err = netconn_connect(s->conn, &ip_addr, port);
+    // connect without blocking, the socket callback signals progress and
+    // the caller retries until the connect is done
     netconn_set_nonblocking(s->conn, true);
+    err_t err = netconn_connect(s->conn, &ip_addr, port);
+
+    // a TCP connect that failed in the background leaves no pcb behind
+    if (err == ERR_CLSD && NETCONNTYPE_GROUP(s->conn->type) == NETCONN_TCP) {
+        return NSAPI_ERROR_NO_CONNECTION;
+    }
 
     return mbed_lwip_err_remap(err);
 }
@@ -1290,6 +1310,215 @@ static nsapi_size_or_error_t mbed_lwip_socket_recvfrom(nsapi_stack_t *stack, nsa
     return recv;
 }
 
+static nsapi_size_or_error_t mbed_lwip_socket_recvfrom_buffer(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_addr_t *addr, uint16_t *port, nsapi_buf_t *buffer)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+    struct netbuf *buf;
+
+    err_t err = netconn_recv(s->conn, &buf);
+    if (err != ERR_OK) {
+        return mbed_lwip_err_remap(err);
+    }
+
+    // Lend the pbuf as is when the datagram fits in a single one, which
+    // is the common case; otherwise gather the chain into one pbuf
+    if (buf->p->next) {
+        struct pbuf *p = pbuf_coalesce(buf->p, PBUF_RAW);
+        if (p == buf->p) {
+            netbuf_delete(buf);
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        buf->p = buf->ptr = p;
+    }
+
+    convert_lwip_addr_to_mbed(addr, netbuf_fromaddr(buf));
+    *port = netbuf_fromport(buf);
+
+    buffer->data = buf->p->payload;
+    buffer->size = buf->p->len;
+    buffer->handle = buf;
+
+    return buffer->size;
+}
+
+static nsapi_error_t mbed_lwip_socket_alloc_buffer(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_size_t size, nsapi_buf_t *buffer)
+{
+    if (size > 0xffff) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    struct netbuf *buf = netbuf_new();
+    if (!buf) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    // netbuf_alloc reserves room for the transport and link headers in
+    // front of the payload, so the datagram goes out as a single pbuf
+    void *data = netbuf_alloc(buf, (u16_t)size);
+    if (!data) {
+        netbuf_delete(buf);
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    buffer->data = data;
+    buffer->size = size;
+    buffer->handle = buf;
+
+    return 0;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_sendto_buffer(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_addr_t addr, uint16_t port, nsapi_buf_t *buffer)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+    struct netbuf *buf = (struct netbuf *)buffer->handle;
+    ip_addr_t ip_addr;
+
+    if (!convert_mbed_addr_to_lwip(&ip_addr, &addr)) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    err_t err = netconn_sendto(s->conn, buf, &ip_addr, port);
+    if (err != ERR_OK) {
+        // Headers may have been pushed in front of the payload before the
+        // failure, strip them so the caller gets its buffer back unchanged
+        if (buf->p->payload != buffer->data) {
+            pbuf_header(buf->p, -(s16_t)((u8_t *)buffer->data - (u8_t *)buf->p->payload));
+        }
+
+        return mbed_lwip_err_remap(err);
+    }
+
+    nsapi_size_t size = buffer->size;
+    netbuf_delete(buf);
+    buffer->data = 0;
+    buffer->size = 0;
+    buffer->handle = 0;
+
+    return size;
+}
+
+static void mbed_lwip_socket_free_buffer(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_buf_t *buffer)
+{
+    netbuf_delete((struct netbuf *)buffer->handle);
+    buffer->data = 0;
+    buffer->size = 0;
+    buffer->handle = 0;
+}
+
+struct mbed_lwip_sendmmsg_call {
+    struct tcpip_api_call_data call;
+    struct lwip_socket *s;
+    nsapi_mmsg_t *msgs;
+    unsigned count;
+    unsigned sent;
+};
+
+static err_t mbed_lwip_do_sendmmsg(struct tcpip_api_call_data *call)
+{
+    struct mbed_lwip_sendmmsg_call *c = (struct mbed_lwip_sendmmsg_call *)call;
+    struct netconn *conn = c->s->conn;
+
+    if (ERR_IS_FATAL(conn->last_err)) {
+        return conn->last_err;
+    }
+
+    if (!conn->pcb.udp) {
+        return ERR_CONN;
+    }
+
+    // Runs with the tcpip core, so the datagrams go straight to the pcb
+    // instead of each one making its own netconn round trip
+    for (; c->sent < c->count; c->sent++) {
+        nsapi_mmsg_t *msg = &c->msgs[c->sent];
+        ip_addr_t ip_addr;
+
+        if (msg->size > 0xffff || !convert_mbed_addr_to_lwip(&ip_addr, &msg->addr)) {
+            return ERR_ARG;
+        }
+
+        struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, 0, PBUF_REF);
+        if (!p) {
+            return ERR_MEM;
+        }
+
+        p->payload = msg->data;
+        p->len = p->tot_len = (u16_t)msg->size;
+
+        err_t err;
+        if (ip_addr_isany_val(ip_addr)) {
+            err = udp_send(conn->pcb.udp, p);
+        } else {
+            err = udp_sendto(conn->pcb.udp, p, &ip_addr, msg->port);
+        }
+        pbuf_free(p);
+
+        if (err != ERR_OK) {
+            return err;
+        }
+
+        msg->len = msg->size;
+    }
+
+    return ERR_OK;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_sendmmsg(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_mmsg_t *msgs, unsigned count)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+
+    if (NETCONNTYPE_GROUP(s->conn->type) != NETCONN_UDP) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    struct mbed_lwip_sendmmsg_call c;
+    c.s = s;
+    c.msgs = msgs;
+    c.count = count;
+    c.sent = 0;
+
+    // One call into the tcpip thread for the whole batch
+    err_t err = tcpip_api_call(mbed_lwip_do_sendmmsg, &c.call);
+    if (err != ERR_OK && c.sent == 0) {
+        return mbed_lwip_err_remap(err);
+    }
+
+    return c.sent;
+}
+
+static nsapi_size_or_error_t mbed_lwip_socket_recvmmsg(nsapi_stack_t *stack, nsapi_socket_t handle, nsapi_mmsg_t *msgs, unsigned count)
+{
+    struct lwip_socket *s = (struct lwip_socket *)handle;
+    unsigned recv = 0;
+
+    while (recv < count) {
+        // Only the first receive may wait on the mailbox, after that stop
+        // as soon as nothing more is known to be queued
+        if (recv > 0 && !s->rx_queued) {
+            break;
+        }
+
+        struct netbuf *buf;
+        err_t err = netconn_recv(s->conn, &buf);
+        if (err != ERR_OK) {
+            if (recv == 0) {
+                return mbed_lwip_err_remap(err);
+            }
+            break;
+        }
+
+        nsapi_mmsg_t *msg = &msgs[recv];
+        convert_lwip_addr_to_mbed(&msg->addr, netbuf_fromaddr(buf));
+        msg->port = netbuf_fromport(buf);
+        msg->len = netbuf_copy(buf, msg->data, (u16_t)msg->size);
+        netbuf_delete(buf);
+
+        recv += 1;
+    }
+
+    return recv;
+}
+
 static int32_t find_multicast_member(const struct lwip_socket *s, const nsapi_ip_mreq_t *imr) {
     uint32_t count = 0;
     uint32_t index = 0;
@@ -1477,6 +1706,12 @@ const nsapi_stack_api_t lwip_stack_api = {
     .socket_recvfrom    = mbed_lwip_socket_recvfrom,
     .setsockopt         = mbed_lwip_setsockopt,
     .socket_attach      = mbed_lwip_socket_attach,
+    .socket_recvfrom_buffer = mbed_lwip_socket_recvfrom_buffer,
+    .socket_alloc_buffer    = mbed_lwip_socket_alloc_buffer,
+    .socket_sendto_buffer   = mbed_lwip_socket_sendto_buffer,
+    .socket_free_buffer     = mbed_lwip_socket_free_buffer,
+    .socket_sendmmsg        = mbed_lwip_socket_sendmmsg,
+    .socket_recvmmsg        = mbed_lwip_socket_recvmmsg,
 };
 
 nsapi_stack_t lwip_stack = {
@@ -19,6 +19,7 @@
 #include "utest.h"
 
 #include "HeapBlockDevice.h"
+#include "ProfilingBlockDevice.h"
 #include "FATFileSystem.h"
 #include <stdlib.h>
 #include "mbed_retarget.h"
@@ -146,9 +147,155 @@ void test_read_dir() {
 }
 
 
+// Test for interleaved file accesses on two volumes
+#define INTERLEAVED_SIZE (4*BLOCK_SIZE)
+
+void test_interleaved_worker(FATFileSystem *fs) {
+    uint8_t buffer[16];
+
+    // Write two files a piece at a time, so they share any sector buffer
+    File files[2];
+    int err = files[0].open(fs, "test_interleaved_0", O_WRONLY | O_CREAT);
+    TEST_ASSERT_EQUAL(0, err);
+    err = files[1].open(fs, "test_interleaved_1", O_WRONLY | O_CREAT);
+    TEST_ASSERT_EQUAL(0, err);
+
+    for (int i = 0; i < INTERLEAVED_SIZE; i += sizeof(buffer)) {
+        for (int f = 0; f < 2; f++) {
+            memset(buffer, 0xff & (i / sizeof(buffer) + f), sizeof(buffer));
+            ssize_t size = files[f].write(buffer, sizeof(buffer));
+            TEST_ASSERT_EQUAL(sizeof(buffer), size);
+        }
+    }
+
+    for (int f = 0; f < 2; f++) {
+        err = files[f].close();
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    err = files[0].open(fs, "test_interleaved_0", O_RDONLY);
+    TEST_ASSERT_EQUAL(0, err);
+    err = files[1].open(fs, "test_interleaved_1", O_RDONLY);
+    TEST_ASSERT_EQUAL(0, err);
+
+    for (int i = 0; i < INTERLEAVED_SIZE; i += sizeof(buffer)) {
+        for (int f = 0; f < 2; f++) {
+            ssize_t size = files[f].read(buffer, sizeof(buffer));
+            TEST_ASSERT_EQUAL(sizeof(buffer), size);
+            TEST_ASSERT_EQUAL(0xff & (i / sizeof(buffer) + f), buffer[sizeof(buffer) - 1]);
+        }
+    }
+
+    for (int f = 0; f < 2; f++) {
+        err = files[f].close();
+        TEST_ASSERT_EQUAL(0, err);
+    }
+}
+
+void test_interleaved() {
+    HeapBlockDevice bd2(128*BLOCK_SIZE, BLOCK_SIZE);
+    FATFileSystem fs("fat");
+    FATFileSystem fs2("fat2");
+
+    int err = FATFileSystem::format(&bd2);
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = fs.mount(&bd);
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs2.mount(&bd2);
+    TEST_ASSERT_EQUAL(0, err);
+
+#ifdef MBED_CONF_RTOS_PRESENT
+    // Volumes are locked separately, so each can be used from its own thread
+    Thread thread;
+    thread.start(callback(test_interleaved_worker, &fs2));
+    test_interleaved_worker(&fs);
+    thread.join();
+#else
+    test_interleaved_worker(&fs);
+    test_interleaved_worker(&fs2);
+#endif
+
+    err = fs.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs2.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
+// Benchmark of random reads as files grow, which follow the FAT chain
+// from the start of the file unless fast seek keeps a cluster link map
+#define RANDOM_READ_COUNT 64
+
+void test_random_read() {
+    HeapBlockDevice heap(256*BLOCK_SIZE, BLOCK_SIZE);
+    ProfilingBlockDevice profiler(&heap);
+    FATFileSystem fs("fat");
+
+    // Smallest clusters give the longest chains
+    int err = FATFileSystem::format(&profiler, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs.mount(&profiler);
+    TEST_ASSERT_EQUAL(0, err);
+
+    uint8_t buffer[16];
+    srand(1);
+
+    for (off_t file_size = 4*BLOCK_SIZE; file_size <= 64*BLOCK_SIZE; file_size *= 2) {
+        File file;
+        err = file.open(&fs, "test_random_read", O_RDWR | O_CREAT | O_TRUNC);
+        TEST_ASSERT_EQUAL(0, err);
+
+        for (off_t i = 0; i < file_size; i += sizeof(buffer)) {
+            memset(buffer, 0xff & (i / sizeof(buffer)), sizeof(buffer));
+            ssize_t size = file.write(buffer, sizeof(buffer));
+            TEST_ASSERT_EQUAL(sizeof(buffer), size);
+        }
+
+        profiler.reset();
+        Timer timer;
+        timer.start();
+
+        for (int i = 0; i < RANDOM_READ_COUNT; i++) {
+            off_t offset = (rand() % (file_size / sizeof(buffer))) * sizeof(buffer);
+            off_t res = file.seek(offset, SEEK_SET);
+            TEST_ASSERT_EQUAL(offset, res);
+            ssize_t size = file.read(buffer, sizeof(buffer));
+            TEST_ASSERT_EQUAL(sizeof(buffer), size);
+            TEST_ASSERT_EQUAL(0xff & (offset / sizeof(buffer)), buffer[0]);
+        }
+
+        timer.stop();
+        printf("file size: %6ld, us/read: %4d, bytes read/read: %4lld\n",
+                (long)file_size, timer.read_us() / RANDOM_READ_COUNT,
+                profiler.get_read_count() / RANDOM_READ_COUNT);
+
+        // Appending must still work after seeking within the file
+        off_t res = file.seek(0, SEEK_END);
+        TEST_ASSERT_EQUAL(file_size, res);
+        memset(buffer, 0xaa, sizeof(buffer));
+        ssize_t size = file.write(buffer, sizeof(buffer));
+        TEST_ASSERT_EQUAL(sizeof(buffer), size);
+        res = file.seek(file_size, SEEK_SET);
+        TEST_ASSERT_EQUAL(file_size, res);
+        size = file.read(buffer, sizeof(buffer));
+        TEST_ASSERT_EQUAL(sizeof(buffer), size);
+        TEST_ASSERT_EQUAL(0xaa, buffer[sizeof(buffer) - 1]);
+
+        err = file.close();
+        TEST_ASSERT_EQUAL(0, err);
+    }
+
+    err = fs.remove("test_random_read");
+    TEST_ASSERT_EQUAL(0, err);
+    err = fs.unmount();
+    TEST_ASSERT_EQUAL(0, err);
+}
+
+
 // Test setup
 utest::v1::status_t test_setup(const size_t number_of_cases) {
-    GREENTEA_SETUP(10, "default_auto");
+    GREENTEA_SETUP(20, "default_auto");
     return verbose_test_setup_handler(number_of_cases);
 }
 
@@ -157,6 +304,8 @@ Case cases[] = {
     Case("Testing read write < block", test_read_write<BLOCK_SIZE/2>),
     Case("Testing read write > block", test_read_write<2*BLOCK_SIZE>),
     Case("Testing dir iteration", test_read_dir),
+    Case("Testing interleaved files on two volumes", test_interleaved),
+    Case("Benchmarking random reads", test_random_read),
 };
 
 Specification specification(test_setup, cases);
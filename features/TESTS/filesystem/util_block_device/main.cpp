@@ -22,6 +22,7 @@
 #include "SlicingBlockDevice.h"
 #include "ChainingBlockDevice.h"
 #include "ProfilingBlockDevice.h"
+#include "CachingBlockDevice.h"
 #include <stdlib.h>
 
 using namespace utest::v1;
@@ -191,7 +192,7 @@ void test_profiling() {
     uint8_t *read_block = new uint8_t[BLOCK_SIZE];
 
     // Test under profiling
-    ProfilingBlockDevice profiler(&bd);
+    ProfilingBlockDevice profiler(&bd, BLOCK_COUNT/2, 4);
 
     int err = profiler.init();
     TEST_ASSERT_EQUAL(0, err);
@@ -243,6 +244,100 @@ void test_profiling() {
     TEST_ASSERT_EQUAL(BLOCK_SIZE, program_count);
     bd_size_t erase_count = profiler.get_erase_count();
     TEST_ASSERT_EQUAL(BLOCK_SIZE, erase_count);
+
+    // Check that each operation was timed once
+    for (int op = 0; op < ProfilingBlockDevice::OpCnt; op++) {
+        uint32_t latency_count = 0;
+        for (int i = 0; i < ProfilingBlockDevice::LatencyBuckets; i++) {
+            latency_count += profiler.get_latency_count((ProfilingBlockDevice::OpType)op, i);
+        }
+        TEST_ASSERT_EQUAL(1, latency_count);
+    }
+
+    // Check that operations were counted in the first region only
+    TEST_ASSERT_EQUAL(2*BLOCK_SIZE, profiler.get_region_size());
+    TEST_ASSERT_EQUAL(1, profiler.get_region_count(ProfilingBlockDevice::EraseOp, 0));
+    TEST_ASSERT_EQUAL(1, profiler.get_region_count(ProfilingBlockDevice::ReadOp, 0));
+    TEST_ASSERT_EQUAL(0, profiler.get_region_count(ProfilingBlockDevice::ReadOp, 2*BLOCK_SIZE));
+
+    // Check that the trace recorded operations in order
+    TEST_ASSERT_EQUAL(3, profiler.get_trace_count());
+    TEST_ASSERT_EQUAL(ProfilingBlockDevice::EraseOp, profiler.get_trace_entry(0).op);
+    TEST_ASSERT_EQUAL(ProfilingBlockDevice::ProgramOp, profiler.get_trace_entry(1).op);
+    TEST_ASSERT_EQUAL(ProfilingBlockDevice::ReadOp, profiler.get_trace_entry(2).op);
+    TEST_ASSERT_EQUAL(BLOCK_SIZE, profiler.get_trace_entry(2).size);
+}
+
+// Simple test which read/writes blocks through a cache
+void test_caching() {
+    HeapBlockDevice bd(BLOCK_COUNT*BLOCK_SIZE, BLOCK_SIZE);
+    uint8_t *write_block = new uint8_t[BLOCK_SIZE];
+    uint8_t *read_block = new uint8_t[BLOCK_SIZE];
+
+    // Profile the operations reaching the original block device
+    ProfilingBlockDevice profiler(&bd);
+    CachingBlockDevice cache(&profiler, 2, BLOCK_SIZE, true);
+
+    int err = cache.init();
+    TEST_ASSERT_EQUAL(0, err);
+
+    TEST_ASSERT_EQUAL(BLOCK_SIZE, cache.get_program_size());
+    TEST_ASSERT_EQUAL(BLOCK_COUNT*BLOCK_SIZE, cache.size());
+
+    // Fill with random sequence
+    srand(1);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        write_block[i] = 0xff & rand();
+    }
+
+    // Program is kept in the cache until sync
+    err = cache.erase(0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+
+    err = cache.program(write_block, 0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(0, profiler.get_program_count());
+
+    err = cache.read(read_block, 0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(0, profiler.get_read_count());
+
+    err = cache.sync();
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(BLOCK_SIZE, profiler.get_program_count());
+
+    // Check with original block device
+    err = bd.read(read_block, 0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+
+    // Check that the data was unmodified
+    srand(1);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        TEST_ASSERT_EQUAL(0xff & rand(), read_block[i]);
+    }
+
+    // Repeated reads are served from the cache, until the line is replaced
+    cache.reset();
+    for (int i = 0; i < 4; i++) {
+        err = cache.read(read_block, BLOCK_SIZE, BLOCK_SIZE);
+        TEST_ASSERT_EQUAL(0, err);
+    }
+    err = cache.read(read_block, 2*BLOCK_SIZE, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    err = cache.read(read_block, 0, BLOCK_SIZE);
+    TEST_ASSERT_EQUAL(0, err);
+    TEST_ASSERT_EQUAL(3, cache.get_hit_count());
+    TEST_ASSERT_EQUAL(3, cache.get_miss_count());
+
+    srand(1);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        TEST_ASSERT_EQUAL(0xff & rand(), read_block[i]);
+    }
+
+    delete[] write_block;
+    delete[] read_block;
+    err = cache.deinit();
+    TEST_ASSERT_EQUAL(0, err);
 }
 
 
@@ -256,6 +351,7 @@ Case cases[] = {
     Case("Testing slicing of a block device", test_slicing),
     Case("Testing chaining of block devices", test_chaining),
     Case("Testing profiling of block devices", test_profiling),
+    Case("Testing caching of block devices", test_caching),
 };
 
 Specification specification(test_setup, cases);
@@ -85,6 +85,22 @@ public:
      */
     virtual ssize_t write(const void *buffer, size_t size);
 
+    /** Read the contents of a file into a list of buffers
+     *
+     *  @param iov      Array of buffers to read in to
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         The number of bytes read, 0 at end of file, negative error on failure
+     */
+    virtual ssize_t readv(const struct iovec *iov, int iovcnt);
+
+    /** Write the contents of a list of buffers to a file
+     *
+     *  @param iov      Array of buffers to write from
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         The number of bytes written, negative error on failure
+     */
+    virtual ssize_t writev(const struct iovec *iov, int iovcnt);
+
     /** Flush any buffers associated with the file
      *
      *  @return         0 on success, negative error code on failure
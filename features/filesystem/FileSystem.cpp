@@ -56,6 +56,38 @@ int FileSystem::statvfs(const char *path, struct statvfs *buf)
     return -ENOSYS;
 }
 
+ssize_t FileSystem::file_readv(fs_file_t file, const struct iovec *iov, int iovcnt)
+{
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        ssize_t res = file_read(file, iov[i].iov_base, iov[i].iov_len);
+        if (res < 0) {
+            return total ? total : res;
+        }
+        total += res;
+        if ((size_t)res < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+ssize_t FileSystem::file_writev(fs_file_t file, const struct iovec *iov, int iovcnt)
+{
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        ssize_t res = file_write(file, iov[i].iov_base, iov[i].iov_len);
+        if (res < 0) {
+            return total ? total : res;
+        }
+        total += res;
+        if ((size_t)res < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
 int FileSystem::file_sync(fs_file_t file)
 {
     return 0;
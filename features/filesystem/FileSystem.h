@@ -156,6 +156,24 @@ protected:
      */
     virtual ssize_t file_write(fs_file_t file, const void *buffer, size_t size) = 0;
 
+    /** Read the contents of a file into a list of buffers
+     *
+     *  @param file     File handle
+     *  @param iov      Array of buffers to read in to
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         The number of bytes read, 0 at end of file, negative error on failure
+     */
+    virtual ssize_t file_readv(fs_file_t file, const struct iovec *iov, int iovcnt);
+
+    /** Write the contents of a list of buffers to a file
+     *
+     *  @param file     File handle
+     *  @param iov      Array of buffers to write from
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         The number of bytes written, negative error on failure
+     */
+    virtual ssize_t file_writev(fs_file_t file, const struct iovec *iov, int iovcnt);
+
     /** Flush any buffers associated with the file
      *
      *  @param file     File handle
@@ -0,0 +1,362 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CachingBlockDevice.h"
+#include <algorithm>
+
+
+CachingBlockDevice::CachingBlockDevice(BlockDevice *bd, size_t line_count,
+        bd_size_t line_size, bool write_back)
+    : _bd(bd)
+    , _line_count(line_count)
+    , _line_size(line_size)
+    , _write_back(write_back)
+    , _lines(0)
+    , _buffer(0)
+    , _use_count(0)
+    , _hit_count(0)
+    , _miss_count(0)
+{
+    MBED_ASSERT(line_count > 0);
+}
+
+CachingBlockDevice::~CachingBlockDevice()
+{
+    delete[] _lines;
+    delete[] _buffer;
+}
+
+int CachingBlockDevice::init()
+{
+    int err = _bd->init();
+    if (err) {
+        return err;
+    }
+
+    // Line size can only be checked once the block device knows its block sizes
+    if (!_line_size) {
+        _line_size = _bd->get_program_size();
+    }
+    MBED_ASSERT(_line_size % _bd->get_program_size() == 0);
+    MBED_ASSERT(_bd->get_erase_size() % _line_size == 0);
+
+    delete[] _lines;
+    delete[] _buffer;
+    _lines = new cache_line[_line_count];
+    _buffer = new uint8_t[_line_count * _line_size];
+    for (size_t i = 0; i < _line_count; i++) {
+        _lines[i].valid = false;
+        _lines[i].dirty_start = 0;
+        _lines[i].dirty_end = 0;
+    }
+
+    return 0;
+}
+
+int CachingBlockDevice::deinit()
+{
+    int err = flush_all();
+    if (err) {
+        return err;
+    }
+
+    delete[] _lines;
+    delete[] _buffer;
+    _lines = 0;
+    _buffer = 0;
+
+    return _bd->deinit();
+}
+
+int CachingBlockDevice::sync()
+{
+    int err = flush_all();
+    if (err) {
+        return err;
+    }
+
+    return _bd->sync();
+}
+
+int CachingBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_read(addr, size));
+    uint8_t *buffer = static_cast<uint8_t*>(b);
+
+    while (size > 0) {
+        bd_addr_t line_addr = addr - addr % _line_size;
+        bd_size_t offset = addr - line_addr;
+        bd_size_t chunk = std::min(_line_size - offset, size);
+
+        cache_line *line = find(line_addr);
+        if (line) {
+            _hit_count++;
+        } else if (size > _line_count * _line_size) {
+            // Reads larger than the whole cache would just evict it, so read
+            // the lines missing from the cache directly
+            while (chunk < size && !find(addr + chunk)) {
+                chunk += std::min(_line_size, size - chunk);
+                _miss_count++;
+            }
+            _miss_count++;
+
+            int err = _bd->read(buffer, addr, chunk);
+            if (err) {
+                return err;
+            }
+
+            buffer += chunk;
+            addr += chunk;
+            size -= chunk;
+            continue;
+        } else {
+            _miss_count++;
+            int err = replace(line_addr, true, line);
+            if (err) {
+                return err;
+            }
+        }
+
+        memcpy(buffer, line_data(line) + offset, chunk);
+        line->used = ++_use_count;
+
+        buffer += chunk;
+        addr += chunk;
+        size -= chunk;
+    }
+
+    return 0;
+}
+
+int CachingBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_program(addr, size));
+    const uint8_t *buffer = static_cast<const uint8_t*>(b);
+
+    if (!_write_back) {
+        int err = _bd->program(buffer, addr, size);
+        if (err) {
+            return err;
+        }
+    }
+
+    while (size > 0) {
+        bd_addr_t line_addr = addr - addr % _line_size;
+        uint32_t offset = addr - line_addr;
+        uint32_t chunk = std::min(_line_size - offset, size);
+
+        cache_line *line = find(line_addr);
+        if (_write_back) {
+            if (!line) {
+                // Rest of the line must be known, to serve reads of it
+                int err = replace(line_addr, chunk != _line_size, line);
+                if (err) {
+                    return err;
+                }
+            } else if (line->dirty_end > line->dirty_start &&
+                    offset != line->dirty_end && offset + chunk != line->dirty_start) {
+                // Only a contiguous range is kept per line
+                int err = flush(line);
+                if (err) {
+                    return err;
+                }
+            }
+
+            if (line->dirty_end > line->dirty_start) {
+                line->dirty_start = std::min(line->dirty_start, offset);
+                line->dirty_end = std::max(line->dirty_end, offset + chunk);
+            } else {
+                line->dirty_start = offset;
+                line->dirty_end = offset + chunk;
+            }
+            line->used = ++_use_count;
+        }
+
+        if (line) {
+            memcpy(line_data(line) + offset, buffer, chunk);
+        }
+
+        buffer += chunk;
+        addr += chunk;
+        size -= chunk;
+    }
+
+    return 0;
+}
+
+int CachingBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+
+    // Pending programs of erased blocks are lost anyway
+    invalidate(addr, size);
+    return _bd->erase(addr, size);
+}
+
+int CachingBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(is_valid_erase(addr, size));
+
+    invalidate(addr, size);
+    return _bd->trim(addr, size);
+}
+
+bd_size_t CachingBlockDevice::get_read_size() const
+{
+    return _bd->get_read_size();
+}
+
+bd_size_t CachingBlockDevice::get_program_size() const
+{
+    return _bd->get_program_size();
+}
+
+bd_size_t CachingBlockDevice::get_erase_size() const
+{
+    return _bd->get_erase_size();
+}
+
+bd_size_t CachingBlockDevice::get_erase_size(bd_addr_t addr) const
+{
+    return _bd->get_erase_size(addr);
+}
+
+int CachingBlockDevice::get_erase_value() const
+{
+    return _bd->get_erase_value();
+}
+
+bd_size_t CachingBlockDevice::size() const
+{
+    return _bd->size();
+}
+
+void CachingBlockDevice::reset()
+{
+    _hit_count = 0;
+    _miss_count = 0;
+}
+
+bd_size_t CachingBlockDevice::get_hit_count() const
+{
+    return _hit_count;
+}
+
+bd_size_t CachingBlockDevice::get_miss_count() const
+{
+    return _miss_count;
+}
+
+CachingBlockDevice::cache_line *CachingBlockDevice::find(bd_addr_t addr)
+{
+    for (size_t i = 0; i < _line_count; i++) {
+        if (_lines[i].valid && _lines[i].addr == addr) {
+            return &_lines[i];
+        }
+    }
+
+    return 0;
+}
+
+int CachingBlockDevice::replace(bd_addr_t addr, bool fill, cache_line *&line)
+{
+    // Use a free line if any, otherwise the least recently used one
+    line = &_lines[0];
+    for (size_t i = 0; i < _line_count && line->valid; i++) {
+        if (!_lines[i].valid ||
+                (uint32_t)(_use_count - _lines[i].used) > (uint32_t)(_use_count - line->used)) {
+            line = &_lines[i];
+        }
+    }
+
+    if (line->valid) {
+        int err = flush(line);
+        if (err) {
+            return err;
+        }
+        line->valid = false;
+    }
+
+    if (fill) {
+        int err = _bd->read(line_data(line), addr, _line_size);
+        if (err) {
+            return err;
+        }
+    }
+
+    line->addr = addr;
+    line->valid = true;
+    return 0;
+}
+
+uint8_t *CachingBlockDevice::line_data(const cache_line *line) const
+{
+    return &_buffer[(line - _lines) * _line_size];
+}
+
+int CachingBlockDevice::flush(cache_line *line)
+{
+    if (line->dirty_end > line->dirty_start) {
+        int err = _bd->program(line_data(line) + line->dirty_start,
+                line->addr + line->dirty_start, line->dirty_end - line->dirty_start);
+        if (err) {
+            return err;
+        }
+    }
+
+    line->dirty_start = 0;
+    line->dirty_end = 0;
+    return 0;
+}
+
+int CachingBlockDevice::flush_all()
+{
+    if (!_lines) {
+        return 0;
+    }
+
+    // Program least recently used lines first, as they were programmed
+    // earlier than more recently used ones
+    while (true) {
+        cache_line *first = 0;
+        for (size_t i = 0; i < _line_count; i++) {
+            if (_lines[i].dirty_end > _lines[i].dirty_start && (!first ||
+                    (uint32_t)(_use_count - _lines[i].used) > (uint32_t)(_use_count - first->used))) {
+                first = &_lines[i];
+            }
+        }
+
+        if (!first) {
+            return 0;
+        }
+
+        int err = flush(first);
+        if (err) {
+            return err;
+        }
+    }
+}
+
+void CachingBlockDevice::invalidate(bd_addr_t addr, bd_size_t size)
+{
+    for (size_t i = 0; i < _line_count; i++) {
+        if (_lines[i].valid && _lines[i].addr >= addr && _lines[i].addr < addr + size) {
+            _lines[i].valid = false;
+            _lines[i].dirty_start = 0;
+            _lines[i].dirty_end = 0;
+        }
+    }
+}
@@ -0,0 +1,217 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2017 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MBED_CACHING_BLOCK_DEVICE_H
+#define MBED_CACHING_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+#include "mbed.h"
+
+
+/** Block device for caching reads of another block device
+ *
+ *  Data is cached in a fixed number of lines, each holding an aligned
+ *  line of the underlying block device. When all lines are in use, the
+ *  least recently used one is replaced.
+ *
+ *  In write-back mode, programs are also kept in the cache, and only
+ *  programmed to the underlying block device when their line is replaced
+ *  or on sync.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "HeapBlockDevice.h"
+ *  #include "CachingBlockDevice.h"
+ *
+ *  // Create a heap block device and cache it in 8 lines of 512 bytes
+ *  HeapBlockDevice mem(64*512, 512);
+ *  CachingBlockDevice cache(&mem, 8);
+ *
+ *  // do block device work....
+ *
+ *  printf("hit count: %lld\n", cache.get_hit_count());
+ *  printf("miss count: %lld\n", cache.get_miss_count());
+ *  @endcode
+ */
+class CachingBlockDevice : public BlockDevice
+{
+public:
+    /** Lifetime of the caching block device
+     *
+     *  @param bd           Block device to back the CachingBlockDevice
+     *  @param line_count   Number of cache lines
+     *  @param line_size    Size of a cache line in bytes, must be a multiple of
+     *                      the program size and a divisor of the erase size,
+     *                      defaults to the program size
+     *  @param write_back   Keep programs in the cache until sync, instead of
+     *                      programming them immediately
+     */
+    CachingBlockDevice(BlockDevice *bd, size_t line_count,
+            bd_size_t line_size = 0, bool write_back = false);
+
+    /** Lifetime of a block device
+     */
+    virtual ~CachingBlockDevice();
+
+    /** Initialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int init();
+
+    /** Deinitialize a block device
+     *
+     *  @return         0 on success or a negative error code on failure
+     *  @note Programs kept in the cache are written before deinitializing
+     */
+    virtual int deinit();
+
+    /** Ensure data on storage is in sync with the driver
+     *
+     *  @return         0 on success or a negative error code on failure
+     */
+    virtual int sync();
+
+    /** Read blocks from a block device
+     *
+     *  @param buffer   Buffer to read blocks into
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Program blocks to a block device
+     *
+     *  The blocks must have been erased prior to being programmed
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Erase blocks on a block device
+     *
+     *  The state of an erased block is undefined until it has been programmed,
+     *  unless get_erase_value returns a non-negative byte value
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+
+    /** Mark blocks as no longer in use
+     *
+     *  @param addr     Address of block to mark as unused
+     *  @param size     Size to mark as unused in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int trim(bd_addr_t addr, bd_size_t size);
+
+    /** Get the size of a readable block
+     *
+     *  @return         Size of a readable block in bytes
+     */
+    virtual bd_size_t get_read_size() const;
+
+    /** Get the size of a programmable block
+     *
+     *  @return         Size of a programmable block in bytes
+     *  @note Must be a multiple of the read size
+     */
+    virtual bd_size_t get_program_size() const;
+
+    /** Get the size of an erasable block
+     *
+     *  @return         Size of an erasable block in bytes
+     *  @note Must be a multiple of the program size
+     */
+    virtual bd_size_t get_erase_size() const;
+
+    /** Get the size of an erasable block given address
+     *
+     *  @param addr     Address within the erasable block
+     *  @return         Size of an erasable block in bytes
+     *  @note Must be a multiple of the program size
+     */
+    virtual bd_size_t get_erase_size(bd_addr_t addr) const;
+
+    /** Get the value of storage when erased
+     *
+     *  @return         The value of storage when erased, or -1 if you can't
+     *                  rely on the value of erased storage
+     */
+    virtual int get_erase_value() const;
+
+    /** Get the total size of the underlying device
+     *
+     *  @return         Size of the underlying device in bytes
+     */
+    virtual bd_size_t size() const;
+
+    /** Reset the hit and miss counts to zero
+     */
+    void reset();
+
+    /** Get number of reads of a cache line that found the line in the cache
+     *
+     *  @return The number of cache hits
+     */
+    bd_size_t get_hit_count() const;
+
+    /** Get number of reads of a cache line that read the line from the block device
+     *
+     *  @return The number of cache misses
+     */
+    bd_size_t get_miss_count() const;
+
+private:
+    struct cache_line {
+        bd_addr_t addr;
+        uint32_t used;
+        uint32_t dirty_start;
+        uint32_t dirty_end;
+        bool valid;
+    };
+
+    cache_line *find(bd_addr_t addr);
+    int replace(bd_addr_t addr, bool fill, cache_line *&line);
+    uint8_t *line_data(const cache_line *line) const;
+    int flush(cache_line *line);
+    int flush_all();
+    void invalidate(bd_addr_t addr, bd_size_t size);
+
+    BlockDevice *_bd;
+    size_t _line_count;
+    bd_size_t _line_size;
+    bool _write_back;
+    cache_line *_lines;
+    uint8_t *_buffer;
+    uint32_t _use_count;
+    bd_size_t _hit_count;
+    bd_size_t _miss_count;
+};
+
+
+#endif
@@ -17,17 +17,49 @@
 #include "ProfilingBlockDevice.h"
 
 
-ProfilingBlockDevice::ProfilingBlockDevice(BlockDevice *bd)
+ProfilingBlockDevice::ProfilingBlockDevice(BlockDevice *bd, size_t heatmap_regions, size_t trace_size)
     : _bd(bd)
     , _read_count(0)
     , _program_count(0)
     , _erase_count(0)
+    , _ticker_data(get_us_ticker_data())
+    , _region_count(heatmap_regions)
+    , _region_size(0)
+    , _region_counts(0)
+    , _trace_size(trace_size)
+    , _trace_count(0)
+    , _trace(0)
 {
+    if (_region_count) {
+        _region_counts = new uint32_t[_region_count * OpCnt];
+    }
+    if (_trace_size) {
+        _trace = new trace_entry[_trace_size];
+    }
+    reset();
+}
+
+ProfilingBlockDevice::~ProfilingBlockDevice()
+{
+    delete[] _region_counts;
+    delete[] _trace;
 }
 
 int ProfilingBlockDevice::init()
 {
-    return _bd->init();
+    int err = _bd->init();
+    if (err) {
+        return err;
+    }
+
+    // Split the block device into regions of whole erase blocks
+    if (_region_count) {
+        bd_size_t erase_size = _bd->get_erase_size();
+        bd_size_t blocks = (_bd->size() + erase_size - 1) / erase_size;
+        _region_size = ((blocks + _region_count - 1) / _region_count) * erase_size;
+    }
+
+    return 0;
 }
 
 int ProfilingBlockDevice::deinit()
@@ -42,27 +74,33 @@ int ProfilingBlockDevice::sync()
 
 int ProfilingBlockDevice::read(void *b, bd_addr_t addr, bd_size_t size)
 {
+    uint32_t start = ticker_read(_ticker_data);
     int err = _bd->read(b, addr, size);
     if (!err) {
         _read_count += size;
+        record(ReadOp, addr, size, ticker_read(_ticker_data) - start);
     }
     return err;
 }
 
 int ProfilingBlockDevice::program(const void *b, bd_addr_t addr, bd_size_t size)
 {
+    uint32_t start = ticker_read(_ticker_data);
     int err = _bd->program(b, addr, size);
     if (!err) {
         _program_count += size;
+        record(ProgramOp, addr, size, ticker_read(_ticker_data) - start);
     }
     return err;
 }
 
 int ProfilingBlockDevice::erase(bd_addr_t addr, bd_size_t size)
 {
+    uint32_t start = ticker_read(_ticker_data);
     int err = _bd->erase(addr, size);
     if (!err) {
         _erase_count += size;
+        record(EraseOp, addr, size, ticker_read(_ticker_data) - start);
     }
     return err;
 }
@@ -102,6 +140,12 @@ void ProfilingBlockDevice::reset()
     _read_count = 0;
     _program_count = 0;
     _erase_count = 0;
+    memset(_latency_counts, 0, sizeof(_latency_counts));
+    memset(_max_latency, 0, sizeof(_max_latency));
+    if (_region_counts) {
+        memset(_region_counts, 0, _region_count * OpCnt * sizeof(uint32_t));
+    }
+    _trace_count = 0;
 }
 
 bd_size_t ProfilingBlockDevice::get_read_count() const
@@ -118,3 +162,127 @@ bd_size_t ProfilingBlockDevice::get_erase_count() const
 {
     return _erase_count;
 }
+
+uint32_t ProfilingBlockDevice::get_latency_count(OpType op, int bucket) const
+{
+    MBED_ASSERT(op < OpCnt && bucket >= 0 && bucket < LatencyBuckets);
+    return _latency_counts[op][bucket];
+}
+
+uint32_t ProfilingBlockDevice::get_max_latency(OpType op) const
+{
+    MBED_ASSERT(op < OpCnt);
+    return _max_latency[op];
+}
+
+bd_size_t ProfilingBlockDevice::get_region_size() const
+{
+    return _region_size;
+}
+
+uint32_t ProfilingBlockDevice::get_region_count(OpType op, bd_addr_t addr) const
+{
+    MBED_ASSERT(op < OpCnt);
+    if (!_region_size || addr >= size()) {
+        return 0;
+    }
+
+    bd_addr_t region = addr / _region_size;
+    if (region >= _region_count) {
+        return 0;
+    }
+
+    return _region_counts[region * OpCnt + op];
+}
+
+size_t ProfilingBlockDevice::get_trace_count() const
+{
+    return _trace_count;
+}
+
+const ProfilingBlockDevice::trace_entry &ProfilingBlockDevice::get_trace_entry(size_t index) const
+{
+    MBED_ASSERT(index < _trace_count);
+    return _trace[index];
+}
+
+static const char trace_ops[ProfilingBlockDevice::OpCnt] = {'r', 'p', 'e'};
+
+int ProfilingBlockDevice::dump_trace(FILE *file) const
+{
+    for (size_t i = 0; i < _trace_count; i++) {
+        int res = fprintf(file, "%c %llu %llu %lu\n", trace_ops[_trace[i].op],
+                (unsigned long long)_trace[i].addr, (unsigned long long)_trace[i].size,
+                (unsigned long)_trace[i].latency);
+        if (res < 0) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+    }
+
+    return 0;
+}
+
+int ProfilingBlockDevice::replay_trace(BlockDevice *bd, FILE *file)
+{
+    char op;
+    unsigned long long addr, size;
+    unsigned long latency;
+    uint8_t *buffer = 0;
+    bd_size_t buffer_size = 0;
+    int err = 0;
+
+    while (!err && fscanf(file, " %c %llu %llu %lu", &op, &addr, &size, &latency) == 4) {
+        if (op == 'e') {
+            err = bd->erase(addr, size);
+            continue;
+        }
+
+        if (size > buffer_size) {
+            delete[] buffer;
+            buffer = new uint8_t[size];
+            buffer_size = size;
+        }
+
+        if (op == 'r') {
+            err = bd->read(buffer, addr, size);
+        } else if (op == 'p') {
+            for (bd_size_t i = 0; i < size; i++) {
+                buffer[i] = (uint8_t)((addr + i) ^ ((addr + i) >> 8));
+            }
+            err = bd->program(buffer, addr, size);
+        } else {
+            err = BD_ERROR_DEVICE_ERROR;
+        }
+    }
+
+    delete[] buffer;
+    return err;
+}
+
+void ProfilingBlockDevice::record(OpType op, bd_addr_t addr, bd_size_t size, uint32_t latency)
+{
+    // Bucket of the latency is its base 2 logarithm
+    int bucket = 0;
+    for (uint32_t us = latency >> 1; us && bucket < LatencyBuckets - 1; us >>= 1) {
+        bucket++;
+    }
+    _latency_counts[op][bucket]++;
+    if (latency > _max_latency[op]) {
+        _max_latency[op] = latency;
+    }
+
+    if (_region_size) {
+        for (bd_addr_t region = addr / _region_size;
+                region * _region_size < addr + size && region < _region_count; region++) {
+            _region_counts[region * OpCnt + op]++;
+        }
+    }
+
+    if (_trace_count < _trace_size) {
+        trace_entry &entry = _trace[_trace_count++];
+        entry.addr = addr;
+        entry.size = size;
+        entry.latency = latency;
+        entry.op = op;
+    }
+}
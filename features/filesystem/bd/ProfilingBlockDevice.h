@@ -24,6 +24,8 @@
 
 #include "BlockDevice.h"
 #include "mbed.h"
+#include "platform/NonCopyable.h"
+#include <stdio.h>
 
 
 /** Block device for measuring storage operations of another block device
@@ -43,24 +45,67 @@
  *  printf("program count: %lld\n", profiler.get_program_count());
  *  printf("erase count: %lld\n", profiler.get_erase_count());
  *  @endcode
+ *
+ *  In addition, each operation is timed into a latency histogram, and
+ *  optionally counted per region of the block device (a heatmap) and
+ *  recorded in a trace, which can be dumped and replayed on another
+ *  block device, such as a HeapBlockDevice on the host:
+ *
+ *  @code
+ *  ProfilingBlockDevice profiler(&mem, 16, 256);
+ *
+ *  // do block device work....
+ *
+ *  for (int i = 0; i < ProfilingBlockDevice::LatencyBuckets; i++) {
+ *      printf("program < %dus: %lu\n", 2 << i,
+ *          profiler.get_latency_count(ProfilingBlockDevice::ProgramOp, i));
+ *  }
+ *  profiler.dump_trace(stdout);
+ *  @endcode
  */
-class ProfilingBlockDevice : public BlockDevice
+class ProfilingBlockDevice : public BlockDevice, private mbed::NonCopyable<ProfilingBlockDevice>
 {
 public:
+    /** Profiled operations
+     */
+    enum OpType {
+        ReadOp = 0,
+        ProgramOp,
+        EraseOp,
+        OpCnt
+    };
+
+    /** Number of latency histogram buckets, bucket i counting operations
+     *  that took less than 2^(i+1) us (the last one counting all longer ones)
+     */
+    static const int LatencyBuckets = 20;
+
+    /** Entry of the operation trace
+     */
+    struct trace_entry {
+        bd_addr_t addr;
+        bd_size_t size;
+        uint32_t latency;
+        uint8_t op;
+    };
+
     /** Lifetime of the memory block device
      *
-     *  @param bd       Block device to back the ProfilingBlockDevice
+     *  @param bd               Block device to back the ProfilingBlockDevice
+     *  @param heatmap_regions  Number of regions to count operations in, 0 to disable the heatmap
+     *  @param trace_size       Number of operations to record in the trace, 0 to disable the trace
      */
-    ProfilingBlockDevice(BlockDevice *bd);
+    ProfilingBlockDevice(BlockDevice *bd, size_t heatmap_regions = 0, size_t trace_size = 0);
 
     /** Lifetime of a block device
      */
-    virtual ~ProfilingBlockDevice() {};
+    virtual ~ProfilingBlockDevice();
 
     /** Initialize a block device
      *
      *  @return         0 on success or a negative error code on failure
-     *  @note The init and deinit functions do not effect profile counts
+     *  @note The init and deinit functions do not effect profile counts,
+     *        apart from resizing heatmap regions to the block device
      */
     virtual int init();
 
@@ -175,11 +220,89 @@ public:
      */
     bd_size_t get_erase_count() const;
 
+    /** Get number of operations in a latency histogram bucket
+     *
+     *  @param op       Operation
+     *  @param bucket   Bucket index, less than LatencyBuckets
+     *  @return The number of operations in the bucket
+     */
+    uint32_t get_latency_count(OpType op, int bucket) const;
+
+    /** Get longest latency of an operation
+     *
+     *  @param op       Operation
+     *  @return The longest time an operation took in us
+     */
+    uint32_t get_max_latency(OpType op) const;
+
+    /** Get size of a heatmap region
+     *
+     *  @return Size of a heatmap region in bytes, a multiple of the erase size,
+     *          or 0 if the heatmap is disabled
+     */
+    bd_size_t get_region_size() const;
+
+    /** Get number of operations on a heatmap region
+     *
+     *  @param op       Operation
+     *  @param addr     Address within the region
+     *  @return The number of operations on blocks of the region, or 0 if
+     *          addr is outside the device
+     */
+    uint32_t get_region_count(OpType op, bd_addr_t addr) const;
+
+    /** Get number of operations recorded in the trace
+     *
+     *  Recording stops once the trace is full, so that it can be replayed
+     *
+     *  @return The number of trace entries
+     */
+    size_t get_trace_count() const;
+
+    /** Get operation recorded in the trace
+     *
+     *  @param index    Index of the entry, less than get_trace_count
+     *  @return The trace entry
+     */
+    const trace_entry &get_trace_entry(size_t index) const;
+
+    /** Write the trace in text form, one operation per line
+     *
+     *  Each line holds the operation (r, p or e), address, size and latency in us
+     *
+     *  @param file     File to write the trace to
+     *  @return         0 on success, negative error code on failure
+     */
+    int dump_trace(FILE *file) const;
+
+    /** Replay a trace written by dump_trace on a block device
+     *
+     *  Programmed data is a pattern derived from the address, so the trace can be
+     *  replayed on a block device of a different type, such as a HeapBlockDevice.
+     *  Wrap the block device in a ProfilingBlockDevice to profile the replay.
+     *
+     *  @param bd       Initialized block device to replay the trace on
+     *  @param file     File to read the trace from
+     *  @return         0 on success, negative error code on failure
+     */
+    static int replay_trace(BlockDevice *bd, FILE *file);
+
 private:
+    void record(OpType op, bd_addr_t addr, bd_size_t size, uint32_t latency);
+
     BlockDevice *_bd;
     bd_size_t _read_count;
     bd_size_t _program_count;
     bd_size_t _erase_count;
+    const ticker_data_t *const _ticker_data;
+    uint32_t _latency_counts[OpCnt][LatencyBuckets];
+    uint32_t _max_latency[OpCnt];
+    size_t _region_count;
+    bd_size_t _region_size;
+    uint32_t *_region_counts;
+    size_t _trace_size;
+    size_t _trace_count;
+    trace_entry *_trace;
 };
 
 
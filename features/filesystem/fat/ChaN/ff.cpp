@@ -3569,6 +3569,9 @@ FRESULT f_open (
 
 
 	if (!fp) return FR_INVALID_OBJECT;
+#if !FF_FS_READONLY && !FF_FS_TINY && FF_FS_HEAPBUF
+	fp->buf = 0;
+#endif
 
 	/* Get logical drive */
 	mode &= FF_FS_READONLY ? FA_READ : FA_READ | FA_WRITE | FA_CREATE_ALWAYS | FA_CREATE_NEW | FA_OPEN_ALWAYS | FA_OPEN_APPEND;
@@ -3702,11 +3705,12 @@ FRESULT f_open (
 #if !FF_FS_READONLY
 #if !FF_FS_TINY
 #if FF_FS_HEAPBUF
-            fp->buf = (BYTE*)ff_memalloc(SS(dj.obj.fs));	/* Allocate buffer if necessary */
-			if (!fp->buf)
-				return FR_NOT_ENOUGH_CORE;
+			fp->buf = (BYTE*)ff_memalloc(SS(fs));	/* Allocate buffer if necessary */
+			if (!fp->buf) {
+				res = FR_NOT_ENOUGH_CORE;
+			} else
 #endif
-			mem_set(fp->buf, 0, FF_MAX_SS);	/* Clear sector buffer */
+			mem_set(fp->buf, 0, SS(fs));	/* Clear sector buffer */
 #endif
 			if ((mode & FA_SEEKEND) && fp->obj.objsize > 0) {	/* Seek to end of file if FA_OPEN_APPEND is specified */
 				fp->fptr = fp->obj.objsize;			/* Offset to seek */
@@ -3735,7 +3739,13 @@ FRESULT f_open (
 		FREE_NAMBUF();
 	}
 
-	if (res != FR_OK) fp->obj.fs = 0;	/* Invalidate file object on error */
+	if (res != FR_OK) {
+		fp->obj.fs = 0;	/* Invalidate file object on error */
+#if !FF_FS_READONLY && !FF_FS_TINY && FF_FS_HEAPBUF
+		ff_memfree(fp->buf);	/* Deallocate buffer */
+		fp->buf = 0;
+#endif
+	}
 
 	LEAVE_FF(fs, res);
 }
@@ -44,8 +44,10 @@
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
-#define FF_USE_FASTSEEK	0
-/* This option switches fast seek function. (0:Disable or 1:Enable) */
+#define FF_USE_FASTSEEK	(MBED_CONF_FAT_CHAN_FF_FASTSEEK_FRAGMENTS > 0)
+/* This option switches fast seek function. (0:Disable or 1:Enable)
+/  Enabled when the fat_chan.ff_fastseek_fragments configuration option is
+/  not 0, in which case FATFileSystem maintains the link map of open files. */
 
 
 #define FF_USE_EXPAND	0
@@ -219,11 +221,12 @@
 / System Configurations
 /---------------------------------------------------------------------------*/
 
-#define FF_FS_TINY		1
+#define FF_FS_TINY		MBED_CONF_FAT_CHAN_FF_FS_TINY
 /* This option switches tiny buffer configuration. (0:Normal or 1:Tiny)
 /  At the tiny configuration, size of file object (FIL) is shrinked FF_MAX_SS bytes.
 /  Instead of private sector buffer eliminated from the file object, common sector
-/  buffer in the filesystem object (FATFS) is used for the file data transfer. */
+/  buffer in the filesystem object (FATFS) is used for the file data transfer.
+/  Set by the fat_chan.ff_fs_tiny configuration option. */
 
 
 #define FF_FS_EXFAT		0
@@ -132,6 +132,9 @@ static Deferred<const char*> fat_path_prefix(int id, const char *path)
 
 // Global access to block device from FAT driver
 static BlockDevice *_ffs[FF_VOLUMES] = {0};
+
+// Volume control (mount, unmount and format) uses the FAT driver's global
+// volume table, other operations are serialized per volume
 static SingletonPtr<PlatformMutex> _ffs_mutex;
 
 
@@ -289,9 +292,11 @@ int FATFileSystem::mount(BlockDevice *bd)
 
 int FATFileSystem::mount(BlockDevice *bd, bool mount)
 {
+    _ffs_mutex->lock();
     lock();
     if (_id != -1) {
         unlock();
+        _ffs_mutex->unlock();
         return -EINVAL;
     }
 
@@ -305,19 +310,23 @@ int FATFileSystem::mount(BlockDevice *bd, bool mount)
             debug_if(FFS_DBG, "Mounting [%s] on ffs drive [%s]\n", getName(), _fsid);
             FRESULT res = f_mount(&_fs, _fsid, mount);
             unlock();
+            _ffs_mutex->unlock();
             return fat_error_remap(res);
         }
     }
 
     unlock();
+    _ffs_mutex->unlock();
     return -ENOMEM;
 }
 
 int FATFileSystem::unmount()
 {
+    _ffs_mutex->lock();
     lock();
     if (_id == -1) {
         unlock();
+        _ffs_mutex->unlock();
         return -EINVAL;
     }
 
@@ -325,6 +334,7 @@ int FATFileSystem::unmount()
     _ffs[_id] = NULL;
     _id = -1;
     unlock();
+    _ffs_mutex->unlock();
     return fat_error_remap(res);
 }
 
@@ -339,9 +349,11 @@ int FATFileSystem::format(BlockDevice *bd, bd_size_t cluster_size)
     }
 
     // Logical drive number, Partitioning rule, Allocation unit size (bytes per cluster)
+    _ffs_mutex->lock();
     fs.lock();
     FRESULT res = f_mkfs(fs._fsid, FM_ANY | FM_SFD, cluster_size, NULL, 0);
     fs.unlock();
+    _ffs_mutex->unlock();
     if (res != FR_OK) {
         return fat_error_remap(res);
     }
@@ -356,6 +368,8 @@ int FATFileSystem::format(BlockDevice *bd, bd_size_t cluster_size)
 
 int FATFileSystem::reformat(BlockDevice *bd, int allocation_unit)
 {
+    // Same lock order as mount and unmount
+    _ffs_mutex->lock();
     lock();
     if (_id != -1) {
         if (!bd) {
@@ -365,23 +379,27 @@ int FATFileSystem::reformat(BlockDevice *bd, int allocation_unit)
         int err = unmount();
         if (err) {
             unlock();
+            _ffs_mutex->unlock();
             return err;
         }
     }
 
     if (!bd) {
         unlock();
+        _ffs_mutex->unlock();
         return -ENODEV;
     }
 
     int err = FATFileSystem::format(bd, allocation_unit);
     if (err) {
         unlock();
+        _ffs_mutex->unlock();
         return err;
     }
 
     err = mount(bd);
     unlock();
+    _ffs_mutex->unlock();
     return err;
 }
 
@@ -487,21 +505,64 @@ int FATFileSystem::statvfs(const char *path, struct statvfs *buf)
 
 void FATFileSystem::lock()
 {
-    _ffs_mutex->lock();
+    _mutex.lock();
 }
 
 void FATFileSystem::unlock()
 {
-    _ffs_mutex->unlock();
+    _mutex.unlock();
 }
 
 
 ////// File operations //////
+
+// Open file handle
+struct fat_file_t {
+    FIL fil;
+#if FF_USE_FASTSEEK
+    FSIZE_t link_map_failed_size; // File size when building the link map last failed
+#endif
+};
+
+#if FF_USE_FASTSEEK
+// Number of items in a cluster link map: table size, pairs of fragment
+// length and first cluster, and terminator
+#define FAT_LINK_MAP_SIZE (2*MBED_CONF_FAT_CHAN_FF_FASTSEEK_FRAGMENTS + 2)
+
+// Build cluster link map, so that seeking doesn't follow the FAT chain. Files of
+// a single cluster don't need one, and too fragmented files can't have one.
+static void fat_build_link_map(fat_file_t *fh)
+{
+    FIL *fp = &fh->fil;
+    if (fp->cltbl || fp->obj.objsize <= (FSIZE_t)fp->obj.fs->csize * fp->obj.fs->ssize ||
+            fp->obj.objsize == fh->link_map_failed_size) {
+        return;
+    }
+
+    fp->cltbl = new DWORD[FAT_LINK_MAP_SIZE];
+    fp->cltbl[0] = FAT_LINK_MAP_SIZE;
+    FRESULT res = f_lseek(fp, CREATE_LINKMAP);
+    if (res != FR_OK) {
+        debug_if(FFS_DBG, "f_lseek(CREATE_LINKMAP) failed: %d\n", res);
+        delete[] fp->cltbl;
+        fp->cltbl = 0;
+        fh->link_map_failed_size = fp->obj.objsize;
+    }
+}
+
+// Drop cluster link map, before the file grows past it
+static void fat_drop_link_map(fat_file_t *fh)
+{
+    delete[] fh->fil.cltbl;
+    fh->fil.cltbl = 0;
+}
+#endif
+
 int FATFileSystem::file_open(fs_file_t *file, const char *path, int flags)
 {
     debug_if(FFS_DBG, "open(%s) on filesystem [%s], drv [%s]\n", path, getName(), _id);
 
-    FIL *fh = new FIL;
+    fat_file_t *fh = new fat_file_t;
     Deferred<const char*> fpath = fat_path_prefix(_id, path);
 
     /* POSIX flags -> FatFS open mode */
@@ -527,7 +588,7 @@ int FATFileSystem::file_open(fs_file_t *file, const char *path, int flags)
     }
 
     lock();
-    FRESULT res = f_open(fh, fpath, openmode);
+    FRESULT res = f_open(&fh->fil, fpath, openmode);
 
     if (res != FR_OK) {
         unlock();
@@ -536,6 +597,9 @@ int FATFileSystem::file_open(fs_file_t *file, const char *path, int flags)
         return fat_error_remap(res);
     }
 
+#if FF_USE_FASTSEEK
+    fh->link_map_failed_size = 0;
+#endif
     unlock();
 
     *file = fh;
@@ -544,10 +608,13 @@ int FATFileSystem::file_open(fs_file_t *file, const char *path, int flags)
 
 int FATFileSystem::file_close(fs_file_t file)
 {
-    FIL *fh = static_cast<FIL*>(file);
+    fat_file_t *fh = static_cast<fat_file_t*>(file);
 
     lock();
-    FRESULT res = f_close(fh);
+    FRESULT res = f_close(&fh->fil);
+#if FF_USE_FASTSEEK
+    fat_drop_link_map(fh);
+#endif
     unlock();
 
     delete fh;
@@ -556,7 +623,7 @@ int FATFileSystem::file_close(fs_file_t file)
 
 ssize_t FATFileSystem::file_read(fs_file_t file, void *buffer, size_t len)
 {
-    FIL *fh = static_cast<FIL*>(file);
+    FIL *fh = &static_cast<fat_file_t*>(file)->fil;
 
     lock();
     UINT n;
@@ -573,11 +640,16 @@ ssize_t FATFileSystem::file_read(fs_file_t file, void *buffer, size_t len)
 
 ssize_t FATFileSystem::file_write(fs_file_t file, const void *buffer, size_t len)
 {
-    FIL *fh = static_cast<FIL*>(file);
+    fat_file_t *fh = static_cast<fat_file_t*>(file);
 
     lock();
+#if FF_USE_FASTSEEK
+    if (fh->fil.fptr + len > fh->fil.obj.objsize) {
+        fat_drop_link_map(fh);
+    }
+#endif
     UINT n;
-    FRESULT res = f_write(fh, buffer, len, &n);
+    FRESULT res = f_write(&fh->fil, buffer, len, &n);
     unlock();
 
     if (res != FR_OK) {
@@ -588,9 +660,76 @@ ssize_t FATFileSystem::file_write(fs_file_t file, const void *buffer, size_t len
     }
 }
 
+ssize_t FATFileSystem::file_readv(fs_file_t file, const struct iovec *iov, int iovcnt)
+{
+    FIL *fh = &static_cast<fat_file_t*>(file)->fil;
+
+    lock();
+    ssize_t total = 0;
+    FRESULT res = FR_OK;
+    for (int i = 0; i < iovcnt; i++) {
+        UINT n;
+        res = f_read(fh, iov[i].iov_base, iov[i].iov_len, &n);
+        if (res != FR_OK) {
+            break;
+        }
+        total += n;
+        if (n < iov[i].iov_len) {
+            break;
+        }
+    }
+    unlock();
+
+    if (res != FR_OK && total == 0) {
+        debug_if(FFS_DBG, "f_read() failed: %d\n", res);
+        return fat_error_remap(res);
+    } else {
+        return total;
+    }
+}
+
+ssize_t FATFileSystem::file_writev(fs_file_t file, const struct iovec *iov, int iovcnt)
+{
+    fat_file_t *fh = static_cast<fat_file_t*>(file);
+
+    lock();
+#if FF_USE_FASTSEEK
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+    if (fh->fil.fptr + len > fh->fil.obj.objsize) {
+        fat_drop_link_map(fh);
+    }
+#endif
+    // partial sectors of consecutive buffers are gathered in the
+    // sector buffer, so they cost no more writes than a single f_write
+    ssize_t total = 0;
+    FRESULT res = FR_OK;
+    for (int i = 0; i < iovcnt; i++) {
+        UINT n;
+        res = f_write(&fh->fil, iov[i].iov_base, iov[i].iov_len, &n);
+        if (res != FR_OK) {
+            break;
+        }
+        total += n;
+        if (n < iov[i].iov_len) {
+            break;
+        }
+    }
+    unlock();
+
+    if (res != FR_OK && total == 0) {
+        debug_if(FFS_DBG, "f_write() failed: %d", res);
+        return fat_error_remap(res);
+    } else {
+        return total;
+    }
+}
+
 int FATFileSystem::file_sync(fs_file_t file)
 {
-    FIL *fh = static_cast<FIL*>(file);
+    FIL *fh = &static_cast<fat_file_t*>(file)->fil;
 
     lock();
     FRESULT res = f_sync(fh);
@@ -604,17 +743,26 @@ int FATFileSystem::file_sync(fs_file_t file)
 
 off_t FATFileSystem::file_seek(fs_file_t file, off_t offset, int whence)
 {
-    FIL *fh = static_cast<FIL*>(file);
+    fat_file_t *fh = static_cast<fat_file_t*>(file);
 
     lock();
     if (whence == SEEK_END) {
-        offset += f_size(fh);
+        offset += f_size(&fh->fil);
     } else if(whence==SEEK_CUR) {
-        offset += f_tell(fh);
+        offset += f_tell(&fh->fil);
     }
 
-    FRESULT res = f_lseek(fh, offset);
-    off_t noffset = fh->fptr;
+#if FF_USE_FASTSEEK
+    // Seeking with a link map stops at the end of the file, while files open
+    // for writing can be extended by seeking past their end
+    if ((FSIZE_t)offset > f_size(&fh->fil)) {
+        fat_drop_link_map(fh);
+    } else {
+        fat_build_link_map(fh);
+    }
+#endif
+    FRESULT res = f_lseek(&fh->fil, offset);
+    off_t noffset = fh->fil.fptr;
     unlock();
 
     if (res != FR_OK) {
@@ -627,7 +775,7 @@ off_t FATFileSystem::file_seek(fs_file_t file, off_t offset, int whence)
 
 off_t FATFileSystem::file_tell(fs_file_t file)
 {
-    FIL *fh = static_cast<FIL*>(file);
+    FIL *fh = &static_cast<fat_file_t*>(file)->fil;
 
     lock();
     off_t res = f_tell(fh);
@@ -638,7 +786,7 @@ off_t FATFileSystem::file_tell(fs_file_t file)
 
 off_t FATFileSystem::file_size(fs_file_t file)
 {
-    FIL *fh = static_cast<FIL*>(file);
+    FIL *fh = &static_cast<fat_file_t*>(file)->fil;
 
     lock();
     off_t res = f_size(fh);
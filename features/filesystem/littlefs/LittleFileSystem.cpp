@@ -112,12 +112,15 @@ static int lfs_bd_sync(const struct lfs_config *c)
 // Filesystem implementation (See LittleFileSystem.h)
 LittleFileSystem::LittleFileSystem(const char *name, BlockDevice *bd,
         lfs_size_t read_size, lfs_size_t prog_size,
-        lfs_size_t block_size, lfs_size_t lookahead)
+        lfs_size_t block_size, lfs_size_t lookahead, bool free_map,
+        lfs_size_t name_index)
         : FileSystem(name)
         , _read_size(read_size)
         , _prog_size(prog_size)
         , _block_size(block_size)
-        , _lookahead(lookahead) {
+        , _lookahead(lookahead)
+        , _free_map(free_map)
+        , _name_index(name_index) {
     if (bd) {
         mount(bd);
     }
@@ -163,6 +166,8 @@ int LittleFileSystem::mount(BlockDevice *bd)
     if (_config.lookahead > _lookahead) {
         _config.lookahead = _lookahead;
     }
+    _config.free_map = _free_map;
+    _config.name_index = _name_index;
 
     err = lfs_mount(&_lfs, &_config);
     LFS_INFO("mount -> %d", lfs_toerror(err));
@@ -417,6 +422,49 @@ ssize_t LittleFileSystem::file_write(fs_file_t file, const void *buffer, size_t
     return lfs_toerror(res);
 }
 
+ssize_t LittleFileSystem::file_readv(fs_file_t file, const struct iovec *iov, int iovcnt)
+{
+    lfs_file_t *f = (lfs_file_t *)file;
+    _mutex.lock();
+    LFS_INFO("file_readv(%p, %p, %d)", file, iov, iovcnt);
+    lfs_ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        lfs_ssize_t res = lfs_file_read(&_lfs, f, iov[i].iov_base, iov[i].iov_len);
+        if (res < 0) {
+            total = total ? total : res;
+            break;
+        }
+        total += res;
+        if ((lfs_size_t)res < iov[i].iov_len) {
+            break;
+        }
+    }
+    LFS_INFO("file_readv -> %d", lfs_toerror(total));
+    _mutex.unlock();
+    return lfs_toerror(total);
+}
+
+ssize_t LittleFileSystem::file_writev(fs_file_t file, const struct iovec *iov, int iovcnt)
+{
+    lfs_file_t *f = (lfs_file_t *)file;
+    _mutex.lock();
+    LFS_INFO("file_writev(%p, %p, %d)", file, iov, iovcnt);
+    // buffers are gathered in the file's program cache, so they cost
+    // no more programs than a single write of the same size
+    lfs_ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        lfs_ssize_t res = lfs_file_write(&_lfs, f, iov[i].iov_base, iov[i].iov_len);
+        if (res < 0) {
+            total = total ? total : res;
+            break;
+        }
+        total += res;
+    }
+    LFS_INFO("file_writev -> %d", lfs_toerror(total));
+    _mutex.unlock();
+    return lfs_toerror(total);
+}
+
 int LittleFileSystem::file_sync(fs_file_t file)
 {
     lfs_file_t *f = (lfs_file_t *)file;
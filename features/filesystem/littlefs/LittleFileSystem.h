@@ -50,12 +50,24 @@ public:
      *      lookahead reduces the number of passes required to allocate a block.
      *      The lookahead buffer requires only 1 bit per block so it can be quite
      *      large with little ram impact. Should be a multiple of 32.
+     *  @param free_map
+     *      Track free blocks of the whole block device in a map built when
+     *      mounting, instead of using a lookahead buffer. Allocation then only
+     *      has to traverse the filesystem when the map runs out of free blocks,
+     *      at the cost of 1 bit of ram per block.
+     *  @param name_index
+     *      Number of names of each recently searched directory to keep in a
+     *      hash index, so opening or stating a file doesn't scan the whole
+     *      directory. Takes 18 bytes of ram per name for each of the
+     *      MBED_LFS_NAME_INDEX_DIRS indexed directories, 0 disables the index.
      */
     LittleFileSystem(const char *name=NULL, BlockDevice *bd=NULL,
             lfs_size_t read_size=MBED_LFS_READ_SIZE,
             lfs_size_t prog_size=MBED_LFS_PROG_SIZE,
             lfs_size_t block_size=MBED_LFS_BLOCK_SIZE,
-            lfs_size_t lookahead=MBED_LFS_LOOKAHEAD);
+            lfs_size_t lookahead=MBED_LFS_LOOKAHEAD,
+            bool free_map=MBED_LFS_FREE_MAP,
+            lfs_size_t name_index=MBED_LFS_NAME_INDEX);
     virtual ~LittleFileSystem();
     
     /** Formats a block device with the LittleFileSystem
@@ -187,6 +199,24 @@ protected:
      */
     virtual ssize_t file_write(mbed::fs_file_t file, const void *buffer, size_t size);
 
+    /** Read the contents of a file into a list of buffers
+     *
+     *  @param file     File handle
+     *  @param iov      Array of buffers to read in to
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         The number of bytes read, 0 at end of file, negative error on failure
+     */
+    virtual ssize_t file_readv(mbed::fs_file_t file, const struct iovec *iov, int iovcnt);
+
+    /** Write the contents of a list of buffers to a file
+     *
+     *  @param file     File handle
+     *  @param iov      Array of buffers to write from
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         The number of bytes written, negative error on failure
+     */
+    virtual ssize_t file_writev(mbed::fs_file_t file, const struct iovec *iov, int iovcnt);
+
     /** Flush any buffers associated with the file
      *
      *  @param file     File handle
@@ -274,6 +304,8 @@ private:
     const lfs_size_t _prog_size;
     const lfs_size_t _block_size;
     const lfs_size_t _lookahead;
+    const bool _free_map;
+    const lfs_size_t _name_index;
 
     // thread-safe locking
     PlatformMutex _mutex;
@@ -387,6 +387,85 @@ void test_large_file_seek()
     TEST_ASSERT_EQUAL(0, res);
 }
 
+void test_backward_and_random_file_seek()
+{
+    int res = bd.init();
+    TEST_ASSERT_EQUAL(0, res);
+
+    {
+        res = fs.mount(&bd);
+        TEST_ASSERT_EQUAL(0, res);
+        res = file[0].open(&fs, "indexed",
+                O_RDWR | O_CREAT);
+        TEST_ASSERT_EQUAL(0, res);
+    
+        size = strlen("kitty000000");
+        static int tags[5*132];
+        for (int i = 0; i < 4*132; i++) {
+            sprintf((char*)buffer, "kitty%06d", i);
+            res = file[0].write(buffer, size);
+            TEST_ASSERT_EQUAL(size, res);
+            tags[i] = i;
+        }
+    
+        for (int i = 4*132-1; i >= 0; i--) {
+            res = file[0].seek(i*size, SEEK_SET);
+            TEST_ASSERT_EQUAL(i*size, res);
+            res = file[0].read(rbuffer, size);
+            TEST_ASSERT_EQUAL(size, res);
+            sprintf((char*)buffer, "kitty%06d", tags[i]);
+            res = memcmp(rbuffer, buffer, size);
+            TEST_ASSERT_EQUAL(0, res);
+        }
+    
+        srand(1);
+        for (int j = 0; j < 4*132; j++) {
+            int i = rand() % (4*132);
+            res = file[0].seek(i*size, SEEK_SET);
+            TEST_ASSERT_EQUAL(i*size, res);
+            if (rand() % 4 == 0) {
+                tags[i] = 5*132 + j;
+                sprintf((char*)buffer, "kitty%06d", tags[i]);
+                res = file[0].write(buffer, size);
+                TEST_ASSERT_EQUAL(size, res);
+            } else {
+                res = file[0].read(rbuffer, size);
+                TEST_ASSERT_EQUAL(size, res);
+                sprintf((char*)buffer, "kitty%06d", tags[i]);
+                res = memcmp(rbuffer, buffer, size);
+                TEST_ASSERT_EQUAL(0, res);
+            }
+        }
+        res = file[0].seek(0, SEEK_END);
+        TEST_ASSERT_EQUAL(4*132*size, res);
+        for (int i = 4*132; i < 5*132; i++) {
+            tags[i] = i;
+            sprintf((char*)buffer, "kitty%06d", tags[i]);
+            res = file[0].write(buffer, size);
+            TEST_ASSERT_EQUAL(size, res);
+        }
+    
+        for (int i = 5*132-1; i >= 0; i--) {
+            res = file[0].seek(i*size, SEEK_SET);
+            TEST_ASSERT_EQUAL(i*size, res);
+            res = file[0].read(rbuffer, size);
+            TEST_ASSERT_EQUAL(size, res);
+            sprintf((char*)buffer, "kitty%06d", tags[i]);
+            res = memcmp(rbuffer, buffer, size);
+            TEST_ASSERT_EQUAL(0, res);
+        }
+        res = file[0].close();
+        TEST_ASSERT_EQUAL(0, res);
+        res = fs.remove("indexed");
+        TEST_ASSERT_EQUAL(0, res);
+        res = fs.unmount();
+        TEST_ASSERT_EQUAL(0, res);
+    }
+
+    res = bd.deinit();
+    TEST_ASSERT_EQUAL(0, res);
+}
+
 void test_simple_file_seek_and_write()
 {
     int res = bd.init();
@@ -629,6 +708,7 @@ Case cases[] = {
     Case("Large dir seek", test_large_dir_seek),
     Case("Simple file seek", test_simple_file_seek),
     Case("Large file seek", test_large_file_seek),
+    Case("Backward and random file seek", test_backward_and_random_file_seek),
     Case("Simple file seek and write", test_simple_file_seek_and_write),
     Case("Large file seek and write", test_large_file_seek_and_write),
     Case("Boundary seek and write", test_boundary_seek_and_write),
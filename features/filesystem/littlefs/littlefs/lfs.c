@@ -264,6 +264,14 @@ static int lfs_moved(lfs_t *lfs, const void *e);
 static int lfs_relocate(lfs_t *lfs,
         const lfs_block_t oldpair[2], const lfs_block_t newpair[2]);
 int lfs_deorphan(lfs_t *lfs);
+static int lfs_index_find(lfs_t *lfs, lfs_dir_t *dir,
+        lfs_entry_t *entry, const char *name, lfs_size_t len);
+static void lfs_index_append(lfs_t *lfs,
+        const lfs_dir_t *dir, const lfs_entry_t *entry, const void *name);
+static void lfs_index_remove(lfs_t *lfs,
+        const lfs_dir_t *dir, const lfs_entry_t *entry);
+static void lfs_index_drop(lfs_t *lfs, const lfs_block_t pair[2]);
+static void lfs_index_clear(lfs_t *lfs);
 
 
 /// Block allocator ///
@@ -280,7 +288,92 @@ static int lfs_alloc_lookahead(void *p, lfs_block_t block) {
     return 0;
 }
 
+static void lfs_alloc_clear(lfs_t *lfs) {
+    // the free map covers the whole device, with any bits past the last
+    // block marked as in use
+    lfs_size_t words = (lfs->cfg->block_count+31)/32;
+    memset(lfs->free.buffer, 0, 4*words);
+    for (lfs_block_t i = lfs->cfg->block_count; i < 32*words; i++) {
+        lfs->free.buffer[i / 32] |= 1U << (i % 32);
+    }
+
+    lfs->free.off = 0;
+    lfs->free.size = lfs->cfg->block_count;
+}
+
+static int lfs_alloc_scan(lfs_t *lfs) {
+    // find mask of free blocks from tree
+    lfs_alloc_clear(lfs);
+    int err = lfs_traverse(lfs, lfs_alloc_lookahead, lfs);
+    if (err) {
+        return err;
+    }
+
+    // blocks allocated since last ack may not be in the tree yet
+    for (lfs_block_t i = 0; i < lfs->cfg->block_count - lfs->free.ack; i++) {
+        lfs_block_t off = (lfs->free.acked + i) % lfs->cfg->block_count;
+        lfs->free.buffer[off / 32] |= 1U << (off % 32);
+    }
+
+    lfs->free.count = 0;
+    for (lfs_size_t i = 0; i < (lfs->cfg->block_count+31)/32; i++) {
+        lfs->free.count += 32 - lfs_popc(lfs->free.buffer[i]);
+    }
+
+    return 0;
+}
+
+static int lfs_alloc_map(lfs_t *lfs, lfs_block_t *block) {
+    if (lfs->free.count == 0) {
+        // reclaim any blocks we weren't told were freed
+        int err = lfs_alloc_scan(lfs);
+        if (err) {
+            return err;
+        }
+
+        if (lfs->free.count == 0) {
+            LFS_WARN("No more free space %"PRIu32, lfs->free.index);
+            return LFS_ERR_NOSPC;
+        }
+    }
+
+    // continue after the last allocated block, so allocations
+    // still move around the device
+    while (true) {
+        lfs_block_t off = lfs->free.index;
+        lfs->free.index = (lfs->free.index + 1) % lfs->cfg->block_count;
+        if (lfs->free.ack > 0) {
+            lfs->free.ack -= 1;
+        }
+
+        if (!(lfs->free.buffer[off / 32] & (1U << (off % 32)))) {
+            // found a free block
+            lfs->free.buffer[off / 32] |= 1U << (off % 32);
+            lfs->free.count -= 1;
+            *block = off;
+            return 0;
+        }
+    }
+}
+
+static void lfs_alloc_free(lfs_t *lfs, lfs_block_t block) {
+    if (lfs->cfg->free_map &&
+            (lfs->free.buffer[block / 32] & (1U << (block % 32)))) {
+        lfs->free.buffer[block / 32] &= ~(1U << (block % 32));
+        lfs->free.count += 1;
+    }
+}
+
+static int lfs_alloc_freecb(void *p, lfs_block_t block) {
+    lfs_alloc_free(p, block);
+    return 0;
+}
+
 static int lfs_alloc(lfs_t *lfs, lfs_block_t *block) {
+    if (lfs->cfg->free_map) {
+        return lfs_alloc_map(lfs, block);
+    }
+
     while (true) {
         while (lfs->free.index != lfs->free.size) {
             lfs_block_t off = lfs->free.index;
@@ -306,7 +399,8 @@ static int lfs_alloc(lfs_t *lfs, lfs_block_t *block) {
 
         // check if we have looked at all blocks since last ack
         if (lfs->free.ack == 0) {
-            LFS_WARN("No more free space %ld", lfs->free.index+lfs->free.off);
+            LFS_WARN("No more free space %"PRIu32,
+                    lfs->free.index+lfs->free.off);
             return LFS_ERR_NOSPC;
         }
 
@@ -326,6 +420,7 @@ static int lfs_alloc(lfs_t *lfs, lfs_block_t *block) {
 
 static void lfs_alloc_ack(lfs_t *lfs) {
     lfs->free.ack = lfs->cfg->block_count;
+    lfs->free.acked = lfs->free.index;
 }
 
 
@@ -622,6 +717,7 @@ relocate:
         // update references if we relocated
         LFS_DEBUG("Relocating %ld %ld to %ld %ld",
                 oldpair[0], oldpair[1], dir->pair[0], dir->pair[1]);
+        lfs_index_clear(lfs);
         int err = lfs_relocate(lfs, oldpair, dir->pair);
         if (err) {
             return err;
@@ -663,7 +759,12 @@ static int lfs_dir_append(lfs_t *lfs, lfs_dir_t *dir,
                     {entry->off, 0, data, entry->d.nlen}
                 }, 2);
             lfs_entry_fromle32(&entry->d);
-            return err;
+            if (err) {
+                return err;
+            }
+
+            lfs_index_append(lfs, dir, entry, data);
+            return 0;
         }
 
         // we need to allocate a new dir block
@@ -690,7 +791,13 @@ static int lfs_dir_append(lfs_t *lfs, lfs_dir_t *dir,
             olddir.d.size |= 0x80000000;
             olddir.d.tail[0] = dir->pair[0];
             olddir.d.tail[1] = dir->pair[1];
-            return lfs_dir_commit(lfs, &olddir, NULL, 0);
+            err = lfs_dir_commit(lfs, &olddir, NULL, 0);
+            if (err) {
+                return err;
+            }
+
+            lfs_index_append(lfs, dir, entry, data);
+            return 0;
         }
 
         int err = lfs_dir_fetch(lfs, dir, dir->d.tail);
@@ -714,7 +821,14 @@ static int lfs_dir_remove(lfs_t *lfs, lfs_dir_t *dir, lfs_entry_t *entry) {
             pdir.d.size &= dir->d.size | 0x7fffffff;
             pdir.d.tail[0] = dir->d.tail[0];
             pdir.d.tail[1] = dir->d.tail[1];
-            return lfs_dir_commit(lfs, &pdir, NULL, 0);
+            int err = lfs_dir_commit(lfs, &pdir, NULL, 0);
+            if (err) {
+                return err;
+            }
+
+            lfs_index_remove(lfs, dir, entry);
+            lfs_index_drop(lfs, dir->pair);
+            return 0;
         }
     }
 
@@ -726,6 +840,8 @@ static int lfs_dir_remove(lfs_t *lfs, lfs_dir_t *dir, lfs_entry_t *entry) {
         return err;
     }
 
+    lfs_index_remove(lfs, dir, entry);
+
     // shift over any files/directories that are affected
     for (lfs_file_t *f = lfs->files; f; f = f->next) {
         if (lfs_paircmp(f->pair, dir->pair) == 0) {
@@ -837,8 +953,13 @@ static int lfs_dir_find(lfs_t *lfs, lfs_dir_t *dir,
         // update what we've found
         *path = pathname;
 
-        // find path
-        while (true) {
+        // look up name index, or find path if directory isn't indexed
+        int found = lfs_index_find(lfs, dir, entry, pathname, pathlen);
+        if (found < 0) {
+            return found;
+        }
+
+        while (!found) {
             int err = lfs_dir_next(lfs, dir, entry);
             if (err) {
                 return err;
@@ -892,6 +1013,398 @@ static int lfs_dir_find(lfs_t *lfs, lfs_dir_t *dir,
 }
 
 
+/// Directory name index operations ///
+#if LFS_NAME_INDEX_DIRS > 0
+static inline uint16_t lfs_index_hash(uint32_t crc) {
+    return crc ^ (crc >> 16);
+}
+
+static inline lfs_size_t lfs_index_size(lfs_t *lfs) {
+    // keep a third of the slots empty so probes stay short
+    return lfs->cfg->name_index + lfs->cfg->name_index/2 + 1;
+}
+
+static inline struct lfs_index_slot *lfs_index_slots(lfs_t *lfs,
+        const struct lfs_index_dir *idir) {
+    return &lfs->index.slots[(idir - lfs->index.dirs)*lfs_index_size(lfs)];
+}
+
+static void lfs_index_reset(lfs_t *lfs, struct lfs_index_dir *idir,
+        const lfs_block_t head[2], bool complete) {
+    idir->head[0] = head[0];
+    idir->head[1] = head[1];
+    idir->tail[0] = 0xffffffff;
+    idir->tail[1] = 0xffffffff;
+    idir->count = 0;
+    idir->used = ++lfs->index.used;
+    idir->complete = complete;
+    memset(lfs_index_slots(lfs, idir), 0xff,
+            lfs_index_size(lfs)*sizeof(struct lfs_index_slot));
+}
+
+static struct lfs_index_dir *lfs_index_get(lfs_t *lfs,
+        const lfs_block_t head[2]) {
+    if (!lfs->cfg->name_index) {
+        return NULL;
+    }
+
+    for (int i = 0; i < LFS_NAME_INDEX_DIRS; i++) {
+        struct lfs_index_dir *idir = &lfs->index.dirs[i];
+        if (!lfs_pairisnull(idir->head) &&
+                lfs_paircmp(idir->head, head) == 0) {
+            return idir;
+        }
+    }
+
+    return NULL;
+}
+
+static int lfs_index_insert(lfs_t *lfs, struct lfs_index_dir *idir,
+        const lfs_block_t pair[2], lfs_off_t off, uint16_t hash) {
+    if (idir->count >= lfs->cfg->name_index) {
+        return LFS_ERR_NOSPC;
+    }
+
+    lfs_size_t size = lfs_index_size(lfs);
+    struct lfs_index_slot *slots = lfs_index_slots(lfs, idir);
+    lfs_size_t i = hash % size;
+    while (!lfs_pairisnull(slots[i].pair)) {
+        i = (i + 1) % size;
+    }
+
+    slots[i].pair[0] = pair[0];
+    slots[i].pair[1] = pair[1];
+    slots[i].off = off;
+    slots[i].hash = hash;
+    idir->count += 1;
+    return 0;
+}
+
+static void lfs_index_delete(lfs_t *lfs,
+        struct lfs_index_dir *idir, lfs_size_t i) {
+    lfs_size_t size = lfs_index_size(lfs);
+    struct lfs_index_slot *slots = lfs_index_slots(lfs, idir);
+
+    // shift back following slots that can't be found past the hole
+    for (lfs_size_t j = (i + 1) % size; !lfs_pairisnull(slots[j].pair);
+            j = (j + 1) % size) {
+        lfs_size_t k = slots[j].hash % size;
+        if ((j > i) ? (k <= i || k > j) : (k <= i && k > j)) {
+            slots[i] = slots[j];
+            i = j;
+        }
+    }
+
+    slots[i].pair[0] = 0xffffffff;
+    slots[i].pair[1] = 0xffffffff;
+    idir->count -= 1;
+}
+
+static int lfs_index_match(lfs_t *lfs, struct lfs_index_dir *idir,
+        lfs_dir_t *dir, lfs_entry_t *entry,
+        const char *name, lfs_size_t len, uint16_t hash) {
+    lfs_size_t size = lfs_index_size(lfs);
+    struct lfs_index_slot *slots = lfs_index_slots(lfs, idir);
+    for (lfs_size_t i = hash % size; !lfs_pairisnull(slots[i].pair);
+            i = (i + 1) % size) {
+        if (slots[i].hash != hash) {
+            continue;
+        }
+
+        // fetch block of entry, unless we already have it
+        if (lfs_paircmp(dir->pair, slots[i].pair) != 0) {
+            int err = lfs_dir_fetch(lfs, dir, slots[i].pair);
+            if (err) {
+                return err;
+            }
+        }
+
+        int err = lfs_bd_read(lfs, dir->pair[0], slots[i].off,
+                &entry->d, sizeof(entry->d));
+        lfs_entry_fromle32(&entry->d);
+        if (err) {
+            return err;
+        }
+
+        if (entry->d.nlen != len) {
+            continue;
+        }
+
+        int res = lfs_bd_cmp(lfs, dir->pair[0],
+                slots[i].off + 4+entry->d.elen+entry->d.alen,
+                name, len);
+        if (res < 0) {
+            return res;
+        }
+
+        // found match
+        if (res) {
+            entry->off = slots[i].off;
+            dir->off = entry->off + lfs_entry_size(entry);
+            return true;
+        }
+    }
+
+    // not found, leave last block fetched for appending
+    if (lfs_paircmp(dir->pair, idir->tail) != 0) {
+        int err = lfs_dir_fetch(lfs, dir, idir->tail);
+        if (err) {
+            return err;
+        }
+    }
+
+    dir->off = (0x7fffffff & dir->d.size) - 4;
+    entry->off = dir->off;
+    return LFS_ERR_NOENT;
+}
+static int lfs_index_build(lfs_t *lfs, struct lfs_index_dir *idir,
+        lfs_dir_t *dir, lfs_entry_t *entry,
+        const char *name, lfs_size_t len, uint16_t hash) {
+    bool found = false;
+    lfs_dir_t fdir;
+    lfs_entry_t fentry;
+    while (true) {
+        int err = lfs_dir_next(lfs, dir, entry);
+        if (err == LFS_ERR_NOENT) {
+            break;
+        } else if (err) {
+            return err;
+        }
+
+        if ((0x7f & entry->d.type) != LFS_TYPE_REG &&
+            (0x7f & entry->d.type) != LFS_TYPE_DIR) {
+            continue;
+        }
+
+        bool match = (entry->d.nlen == len);
+        if (idir->complete) {
+            uint32_t crc = 0xffffffff;
+            err = lfs_bd_crc(lfs, dir->pair[0],
+                    entry->off + 4+entry->d.elen+entry->d.alen,
+                    entry->d.nlen, &crc);
+            if (err) {
+                return err;
+            }
+
+            match = match && lfs_index_hash(crc) == hash;
+            err = lfs_index_insert(lfs, idir,
+                    dir->pair, entry->off, lfs_index_hash(crc));
+            if (err) {
+                // too many names, search directory without index
+                lfs_index_reset(lfs, idir, idir->head, false);
+            }
+        }
+
+        if (!found && match) {
+            int res = lfs_bd_cmp(lfs, dir->pair[0],
+                    entry->off + 4+entry->d.elen+entry->d.alen,
+                    name, len);
+            if (res < 0) {
+                return res;
+            }
+
+            if (res) {
+                found = true;
+                fdir = *dir;
+                fentry = *entry;
+            }
+        }
+
+        // keep going until all names are indexed
+        if (found && !idir->complete) {
+            break;
+        }
+    }
+
+    if (idir->complete) {
+        idir->tail[0] = dir->pair[0];
+        idir->tail[1] = dir->pair[1];
+    }
+
+    if (!found) {
+        return LFS_ERR_NOENT;
+    }
+
+    *dir = fdir;
+    *entry = fentry;
+    return true;
+}
+#endif
+
+static int lfs_index_find(lfs_t *lfs, lfs_dir_t *dir,
+        lfs_entry_t *entry, const char *name, lfs_size_t len) {
+    // remember directory, names appended to it are added to its index
+    dir->head[0] = dir->pair[0];
+    dir->head[1] = dir->pair[1];
+
+#if LFS_NAME_INDEX_DIRS > 0
+    if (!lfs->cfg->name_index) {
+        return false;
+    }
+
+    uint32_t crc = 0xffffffff;
+    lfs_crc(&crc, name, len);
+    uint16_t hash = lfs_index_hash(crc);
+
+    struct lfs_index_dir *idir = lfs_index_get(lfs, dir->pair);
+    if (idir) {
+        idir->used = ++lfs->index.used;
+        if (!idir->complete) {
+            // too many names to index
+            return false;
+        }
+
+        return lfs_index_match(lfs, idir, dir, entry, name, len, hash);
+    }
+
+    // index directory while searching it, replacing least recently used
+    idir = &lfs->index.dirs[0];
+    for (int i = 1; i < LFS_NAME_INDEX_DIRS &&
+            !lfs_pairisnull(idir->head); i++) {
+        if (lfs_pairisnull(lfs->index.dirs[i].head) ||
+                lfs->index.used - lfs->index.dirs[i].used >
+                lfs->index.used - idir->used) {
+            idir = &lfs->index.dirs[i];
+        }
+    }
+
+    lfs_index_reset(lfs, idir, dir->pair, true);
+    int res = lfs_index_build(lfs, idir, dir, entry, name, len, hash);
+    if (res < 0 && res != LFS_ERR_NOENT) {
+        lfs_index_reset(lfs, idir,
+                (const lfs_block_t[2]){0xffffffff, 0xffffffff}, false);
+    }
+
+    return res;
+#else
+    (void)lfs;
+    (void)entry;
+    (void)name;
+    (void)len;
+    return false;
+#endif
+}
+
+static void lfs_index_append(lfs_t *lfs,
+        const lfs_dir_t *dir, const lfs_entry_t *entry, const void *name) {
+#if LFS_NAME_INDEX_DIRS > 0
+    struct lfs_index_dir *idir = lfs_index_get(lfs, dir->head);
+    if (!idir || !idir->complete) {
+        return;
+    }
+
+    uint32_t crc = 0xffffffff;
+    lfs_crc(&crc, name, entry->d.nlen);
+    int err = lfs_index_insert(lfs, idir,
+            dir->pair, entry->off, lfs_index_hash(crc));
+    if (err) {
+        lfs_index_reset(lfs, idir, idir->head, false);
+        return;
+    }
+
+    // only the last block of a directory doesn't continue in its tail
+    if (!(0x80000000 & dir->d.size)) {
+        idir->tail[0] = dir->pair[0];
+        idir->tail[1] = dir->pair[1];
+    }
+#else
+    (void)lfs;
+    (void)dir;
+    (void)entry;
+    (void)name;
+#endif
+}
+
+static void lfs_index_remove(lfs_t *lfs,
+        const lfs_dir_t *dir, const lfs_entry_t *entry) {
+#if LFS_NAME_INDEX_DIRS > 0
+    if (!lfs->cfg->name_index) {
+        return;
+    }
+
+    lfs_size_t size = lfs_index_size(lfs);
+    for (int i = 0; i < LFS_NAME_INDEX_DIRS; i++) {
+        struct lfs_index_dir *idir = &lfs->index.dirs[i];
+        if (lfs_pairisnull(idir->head) || !idir->complete) {
+            continue;
+        }
+
+        // forget entry and shift over entries after it in the block
+        struct lfs_index_slot *slots = lfs_index_slots(lfs, idir);
+        for (lfs_size_t j = 0; j < size; j++) {
+            if (!lfs_pairisnull(slots[j].pair) &&
+                    lfs_paircmp(slots[j].pair, dir->pair) == 0 &&
+                    slots[j].off == entry->off) {
+                lfs_index_delete(lfs, idir, j);
+                break;
+            }
+        }
+
+        for (lfs_size_t j = 0; j < size; j++) {
+            if (!lfs_pairisnull(slots[j].pair) &&
+                    lfs_paircmp(slots[j].pair, dir->pair) == 0 &&
+                    slots[j].off > entry->off) {
+                slots[j].off -= lfs_entry_size(entry);
+            }
+        }
+    }
+#else
+    (void)lfs;
+    (void)dir;
+    (void)entry;
+#endif
+}
+
+static void lfs_index_drop(lfs_t *lfs, const lfs_block_t pair[2]) {
+#if LFS_NAME_INDEX_DIRS > 0
+    if (!lfs->cfg->name_index) {
+        return;
+    }
+
+    // forget directories starting, ending or holding names in a dropped block
+    lfs_size_t size = lfs_index_size(lfs);
+    for (int i = 0; i < LFS_NAME_INDEX_DIRS; i++) {
+        struct lfs_index_dir *idir = &lfs->index.dirs[i];
+        if (lfs_pairisnull(idir->head)) {
+            continue;
+        }
+
+        bool dropped = lfs_paircmp(idir->head, pair) == 0 ||
+                (!lfs_pairisnull(idir->tail) &&
+                 lfs_paircmp(idir->tail, pair) == 0);
+        struct lfs_index_slot *slots = lfs_index_slots(lfs, idir);
+        for (lfs_size_t j = 0; j < size && !dropped; j++) {
+            dropped = !lfs_pairisnull(slots[j].pair) &&
+                    lfs_paircmp(slots[j].pair, pair) == 0;
+        }
+
+        if (dropped) {
+            lfs_index_reset(lfs, idir,
+                    (const lfs_block_t[2]){0xffffffff, 0xffffffff}, false);
+        }
+    }
+#else
+    (void)lfs;
+    (void)pair;
+#endif
+}
+
+static void lfs_index_clear(lfs_t *lfs) {
+#if LFS_NAME_INDEX_DIRS > 0
+    if (!lfs->cfg->name_index) {
+        return;
+    }
+
+    for (int i = 0; i < LFS_NAME_INDEX_DIRS; i++) {
+        lfs_index_reset(lfs, &lfs->index.dirs[i],
+                (const lfs_block_t[2]){0xffffffff, 0xffffffff}, false);
+    }
+#else
+    (void)lfs;
+#endif
+}
+
+
 /// Top level directory operations ///
 int lfs_mkdir(lfs_t *lfs, const char *path) {
     // deorphan if we haven't yet, needed at most once after poweron
@@ -1116,19 +1629,10 @@ static int lfs_ctz_index(lfs_t *lfs, lfs_off_t *off) {
     return i;
 }
 
-static int lfs_ctz_find(lfs_t *lfs,
+static int lfs_ctz_skip(lfs_t *lfs,
         lfs_cache_t *rcache, const lfs_cache_t *pcache,
-        lfs_block_t head, lfs_size_t size,
-        lfs_size_t pos, lfs_block_t *block, lfs_off_t *off) {
-    if (size == 0) {
-        *block = 0xffffffff;
-        *off = 0;
-        return 0;
-    }
-
-    lfs_off_t current = lfs_ctz_index(lfs, &(lfs_off_t){size-1});
-    lfs_off_t target = lfs_ctz_index(lfs, &pos);
-
+        lfs_block_t head, lfs_off_t current, lfs_off_t target,
+        lfs_block_t *block) {
     while (current > target) {
         lfs_size_t skip = lfs_min(
                 lfs_npw2(current-target+1) - 1,
@@ -1145,6 +1649,27 @@ static int lfs_ctz_find(lfs_t *lfs,
     }
 
     *block = head;
+    return 0;
+}
+
+static int lfs_ctz_find(lfs_t *lfs,
+        lfs_cache_t *rcache, const lfs_cache_t *pcache,
+        lfs_block_t head, lfs_size_t size,
+        lfs_size_t pos, lfs_block_t *block, lfs_off_t *off) {
+    if (size == 0) {
+        *block = 0xffffffff;
+        *off = 0;
+        return 0;
+    }
+
+    lfs_off_t current = lfs_ctz_index(lfs, &(lfs_off_t){size-1});
+    lfs_off_t target = lfs_ctz_index(lfs, &pos);
+
+    int err = lfs_ctz_skip(lfs, rcache, pcache, head, current, target, block);
+    if (err) {
+        return err;
+    }
+
     *off = pos;
     return 0;
 }
@@ -1247,6 +1772,53 @@ relocate:
     }
 }
 
+static int lfs_ctz_free(lfs_t *lfs, const lfs_cache_t *pcache,
+        lfs_block_t ohead, lfs_size_t osize,
+        lfs_block_t nhead, lfs_size_t nsize) {
+    if (osize == 0) {
+        return 0;
+    }
+
+    lfs_off_t oindex = lfs_ctz_index(lfs, &(lfs_off_t){osize-1});
+    lfs_off_t nindex = 0;
+    if (nsize != 0) {
+        nindex = lfs_ctz_index(lfs, &(lfs_off_t){nsize-1});
+    }
+
+    while (true) {
+        // walk down new list to the current block of old list
+        while (nsize != 0 && nindex > oindex) {
+            int err = lfs_cache_read(lfs, &lfs->rcache, pcache,
+                    nhead, 0, &nhead, 4);
+            nhead = lfs_fromle32(nhead);
+            if (err) {
+                return err;
+            }
+
+            nindex -= 1;
+        }
+
+        // lists are the same from a shared block on
+        if (nsize != 0 && nindex == oindex && nhead == ohead) {
+            return 0;
+        }
+
+        lfs_alloc_free(lfs, ohead);
+        if (oindex == 0) {
+            return 0;
+        }
+
+        int err = lfs_cache_read(lfs, &lfs->rcache, NULL,
+                ohead, 0, &ohead, 4);
+        ohead = lfs_fromle32(ohead);
+        if (err) {
+            return err;
+        }
+
+        oindex -= 1;
+    }
+}
+
 static int lfs_ctz_traverse(lfs_t *lfs,
         lfs_cache_t *rcache, const lfs_cache_t *pcache,
         lfs_block_t head, lfs_size_t size,
@@ -1289,6 +1861,130 @@ static int lfs_ctz_traverse(lfs_t *lfs,
 }
 
 
+/// File skip-list cache operations ///
+static int lfs_file_ctzfind(lfs_t *lfs, lfs_file_t *file,
+        lfs_size_t pos, lfs_block_t *block, lfs_off_t *off) {
+#if LFS_CTZ_CACHE_SIZE > 0
+    if (file->size == 0) {
+        return lfs_ctz_find(lfs, &file->cache, NULL,
+                file->head, file->size, pos, block, off);
+    }
+
+    lfs_off_t current = lfs_ctz_index(lfs, &(lfs_off_t){file->size-1});
+    lfs_off_t target = lfs_ctz_index(lfs, &pos);
+    lfs_block_t head = file->head;
+
+    // start from the closest remembered block at or after the target
+    lfs_size_t i = file->ctz_count;
+    for (lfs_size_t j = 0; j < file->ctz_count; j++) {
+        if (file->ctz_cache[j].index >= target &&
+                file->ctz_cache[j].index <= current) {
+            current = file->ctz_cache[j].index;
+            head = file->ctz_cache[j].block;
+            i = j;
+        }
+    }
+
+    int err = lfs_ctz_skip(lfs, &file->cache, NULL,
+            head, current, target, block);
+    if (err) {
+        return err;
+    }
+
+    // remember target as most recently used, replacing least recently used
+    if (i == file->ctz_count || file->ctz_cache[i].index != target) {
+        if (file->ctz_count < LFS_CTZ_CACHE_SIZE) {
+            file->ctz_count += 1;
+        }
+
+        i = file->ctz_count-1;
+    }
+
+    memmove(&file->ctz_cache[1], &file->ctz_cache[0],
+            i*sizeof(file->ctz_cache[0]));
+    file->ctz_cache[0].index = target;
+    file->ctz_cache[0].block = *block;
+
+    *off = pos;
+    return 0;
+#else
+    return lfs_ctz_find(lfs, &file->cache, NULL,
+            file->head, file->size, pos, block, off);
+#endif
+}
+
+static void lfs_file_ctzdrop(lfs_file_t *file, lfs_off_t index) {
+#if LFS_CTZ_CACHE_SIZE > 0
+    // forget blocks from index on, they are being replaced
+    lfs_size_t j = 0;
+    for (lfs_size_t i = 0; i < file->ctz_count; i++) {
+        if (file->ctz_cache[i].index < index) {
+            file->ctz_cache[j] = file->ctz_cache[i];
+            j += 1;
+        }
+    }
+
+    file->ctz_count = j;
+#else
+    (void)file;
+    (void)index;
+#endif
+}
+
+
+/// Free map operations ///
+static bool lfs_file_isused(lfs_t *lfs,
+        const lfs_file_t *file, lfs_block_t head) {
+    // other open files may still use the old blocks of a file,
+    // or share blocks with it while being written
+    for (lfs_file_t *f = lfs->files; f; f = f->next) {
+        if (f != file && (f->head == head ||
+                (f->flags & (LFS_F_DIRTY | LFS_F_WRITING)))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool lfs_dir_isused(lfs_t *lfs, const lfs_block_t pair[2]) {
+    for (lfs_dir_t *d = lfs->dirs; d; d = d->next) {
+        if (lfs_paircmp(d->head, pair) == 0 ||
+                lfs_paircmp(d->pair, pair) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int lfs_entry_free(lfs_t *lfs, const lfs_entry_t *entry) {
+    // return blocks of a removed entry to the free map
+    if (!lfs->cfg->free_map) {
+        return 0;
+    }
+
+    if (entry->d.type == LFS_TYPE_REG) {
+        if (lfs_file_isused(lfs, NULL, entry->d.u.file.head)) {
+            return 0;
+        }
+
+        return lfs_ctz_traverse(lfs, &lfs->rcache, NULL,
+                entry->d.u.file.head, entry->d.u.file.size,
+                lfs_alloc_freecb, lfs);
+    } else if (entry->d.type == LFS_TYPE_DIR) {
+        if (lfs_dir_isused(lfs, entry->d.u.dir)) {
+            return 0;
+        }
+
+        lfs_alloc_free(lfs, entry->d.u.dir[0]);
+        lfs_alloc_free(lfs, entry->d.u.dir[1]);
+    }
+
+    return 0;
+}
+
+
 /// Top level file operations ///
 int lfs_file_open(lfs_t *lfs, lfs_file_t *file,
         const char *path, int flags) {
@@ -1343,6 +2039,9 @@ int lfs_file_open(lfs_t *lfs, lfs_file_t *file,
     file->size = entry.d.u.file.size;
     file->flags = flags;
     file->pos = 0;
+#if LFS_CTZ_CACHE_SIZE > 0
+    file->ctz_count = 0;
+#endif
 
     if (flags & LFS_O_TRUNC) {
         if (file->size != 0) {
@@ -1538,6 +2237,8 @@ int lfs_file_sync(lfs_t *lfs, lfs_file_t *file) {
         }
 
         LFS_ASSERT(entry.d.type == LFS_TYPE_REG);
+        lfs_block_t ohead = entry.d.u.file.head;
+        lfs_size_t osize = entry.d.u.file.size;
         entry.d.u.file.head = file->head;
         entry.d.u.file.size = file->size;
 
@@ -1547,6 +2248,15 @@ int lfs_file_sync(lfs_t *lfs, lfs_file_t *file) {
         }
 
         file->flags &= ~LFS_F_DIRTY;
+
+        // return blocks no longer in the file to the free map
+        if (lfs->cfg->free_map && !lfs_file_isused(lfs, file, ohead)) {
+            err = lfs_ctz_free(lfs, &file->cache,
+                    ohead, osize, file->head, file->size);
+            if (err) {
+                return err;
+            }
+        }
     }
 
     return 0;
@@ -1581,8 +2291,7 @@ lfs_ssize_t lfs_file_read(lfs_t *lfs, lfs_file_t *file,
         // check if we need a new block
         if (!(file->flags & LFS_F_READING) ||
                 file->off == lfs->cfg->block_size) {
-            int err = lfs_ctz_find(lfs, &file->cache, NULL,
-                    file->head, file->size,
+            int err = lfs_file_ctzfind(lfs, file,
                     file->pos, &file->block, &file->off);
             if (err) {
                 return err;
@@ -1648,8 +2357,7 @@ lfs_ssize_t lfs_file_write(lfs_t *lfs, lfs_file_t *file,
                 file->off == lfs->cfg->block_size) {
             if (!(file->flags & LFS_F_WRITING) && file->pos > 0) {
                 // find out which block we're extending from
-                int err = lfs_ctz_find(lfs, &file->cache, NULL,
-                        file->head, file->size,
+                int err = lfs_file_ctzfind(lfs, file,
                         file->pos-1, &file->block, &file->off);
                 if (err) {
                     file->flags |= LFS_F_ERRED;
@@ -1658,6 +2366,12 @@ lfs_ssize_t lfs_file_write(lfs_t *lfs, lfs_file_t *file,
 
                 // mark cache as dirty since we may have read data into it
                 file->cache.block = 0xffffffff;
+
+                // blocks from the one we're extending from are replaced
+                lfs_file_ctzdrop(file,
+                        lfs_ctz_index(lfs, &(lfs_off_t){file->pos-1}));
+            } else if (!(file->flags & LFS_F_WRITING)) {
+                lfs_file_ctzdrop(file, 0);
             }
 
             // extend file with new blocks
@@ -1749,13 +2463,14 @@ int lfs_file_truncate(lfs_t *lfs, lfs_file_t *file, lfs_off_t size) {
         }
 
         // lookup new head in ctz skip list
-        err = lfs_ctz_find(lfs, &file->cache, NULL,
-                file->head, file->size,
+        err = lfs_file_ctzfind(lfs, file,
                 size, &file->head, &(lfs_off_t){0});
         if (err) {
             return err;
         }
 
+        lfs_file_ctzdrop(file, lfs_ctz_index(lfs, &(lfs_off_t){size})+1);
+
         file->size = size;
         file->flags |= LFS_F_DIRTY;
     } else if (size > oldsize) {
@@ -1900,9 +2615,11 @@ int lfs_remove(lfs_t *lfs, const char *path) {
         if (err) {
             return err;
         }
+
+        lfs_index_drop(lfs, dir.pair);
     }
 
-    return 0;
+    return lfs_entry_free(lfs, &entry);
 }
 
 int lfs_rename(lfs_t *lfs, const char *oldpath, const char *newpath) {
@@ -2017,6 +2734,14 @@ int lfs_rename(lfs_t *lfs, const char *oldpath, const char *newpath) {
         if (err) {
             return err;
         }
+
+        lfs_index_drop(lfs, dir.pair);
+    }
+
+    // free replaced entry, unless renamed onto itself
+    if (prevexists && memcmp(&preventry.d.u, &oldentry.d.u,
+            sizeof(preventry.d.u)) != 0) {
+        return lfs_entry_free(lfs, &preventry);
     }
 
     return 0;
@@ -2050,16 +2775,40 @@ static int lfs_init(lfs_t *lfs, const struct lfs_config *cfg) {
     }
 
     // setup lookahead, round down to nearest 32-bits
-    LFS_ASSERT(lfs->cfg->lookahead % 32 == 0);
-    LFS_ASSERT(lfs->cfg->lookahead > 0);
-    if (lfs->cfg->lookahead_buffer) {
-        lfs->free.buffer = lfs->cfg->lookahead_buffer;
-    } else {
-        lfs->free.buffer = lfs_malloc(lfs->cfg->lookahead/8);
+    if (lfs->cfg->free_map) {
+        // or free map of whole device
+        lfs->free.buffer = lfs_malloc(4*((lfs->cfg->block_count+31)/32));
         if (!lfs->free.buffer) {
             return LFS_ERR_NOMEM;
         }
+    } else {
+        LFS_ASSERT(lfs->cfg->lookahead % 32 == 0);
+        LFS_ASSERT(lfs->cfg->lookahead > 0);
+        if (lfs->cfg->lookahead_buffer) {
+            lfs->free.buffer = lfs->cfg->lookahead_buffer;
+        } else {
+            lfs->free.buffer = lfs_malloc(lfs->cfg->lookahead/8);
+            if (!lfs->free.buffer) {
+                return LFS_ERR_NOMEM;
+            }
+        }
+    }
+
+#if LFS_NAME_INDEX_DIRS > 0
+    // setup name index
+    if (lfs->cfg->name_index) {
+        // offsets in the index are 16-bits
+        LFS_ASSERT(lfs->cfg->block_size <= 0x10000);
+        lfs->index.slots = lfs_malloc(LFS_NAME_INDEX_DIRS*
+                lfs_index_size(lfs)*sizeof(struct lfs_index_slot));
+        if (!lfs->index.slots) {
+            return LFS_ERR_NOMEM;
+        }
+
+        lfs->index.used = 0;
+        lfs_index_clear(lfs);
     }
+#endif
 
     // check that program and read sizes are multiples of the block size
     LFS_ASSERT(lfs->cfg->prog_size % lfs->cfg->read_size == 0);
@@ -2089,10 +2838,16 @@ static int lfs_deinit(lfs_t *lfs) {
         lfs_free(lfs->pcache.buffer);
     }
 
-    if (!lfs->cfg->lookahead_buffer) {
+    if (lfs->cfg->free_map || !lfs->cfg->lookahead_buffer) {
         lfs_free(lfs->free.buffer);
     }
 
+#if LFS_NAME_INDEX_DIRS > 0
+    if (lfs->cfg->name_index) {
+        lfs_free(lfs->index.slots);
+    }
+#endif
+
     return 0;
 }
 
@@ -2103,9 +2858,14 @@ int lfs_format(lfs_t *lfs, const struct lfs_config *cfg) {
     }
 
     // create free lookahead
-    memset(lfs->free.buffer, 0, lfs->cfg->lookahead/8);
-    lfs->free.off = 0;
-    lfs->free.size = lfs_min(lfs->cfg->lookahead, lfs->cfg->block_count);
+    if (lfs->cfg->free_map) {
+        lfs_alloc_clear(lfs);
+        lfs->free.count = lfs->cfg->block_count;
+    } else {
+        memset(lfs->free.buffer, 0, lfs->cfg->lookahead/8);
+        lfs->free.off = 0;
+        lfs->free.size = lfs_min(lfs->cfg->lookahead, lfs->cfg->block_count);
+    }
     lfs->free.index = 0;
     lfs_alloc_ack(lfs);
 
@@ -2221,6 +2981,14 @@ int lfs_mount(lfs_t *lfs, const struct lfs_config *cfg) {
         return LFS_ERR_INVAL;
     }
 
+    // build free map
+    if (lfs->cfg->free_map) {
+        err = lfs_alloc_scan(lfs);
+        if (err) {
+            return err;
+        }
+    }
+
     return 0;
 }
 
@@ -55,6 +55,28 @@ typedef uint32_t lfs_block_t;
 #define LFS_NAME_MAX 255
 #endif
 
+// Number of blocks of a file's skip-list remembered while the file is open,
+// so seeking back to them doesn't walk the skip-list from the file's head.
+// Takes 8 bytes per block per open file, 0 disables the cache
+#ifndef LFS_CTZ_CACHE_SIZE
+#ifdef MBED_LFS_CTZ_CACHE_SIZE
+#define LFS_CTZ_CACHE_SIZE MBED_LFS_CTZ_CACHE_SIZE
+#else
+#define LFS_CTZ_CACHE_SIZE 4
+#endif
+#endif
+
+// Number of directories indexed at once by the name index, if the name
+// index is enabled in the config. Least recently looked up directories are
+// dropped from the index first, 0 removes the name index
+#ifndef LFS_NAME_INDEX_DIRS
+#ifdef MBED_LFS_NAME_INDEX_DIRS
+#define LFS_NAME_INDEX_DIRS MBED_LFS_NAME_INDEX_DIRS
+#else
+#define LFS_NAME_INDEX_DIRS 2
+#endif
+#endif
+
 // Possible error codes, these are negative to allow
 // valid positive return values
 enum lfs_error {
@@ -171,6 +193,21 @@ struct lfs_config {
     // Optional, statically allocated buffer for files. Must be program sized.
     // If enabled, only one file may be opened at a time.
     void *file_buffer;
+
+    // Optional, track the free blocks of the whole device instead of a
+    // lookahead window. The free map is built when mounting and updated as
+    // blocks are allocated and freed, so allocation only traverses the
+    // filesystem if the map runs out of free blocks. The map requires 1 bit
+    // per block, and replaces the lookahead buffer.
+    bool free_map;
+
+    // Optional, number of names in each directory kept in an in-ram hash
+    // index, so looking up a path doesn't scan the whole directory. A
+    // directory is indexed the first time it is searched, and directories
+    // with more names than this are searched without the index. Takes 18
+    // bytes per name for each of the LFS_NAME_INDEX_DIRS directories. Block
+    // size must not exceed 64KiB, 0 disables the index.
+    lfs_size_t name_index;
 };
 
 
@@ -225,6 +262,14 @@ typedef struct lfs_file {
     lfs_block_t block;
     lfs_off_t off;
     lfs_cache_t cache;
+
+#if LFS_CTZ_CACHE_SIZE > 0
+    lfs_size_t ctz_count;
+    struct lfs_ctz_entry {
+        lfs_off_t index;
+        lfs_block_t block;
+    } ctz_cache[LFS_CTZ_CACHE_SIZE];
+#endif
 } lfs_file_t;
 
 typedef struct lfs_dir {
@@ -264,8 +309,31 @@ typedef struct lfs_free {
     lfs_block_t index;
     lfs_block_t ack;
     uint32_t *buffer;
+
+    // free map state
+    lfs_block_t count;
+    lfs_block_t acked;
 } lfs_free_t;
 
+#if LFS_NAME_INDEX_DIRS > 0
+typedef struct lfs_index {
+    struct lfs_index_dir {
+        lfs_block_t head[2];
+        lfs_block_t tail[2];
+        lfs_size_t count;
+        uint32_t used;
+        bool complete;
+    } dirs[LFS_NAME_INDEX_DIRS];
+
+    struct lfs_index_slot {
+        lfs_block_t pair[2];
+        uint16_t off;
+        uint16_t hash;
+    } *slots;
+    uint32_t used;
+} lfs_index_t;
+#endif
+
 // The littlefs type
 typedef struct lfs {
     const struct lfs_config *cfg;
@@ -279,6 +347,10 @@ typedef struct lfs {
 
     lfs_free_t free;
     bool deorphaned;
+
+#if LFS_NAME_INDEX_DIRS > 0
+    lfs_index_t index;
+#endif
 } lfs_t;
 
 
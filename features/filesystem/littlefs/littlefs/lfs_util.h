@@ -19,6 +19,7 @@
 #define LFS_UTIL_H
 
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdbool.h>
 #include <string.h>
 
@@ -0,0 +1,178 @@
+#!/bin/bash
+set -eu
+
+NAMES=300
+
+echo "=== Name index tests ==="
+rm -rf blocks
+tests/test.py << TEST
+    lfs_format(&lfs, &cfg) => 0;
+TEST
+
+echo "--- Directory setup ---"
+tests/test.py << TEST
+    lfs_mount(&lfs, &cfg) => 0;
+    lfs_mkdir(&lfs, "sensors") => 0;
+    lfs_mkdir(&lfs, "logs") => 0;
+    memset(buffer, 'x', sizeof(buffer));
+    for (int i = 0; i < $NAMES; i++) {
+        sprintf((char*)wbuffer, "sensors/s%03d", i);
+        lfs_file_open(&lfs, &file[0], (char*)wbuffer,
+                LFS_O_WRONLY | LFS_O_CREAT | LFS_O_EXCL) => 0;
+        lfs_file_write(&lfs, &file[0], buffer, i) => i;
+        lfs_file_close(&lfs, &file[0]) => 0;
+    }
+    lfs_unmount(&lfs) => 0;
+TEST
+
+echo "--- Name lookup tests ---"
+for NAME_INDEX in $NAMES 16 0
+do
+tests/test.py << TEST
+    struct lfs_config icfg = cfg;
+    icfg.name_index = $NAME_INDEX;
+    lfs_mount(&lfs, &icfg) => 0;
+    for (int i = 0; i < $NAMES; i++) {
+        sprintf((char*)wbuffer, "sensors/s%03d", i);
+        lfs_stat(&lfs, (char*)wbuffer, &info) => 0;
+        info.size => i;
+        sprintf((char*)wbuffer, "logs/../sensors/./s%03d", $NAMES-1-i);
+        lfs_stat(&lfs, (char*)wbuffer, &info) => 0;
+        info.size => $NAMES-1-i;
+    }
+    lfs_stat(&lfs, "sensors/s$NAMES", &info) => LFS_ERR_NOENT;
+    lfs_stat(&lfs, "sensors/s00", &info) => LFS_ERR_NOENT;
+    lfs_stat(&lfs, "sensors/s0000", &info) => LFS_ERR_NOENT;
+    lfs_stat(&lfs, "logs/s000", &info) => LFS_ERR_NOENT;
+    lfs_file_open(&lfs, &file[0], "sensors/s000",
+            LFS_O_WRONLY | LFS_O_CREAT | LFS_O_EXCL) => LFS_ERR_EXIST;
+    lfs_unmount(&lfs) => 0;
+TEST
+done
+
+echo "--- Name lookup benchmark ---"
+tests/test.py << TEST
+    struct lfs_config icfg = cfg;
+    uintmax_t reads[2];
+    for (int j = 0; j < 2; j++) {
+        icfg.name_index = j ? $NAMES : 0;
+        lfs_mount(&lfs, &icfg) => 0;
+        reads[j] = bd.stats.read_count;
+        for (int i = 0; i < $NAMES; i++) {
+            sprintf((char*)wbuffer, "sensors/s%03d", (i*7) % $NAMES);
+            lfs_stat(&lfs, (char*)wbuffer, &info) => 0;
+        }
+        reads[j] = bd.stats.read_count - reads[j];
+        lfs_unmount(&lfs) => 0;
+    }
+    test_log("unindexed reads", reads[0]);
+    test_log("indexed reads", reads[1]);
+    reads[1] < reads[0]/2 => true;
+TEST
+
+echo "--- Name index update tests ---"
+tests/test.py << TEST
+    struct lfs_config icfg = cfg;
+    icfg.name_index = $NAMES;
+    lfs_mount(&lfs, &icfg) => 0;
+    lfs_stat(&lfs, "logs/l000", &info) => LFS_ERR_NOENT;
+    lfs_stat(&lfs, "sensors/s000", &info) => 0;
+    memset(buffer, 'x', sizeof(buffer));
+    for (int i = 0; i < $NAMES; i++) {
+        sprintf((char*)wbuffer, "sensors/s%03d", i);
+        if (i % 3 == 0) {
+            lfs_remove(&lfs, (char*)wbuffer) => 0;
+        } else if (i % 3 == 1) {
+            sprintf((char*)rbuffer, "sensors/r%03d", i);
+            lfs_rename(&lfs, (char*)wbuffer, (char*)rbuffer) => 0;
+        } else if (i < 30) {
+            sprintf((char*)rbuffer, "logs/l%03d", i);
+            lfs_rename(&lfs, (char*)wbuffer, (char*)rbuffer) => 0;
+        }
+
+        if (i % 5 == 0) {
+            sprintf((char*)wbuffer, "sensors/n%03d", i);
+            lfs_file_open(&lfs, &file[0], (char*)wbuffer,
+                    LFS_O_WRONLY | LFS_O_CREAT | LFS_O_EXCL) => 0;
+            lfs_file_write(&lfs, &file[0], buffer, i) => i;
+            lfs_file_close(&lfs, &file[0]) => 0;
+        }
+    }
+    lfs_mkdir(&lfs, "sensors/sub") => 0;
+    lfs_mkdir(&lfs, "logs/sub") => 0;
+    lfs_mkdir(&lfs, "sensors/sub") => LFS_ERR_EXIST;
+    lfs_unmount(&lfs) => 0;
+TEST
+
+for NAME_INDEX in $NAMES 16 0
+do
+tests/test.py << TEST
+    struct lfs_config icfg = cfg;
+    icfg.name_index = $NAME_INDEX;
+    lfs_mount(&lfs, &icfg) => 0;
+    for (int i = 0; i < $NAMES; i++) {
+        sprintf((char*)wbuffer, "sensors/s%03d", i);
+        lfs_stat(&lfs, (char*)wbuffer, &info)
+                => (i % 3 == 2 && i >= 30) ? 0 : LFS_ERR_NOENT;
+        sprintf((char*)wbuffer, "sensors/r%03d", i);
+        lfs_stat(&lfs, (char*)wbuffer, &info)
+                => (i % 3 == 1) ? 0 : LFS_ERR_NOENT;
+        sprintf((char*)wbuffer, "logs/l%03d", i);
+        lfs_stat(&lfs, (char*)wbuffer, &info)
+                => (i % 3 == 2 && i < 30) ? 0 : LFS_ERR_NOENT;
+        sprintf((char*)wbuffer, "sensors/n%03d", i);
+        lfs_stat(&lfs, (char*)wbuffer, &info)
+                => (i % 5 == 0) ? 0 : LFS_ERR_NOENT;
+    }
+
+    lfs_dir_open(&lfs, &dir[0], "sensors") => 0;
+    size = 0;
+    while (lfs_dir_read(&lfs, &dir[0], &info) > 0) {
+        size += 1;
+    }
+    size => 2 + ($NAMES/3) + ($NAMES/3 - 10) + ($NAMES/5) + 1;
+    lfs_dir_close(&lfs, &dir[0]) => 0;
+
+    lfs_dir_open(&lfs, &dir[0], "logs") => 0;
+    size = 0;
+    while (lfs_dir_read(&lfs, &dir[0], &info) > 0) {
+        size += 1;
+    }
+    size => 2 + 10 + 1;
+    lfs_dir_close(&lfs, &dir[0]) => 0;
+
+    lfs_stat(&lfs, "sensors/sub", &info) => 0;
+    info.type => LFS_TYPE_DIR;
+    lfs_stat(&lfs, "logs/sub", &info) => 0;
+    info.type => LFS_TYPE_DIR;
+    lfs_unmount(&lfs) => 0;
+TEST
+done
+
+echo "--- Name index drop block tests ---"
+tests/test.py << TEST
+    struct lfs_config icfg = cfg;
+    icfg.name_index = $NAMES;
+    lfs_mount(&lfs, &icfg) => 0;
+    lfs_mkdir(&lfs, "drop") => 0;
+    for (int i = 0; i < 100; i++) {
+        sprintf((char*)wbuffer, "drop/f%03d", i);
+        lfs_file_open(&lfs, &file[0], (char*)wbuffer,
+                LFS_O_WRONLY | LFS_O_CREAT | LFS_O_EXCL) => 0;
+        lfs_file_close(&lfs, &file[0]) => 0;
+    }
+    lfs_stat(&lfs, "drop/f000", &info) => 0;
+    for (int i = 1; i < 99; i++) {
+        sprintf((char*)wbuffer, "drop/f%03d", i);
+        lfs_remove(&lfs, (char*)wbuffer) => 0;
+    }
+    for (int i = 0; i < 100; i++) {
+        sprintf((char*)wbuffer, "drop/f%03d", i);
+        lfs_stat(&lfs, (char*)wbuffer, &info)
+                => (i == 0 || i == 99) ? 0 : LFS_ERR_NOENT;
+    }
+    lfs_unmount(&lfs) => 0;
+TEST
+
+echo "--- Results ---"
+tests/stats.py
@@ -209,6 +209,61 @@ tests/test.py << TEST
     lfs_unmount(&lfs) => 0;
 TEST
 
+echo "--- Backward and random file seek ---"
+tests/test.py << TEST
+    lfs_mount(&lfs, &cfg) => 0;
+    lfs_file_open(&lfs, &file[0], "indexed",
+            LFS_O_RDWR | LFS_O_CREAT) => 0;
+
+    size = strlen("kitty000000");
+    static int tags[5*$LARGESIZE];
+    for (int i = 0; i < 4*$LARGESIZE; i++) {
+        sprintf((char*)buffer, "kitty%06d", i);
+        lfs_file_write(&lfs, &file[0], buffer, size) => size;
+        tags[i] = i;
+    }
+
+    for (int i = 4*$LARGESIZE-1; i >= 0; i--) {
+        lfs_file_seek(&lfs, &file[0], i*size, LFS_SEEK_SET) => i*size;
+        lfs_file_read(&lfs, &file[0], rbuffer, size) => size;
+        sprintf((char*)buffer, "kitty%06d", tags[i]);
+        memcmp(rbuffer, buffer, size) => 0;
+    }
+
+    srand(1);
+    for (int j = 0; j < 4*$LARGESIZE; j++) {
+        int i = rand() % (4*$LARGESIZE);
+        lfs_file_seek(&lfs, &file[0], i*size, LFS_SEEK_SET) => i*size;
+        if (rand() % 4 == 0) {
+            tags[i] = 5*$LARGESIZE + j;
+            sprintf((char*)buffer, "kitty%06d", tags[i]);
+            lfs_file_write(&lfs, &file[0], buffer, size) => size;
+        } else {
+            lfs_file_read(&lfs, &file[0], rbuffer, size) => size;
+            sprintf((char*)buffer, "kitty%06d", tags[i]);
+            memcmp(rbuffer, buffer, size) => 0;
+        }
+    }
+
+    lfs_file_seek(&lfs, &file[0], 0, LFS_SEEK_END) => 4*$LARGESIZE*size;
+    for (int i = 4*$LARGESIZE; i < 5*$LARGESIZE; i++) {
+        tags[i] = i;
+        sprintf((char*)buffer, "kitty%06d", tags[i]);
+        lfs_file_write(&lfs, &file[0], buffer, size) => size;
+    }
+
+    for (int i = 5*$LARGESIZE-1; i >= 0; i--) {
+        lfs_file_seek(&lfs, &file[0], i*size, LFS_SEEK_SET) => i*size;
+        lfs_file_read(&lfs, &file[0], rbuffer, size) => size;
+        sprintf((char*)buffer, "kitty%06d", tags[i]);
+        memcmp(rbuffer, buffer, size) => 0;
+    }
+
+    lfs_file_close(&lfs, &file[0]) => 0;
+    lfs_remove(&lfs, "indexed") => 0;
+    lfs_unmount(&lfs) => 0;
+TEST
+
 echo "--- Simple file seek and write ---"
 tests/test.py << TEST
     lfs_mount(&lfs, &cfg) => 0;
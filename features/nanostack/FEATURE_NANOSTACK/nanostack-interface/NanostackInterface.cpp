@@ -658,6 +658,107 @@ out:
     return ret;
 }
 
+nsapi_size_or_error_t NanostackInterface::socket_recvfrom_buffer(void *handle, SocketAddress *address, nsapi_buf_t *buffer)
+{
+    // Validate parameters
+    NanostackSocket *socket = static_cast<NanostackSocket *>(handle);
+    if (handle == NULL) {
+        MBED_ASSERT(false);
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    nsapi_size_or_error_t ret;
+
+    NanostackLockGuard lock;
+
+    if (socket->closed()) {
+        ret = NSAPI_ERROR_NO_CONNECTION;
+        goto out;
+    }
+
+    if (socket->proto != SOCKET_UDP) {
+        ret = NSAPI_ERROR_UNSUPPORTED;
+        goto out;
+    }
+
+    ns_address_t ns_address;
+    uint8_t peek;
+    void *data;
+
+    int retcode;
+    // Peek the full length of the pending datagram so the lent
+    // buffer can be sized to fit it exactly
+    retcode = ::socket_recvfrom(socket->socket_id, &peek, sizeof peek, NS_MSG_PEEK | NS_MSG_TRUNC, NULL);
+    if (retcode == NS_EWOULDBLOCK) {
+        ret = NSAPI_ERROR_WOULD_BLOCK;
+        goto out;
+    } else if (retcode < 0) {
+        ret = NSAPI_ERROR_PARAMETER;
+        goto out;
+    }
+
+    data = MALLOC(retcode ? retcode : 1);
+    if (!data) {
+        ret = NSAPI_ERROR_NO_MEMORY;
+        goto out;
+    }
+
+    retcode = ::socket_recvfrom(socket->socket_id, data, retcode, 0, &ns_address);
+    if (retcode < 0) {
+        FREE(data);
+        ret = NSAPI_ERROR_PARAMETER;
+        goto out;
+    }
+
+    buffer->data = data;
+    buffer->size = retcode;
+    buffer->handle = data;
+    ret = retcode;
+    if (address != NULL) {
+        convert_ns_addr_to_mbed(address, &ns_address);
+    }
+
+out:
+    tr_debug("socket_recvfrom_buffer(socket=%p) sock_id=%d, ret=%i", socket, socket->socket_id, ret);
+
+    return ret;
+}
+
+nsapi_error_t NanostackInterface::socket_alloc_buffer(void *handle, nsapi_size_t size, nsapi_buf_t *buffer)
+{
+    if (size > INT16_MAX) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    void *data = MALLOC(size ? size : 1);
+    if (!data) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    buffer->data = data;
+    buffer->size = size;
+    buffer->handle = data;
+    return 0;
+}
+
+nsapi_size_or_error_t NanostackInterface::socket_sendto_buffer(void *handle, const SocketAddress &address, nsapi_buf_t *buffer)
+{
+    nsapi_size_or_error_t ret = socket_sendto(handle, address, buffer->data, buffer->size);
+    if (ret >= 0) {
+        socket_free_buffer(handle, buffer);
+    }
+
+    return ret;
+}
+
+void NanostackInterface::socket_free_buffer(void *handle, nsapi_buf_t *buffer)
+{
+    FREE(buffer->handle);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->handle = NULL;
+}
+
 nsapi_error_t NanostackInterface::socket_bind(void *handle, const SocketAddress &address)
 {
     // Validate parameters
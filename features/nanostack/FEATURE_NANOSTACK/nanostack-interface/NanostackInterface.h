@@ -232,6 +232,46 @@ protected:
      */
     virtual nsapi_error_t getsockopt(void *handle, int level, int optname, void *optval, unsigned *optlen);
 
+    /** Receive a packet over a UDP socket without copying
+     *
+     *  Nanostack keeps received datagrams in its own private buffers, so
+     *  the datagram is read once into an exactly sized buffer from the
+     *  Nanostack heap which is then lent to the caller.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param buffer   Destination for the lent buffer
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvfrom_buffer(void *handle, SocketAddress *address, nsapi_buf_t *buffer);
+
+    /** Allocate a transmit buffer for a UDP socket
+     *
+     *  @param handle   Socket handle
+     *  @param size     Size of the payload in bytes
+     *  @param buffer   Destination for the allocated buffer
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual nsapi_error_t socket_alloc_buffer(void *handle, nsapi_size_t size, nsapi_buf_t *buffer);
+
+    /** Send a buffer over a UDP socket without copying
+     *
+     *  @param handle   Socket handle
+     *  @param address  The SocketAddress of the remote host
+     *  @param buffer   Buffer from socket_alloc_buffer
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_sendto_buffer(void *handle, const SocketAddress &address, nsapi_buf_t *buffer);
+
+    /** Return a buffer to the stack
+     *
+     *  @param handle   Socket handle
+     *  @param buffer   Buffer to release
+     */
+    virtual void socket_free_buffer(void *handle, nsapi_buf_t *buffer);
+
 private:
     nsapi_size_or_error_t do_sendto(void *handle, const struct ns_address *address, const void *data, nsapi_size_t size);
     char text_ip_address[40];
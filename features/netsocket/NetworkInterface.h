@@ -123,6 +123,41 @@ public:
     virtual nsapi_error_t gethostbyname(const char *host,
             SocketAddress *address, nsapi_version_t version = NSAPI_UNSPEC);
 
+    /** Hostname translation callback for gethostbyname_async
+     *
+     *  @param result   0 on success, negative error code on failure
+     *  @param address  On success, the resolved SocketAddress
+     */
+    typedef mbed::Callback<void (nsapi_error_t result, SocketAddress *address)> hostbyname_cb_t;
+
+    /** Translates a hostname to an IP address without blocking
+     *
+     *  The hostname may be either a domain name or an IP address. If the
+     *  hostname is an IP address or its translation is cached, no network
+     *  transactions are performed and the callback is called before this
+     *  call returns. Otherwise the callback is called from the shared
+     *  event queue once the translation completes.
+     *
+     *  @param host     Hostname to resolve
+     *  @param callback Callback that is called with the result
+     *  @param version  IP version of address to resolve, NSAPI_UNSPEC indicates
+     *                  version is chosen by the stack (defaults to NSAPI_UNSPEC)
+     *  @return         0 if the callback was already called, a positive unique
+     *                  id that can be passed to gethostbyname_async_cancel while
+     *                  the translation is in progress, or a negative error code
+     *                  on immediate failure, in which case the callback is not
+     *                  called
+     */
+    virtual nsapi_error_t gethostbyname_async(const char *host,
+            hostbyname_cb_t callback, nsapi_version_t version = NSAPI_UNSPEC);
+
+    /** Cancels an asynchronous hostname translation
+     *
+     *  @param id       Unique id returned by gethostbyname_async
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual nsapi_error_t gethostbyname_async_cancel(int id);
+
     /** Add a domain name server to list of servers to query
      *
      *  @param address  Destination for the host address
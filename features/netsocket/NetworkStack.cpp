@@ -45,6 +45,47 @@ nsapi_error_t NetworkStack::gethostbyname(const char *name, SocketAddress *addre
     return nsapi_dns_query(this, name, address, version);
 }
 
+nsapi_size_or_error_t NetworkStack::gethostbyname_dual(const char *name, SocketAddress *addresses, nsapi_size_t count)
+{
+    // check for simple ip addresses
+    if (count > 0 && addresses[0].set_ip_address(name)) {
+        return 1;
+    }
+
+    return nsapi_dns_query_dual(this, name, addresses, count);
+}
+
+nsapi_error_t NetworkStack::gethostbyname_async(const char *name, hostbyname_cb_t callback, nsapi_version_t version)
+{
+    SocketAddress address;
+
+    // check for simple ip addresses
+    if (address.set_ip_address(name)) {
+        if (version != NSAPI_UNSPEC && address.get_ip_version() != version) {
+            return NSAPI_ERROR_DNS_FAILURE;
+        }
+
+        callback(NSAPI_ERROR_OK, &address);
+        return NSAPI_ERROR_OK;
+    }
+
+    // if the version is unspecified, try to guess the version from the
+    // ip address of the underlying stack
+    if (version == NSAPI_UNSPEC) {
+        SocketAddress testaddress;
+        if (testaddress.set_ip_address(this->get_ip_address())) {
+            version = testaddress.get_ip_version();
+        }
+    }
+
+    return nsapi_dns_query_async(this, name, callback, version);
+}
+
+nsapi_error_t NetworkStack::gethostbyname_async_cancel(int id)
+{
+    return nsapi_dns_query_async_cancel(id);
+}
+
 nsapi_error_t NetworkStack::add_dns_server(const SocketAddress &address)
 {
     return nsapi_dns_add_server(address);
@@ -70,6 +111,72 @@ nsapi_error_t NetworkStack::getsockopt(void *handle, int level, int optname, voi
     return NSAPI_ERROR_UNSUPPORTED;
 }
 
+nsapi_size_or_error_t NetworkStack::socket_recvfrom_buffer(void *handle, SocketAddress *address, nsapi_buf_t *buffer)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
+nsapi_error_t NetworkStack::socket_alloc_buffer(void *handle, nsapi_size_t size, nsapi_buf_t *buffer)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_sendto_buffer(void *handle, const SocketAddress &address, nsapi_buf_t *buffer)
+{
+    return NSAPI_ERROR_UNSUPPORTED;
+}
+
+void NetworkStack::socket_free_buffer(void *handle, nsapi_buf_t *buffer)
+{
+}
+
+nsapi_size_or_error_t NetworkStack::socket_sendmmsg(void *handle, nsapi_mmsg_t *msgs, unsigned count)
+{
+    unsigned sent = 0;
+
+    while (sent < count) {
+        nsapi_mmsg_t *msg = &msgs[sent];
+        nsapi_size_or_error_t err = socket_sendto(handle,
+                SocketAddress(msg->addr, msg->port), msg->data, msg->size);
+        if (err < 0) {
+            if (sent == 0) {
+                return err;
+            }
+            break;
+        }
+
+        msg->len = err;
+        sent += 1;
+    }
+
+    return sent;
+}
+
+nsapi_size_or_error_t NetworkStack::socket_recvmmsg(void *handle, nsapi_mmsg_t *msgs, unsigned count)
+{
+    unsigned recv = 0;
+
+    while (recv < count) {
+        nsapi_mmsg_t *msg = &msgs[recv];
+        SocketAddress address;
+        nsapi_size_or_error_t err = socket_recvfrom(handle,
+                &address, msg->data, msg->size);
+        if (err < 0) {
+            if (recv == 0) {
+                return err;
+            }
+            break;
+        }
+
+        msg->addr = address.get_addr();
+        msg->port = address.get_port();
+        msg->len = err;
+        recv += 1;
+    }
+
+    return recv;
+}
+
 
 // NetworkStackWrapper class for encapsulating the raw nsapi_stack structure
 class NetworkStackWrapper : public NetworkStack
@@ -111,6 +218,43 @@ public:
         return err;
     }
 
+    virtual nsapi_size_or_error_t gethostbyname_dual(const char *name, SocketAddress *addresses, nsapi_size_t count)
+    {
+        if (!_stack_api()->gethostbyname) {
+            return NetworkStack::gethostbyname_dual(name, addresses, count);
+        }
+
+        if (count == 0) {
+            return NSAPI_ERROR_PARAMETER;
+        }
+
+        // ask the stack's own resolver, which uses the servers set up by
+        // DHCP, for each version in turn so both families can be raced
+        static const nsapi_version_t versions[] = {NSAPI_IPv6, NSAPI_IPv4};
+        nsapi_size_t found = 0;
+        nsapi_error_t err = NSAPI_ERROR_DNS_FAILURE;
+        for (unsigned i = 0; i < sizeof versions / sizeof versions[0] && found < count; i++) {
+            nsapi_addr_t addr = {NSAPI_UNSPEC, 0};
+            nsapi_error_t verr = _stack_api()->gethostbyname(_stack(), name, &addr, versions[i]);
+            if (verr) {
+                err = verr;
+                continue;
+            }
+
+            // a stack that ignores the version only gives one address
+            if (addr.version != versions[i]) {
+                if (found == 0) {
+                    addresses[found++].set_addr(addr);
+                }
+                break;
+            }
+
+            addresses[found++].set_addr(addr);
+        }
+
+        return found ? (nsapi_size_or_error_t)found : err;
+    }
+
     virtual nsapi_error_t add_dns_server(const SocketAddress &address)
     {
         if (!_stack_api()->add_dns_server) {
@@ -275,6 +419,70 @@ protected:
 
         return _stack_api()->getsockopt(_stack(), socket, level, optname, optval, optlen);
     }
+
+    virtual nsapi_size_or_error_t socket_recvfrom_buffer(nsapi_socket_t socket, SocketAddress *address, nsapi_buf_t *buffer)
+    {
+        if (!_stack_api()->socket_recvfrom_buffer) {
+            return NSAPI_ERROR_UNSUPPORTED;
+        }
+
+        nsapi_addr_t addr = {NSAPI_IPv4, 0};
+        uint16_t port = 0;
+
+        nsapi_size_or_error_t err = _stack_api()->socket_recvfrom_buffer(_stack(), socket, &addr, &port, buffer);
+
+        if (address) {
+            address->set_addr(addr);
+            address->set_port(port);
+        }
+
+        return err;
+    }
+
+    virtual nsapi_error_t socket_alloc_buffer(nsapi_socket_t socket, nsapi_size_t size, nsapi_buf_t *buffer)
+    {
+        if (!_stack_api()->socket_alloc_buffer) {
+            return NSAPI_ERROR_UNSUPPORTED;
+        }
+
+        return _stack_api()->socket_alloc_buffer(_stack(), socket, size, buffer);
+    }
+
+    virtual nsapi_size_or_error_t socket_sendto_buffer(nsapi_socket_t socket, const SocketAddress &address, nsapi_buf_t *buffer)
+    {
+        if (!_stack_api()->socket_sendto_buffer) {
+            return NSAPI_ERROR_UNSUPPORTED;
+        }
+
+        return _stack_api()->socket_sendto_buffer(_stack(), socket, address.get_addr(), address.get_port(), buffer);
+    }
+
+    virtual void socket_free_buffer(nsapi_socket_t socket, nsapi_buf_t *buffer)
+    {
+        if (!_stack_api()->socket_free_buffer) {
+            return;
+        }
+
+        return _stack_api()->socket_free_buffer(_stack(), socket, buffer);
+    }
+
+    virtual nsapi_size_or_error_t socket_sendmmsg(nsapi_socket_t socket, nsapi_mmsg_t *msgs, unsigned count)
+    {
+        if (!_stack_api()->socket_sendmmsg) {
+            return NetworkStack::socket_sendmmsg(socket, msgs, count);
+        }
+
+        return _stack_api()->socket_sendmmsg(_stack(), socket, msgs, count);
+    }
+
+    virtual nsapi_size_or_error_t socket_recvmmsg(nsapi_socket_t socket, nsapi_mmsg_t *msgs, unsigned count)
+    {
+        if (!_stack_api()->socket_recvmmsg) {
+            return NetworkStack::socket_recvmmsg(socket, msgs, count);
+        }
+
+        return _stack_api()->socket_recvmmsg(_stack(), socket, msgs, count);
+    }
 };
 
 
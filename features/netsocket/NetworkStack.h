@@ -60,6 +60,63 @@ public:
     virtual nsapi_error_t gethostbyname(const char *host,
             SocketAddress *address, nsapi_version_t version = NSAPI_UNSPEC);
 
+    /** Translates a hostname to IP addresses of both versions
+     *
+     *  Used by TCPSocket::connect to race the addresses of a host. By
+     *  default the A and AAAA records are queried at once using a UDP
+     *  socket on the stack. Stacks that provide their own name resolution
+     *  are asked for an IPv6 and then an IPv4 address, and only give a
+     *  single address if their resolver ignores the requested version.
+     *
+     *  @param host      Hostname to resolve
+     *  @param addresses Array for the host SocketAddresses
+     *  @param count     Number of addresses allocated in the array
+     *  @return          Number of addresses found on success, negative error
+     *                   code on failure
+     */
+    virtual nsapi_size_or_error_t gethostbyname_dual(const char *host,
+            SocketAddress *addresses, nsapi_size_t count);
+
+    /** Hostname translation callback for gethostbyname_async
+     *
+     *  @param result   0 on success, negative error code on failure
+     *  @param address  On success, the resolved SocketAddress
+     */
+    typedef mbed::Callback<void (nsapi_error_t result, SocketAddress *address)> hostbyname_cb_t;
+
+    /** Translates a hostname to an IP address without blocking
+     *
+     *  The hostname may be either a domain name or an IP address. If the
+     *  hostname is an IP address or its translation is cached, no network
+     *  transactions are performed and the callback is called before this
+     *  call returns. Otherwise the callback is called from the shared
+     *  event queue once the translation completes.
+     *
+     *  If no stack-specific DNS resolution is provided, the hostname
+     *  will be resolve using a UDP socket on the stack.
+     *
+     *  @param host     Hostname to resolve
+     *  @param callback Callback that is called with the result
+     *  @param version  IP version of address to resolve, NSAPI_UNSPEC indicates
+     *                  version is chosen by the stack (defaults to NSAPI_UNSPEC)
+     *  @return         0 if the callback was already called, a positive unique
+     *                  id that can be passed to gethostbyname_async_cancel while
+     *                  the translation is in progress, or a negative error code
+     *                  on immediate failure, in which case the callback is not
+     *                  called
+     */
+    virtual nsapi_error_t gethostbyname_async(const char *host,
+            hostbyname_cb_t callback, nsapi_version_t version = NSAPI_UNSPEC);
+
+    /** Cancels an asynchronous hostname translation
+     *
+     *  The callback of a cancelled translation is not called.
+     *
+     *  @param id       Unique id returned by gethostbyname_async
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual nsapi_error_t gethostbyname_async_cancel(int id);
+
     /** Add a domain name server to list of servers to query
      *
      *  @param address  Destination for the host address
@@ -299,6 +356,103 @@ protected:
      */
     virtual nsapi_error_t getsockopt(nsapi_socket_t handle, int level,
             int optname, void *optval, unsigned *optlen);
+
+    /** Receive a packet over a UDP socket without copying
+     *
+     *  Lends the next received packet to the caller and stores the source
+     *  address in address if address is not NULL. The buffer belongs to the
+     *  caller until it is released with socket_free_buffer.
+     *
+     *  This call is non-blocking. If recvfrom would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately. Stacks that cannot
+     *  lend their receive buffers return NSAPI_ERROR_UNSUPPORTED.
+     *
+     *  @param handle   Socket handle
+     *  @param address  Destination for the source address or NULL
+     *  @param buffer   Destination for the lent buffer
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_recvfrom_buffer(nsapi_socket_t handle,
+            SocketAddress *address, nsapi_buf_t *buffer);
+
+    /** Allocate a transmit buffer for a UDP socket
+     *
+     *  The buffer is allocated from the stack's own packet memory so it can
+     *  be passed to socket_sendto_buffer without copying the payload.
+     *
+     *  @param handle   Socket handle
+     *  @param size     Size of the payload in bytes
+     *  @param buffer   Destination for the allocated buffer
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual nsapi_error_t socket_alloc_buffer(nsapi_socket_t handle,
+            nsapi_size_t size, nsapi_buf_t *buffer);
+
+    /** Send a buffer over a UDP socket without copying
+     *
+     *  Sends the buffer to the specified address. On success the stack
+     *  takes back ownership of the buffer, on failure it remains with the
+     *  caller and may be sent again or freed.
+     *
+     *  This call is non-blocking. If sendto would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param address  The SocketAddress of the remote host
+     *  @param buffer   Buffer from socket_alloc_buffer
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    virtual nsapi_size_or_error_t socket_sendto_buffer(nsapi_socket_t handle,
+            const SocketAddress &address, nsapi_buf_t *buffer);
+
+    /** Return a buffer to the stack
+     *
+     *  Releases a buffer lent by socket_recvfrom_buffer or allocated by
+     *  socket_alloc_buffer.
+     *
+     *  @param handle   Socket handle
+     *  @param buffer   Buffer to release
+     */
+    virtual void socket_free_buffer(nsapi_socket_t handle, nsapi_buf_t *buffer);
+
+    /** Send a batch of packets over a UDP socket
+     *
+     *  Sends each datagram to its address in order, stopping at the first
+     *  datagram that cannot be sent. Returns the number of datagrams sent.
+     *  The default implementation calls socket_sendto for each datagram,
+     *  stacks can override it to amortise the per-datagram overhead.
+     *
+     *  This call is non-blocking. If no datagram can be sent without
+     *  blocking, NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param msgs     Array of datagrams to send
+     *  @param count    Number of datagrams in the array
+     *  @return         Number of sent datagrams on success, negative error
+     *                  code if no datagram could be sent
+     */
+    virtual nsapi_size_or_error_t socket_sendmmsg(nsapi_socket_t handle,
+            nsapi_mmsg_t *msgs, unsigned count);
+
+    /** Receive a batch of packets over a UDP socket
+     *
+     *  Receives up to count datagrams that are already queued on the
+     *  socket. Returns the number of datagrams received. The default
+     *  implementation calls socket_recvfrom for each datagram.
+     *
+     *  This call is non-blocking. If no datagram is queued,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param handle   Socket handle
+     *  @param msgs     Array of destinations for received datagrams
+     *  @param count    Number of entries in the array
+     *  @return         Number of received datagrams on success, negative
+     *                  error code if no datagram could be received
+     */
+    virtual nsapi_size_or_error_t socket_recvmmsg(nsapi_socket_t handle,
+            nsapi_mmsg_t *msgs, unsigned count);
 };
 
 
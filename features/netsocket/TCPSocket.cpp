@@ -21,6 +21,13 @@
 #define READ_FLAG           0x1u
 #define WRITE_FLAG          0x2u
 
+// Addresses raced by connect(host, port)
+#define TCP_CONNECT_ADDRESSES 4
+
+#ifndef MBED_CONF_NSAPI_TCP_CONNECTION_ATTEMPT_DELAY
+#define MBED_CONF_NSAPI_TCP_CONNECTION_ATTEMPT_DELAY 250
+#endif
+
 TCPSocket::TCPSocket()
     : _pending(0), _event_flag(),
       _read_in_progress(false), _write_in_progress(false)
@@ -90,16 +97,152 @@ nsapi_error_t TCPSocket::connect(const SocketAddress &address)
 
 nsapi_error_t TCPSocket::connect(const char *host, uint16_t port)
 {
+    if (!_stack) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+
+    // literals need no lookup and leave nothing to race
     SocketAddress address;
-    nsapi_error_t err = _stack->gethostbyname(host, &address);
-    if (err) {
+    if (address.set_ip_address(host)) {
+        address.set_port(port);
+        return connect(address);
+    }
+
+    // stacks with a resolver of their own use it instead of our queries
+    SocketAddress addresses[TCP_CONNECT_ADDRESSES];
+    nsapi_size_or_error_t count = _stack->gethostbyname_dual(host, addresses, TCP_CONNECT_ADDRESSES);
+    if (count <= 0) {
         return NSAPI_ERROR_DNS_FAILURE;
     }
 
-    address.set_port(port);
+    for (int i = 0; i < count; i++) {
+        addresses[i].set_port(port);
+    }
 
     // connect is thread safe
-    return connect(address);
+    if (count == 1 || _timeout == 0) {
+        return connect(addresses[0]);
+    }
+
+    return connect_any(addresses, count);
+}
+
+nsapi_error_t TCPSocket::connect_any(const SocketAddress *addresses, unsigned count)
+{
+    _lock.lock();
+    nsapi_error_t ret = NSAPI_ERROR_NO_SOCKET;
+
+    // If this assert is hit then there are two threads
+    // performing a send at the same time which is undefined
+    // behavior
+    MBED_ASSERT(!_write_in_progress);
+    _write_in_progress = true;
+
+    // the first attempt uses our own socket, later attempts get sockets
+    // of their own which replace ours if they win, 0 marks a failed attempt
+    nsapi_socket_t attempts[TCP_CONNECT_ADDRESSES];
+    unsigned started = 0;
+    unsigned failed = 0;
+    int winner = -1;
+
+    mbed::Timer timer;
+    timer.start();
+    int next_attempt = 0;
+
+    while (true) {
+        if (!_socket) {
+            ret = NSAPI_ERROR_NO_SOCKET;
+            break;
+        }
+
+        // start the next attempt once the previous one had its head
+        // start, or right away if all previous attempts failed
+        int now = timer.read_ms();
+        if (started < count && (now >= next_attempt || failed == started)) {
+            nsapi_socket_t socket = _socket;
+            if (started > 0 && _stack->socket_open(&socket, NSAPI_TCP) == NSAPI_ERROR_OK) {
+                _stack->socket_attach(socket, mbed::Callback<void()>::thunk, &_event);
+            } else if (started > 0) {
+                socket = 0;
+                failed += 1;
+            }
+
+            attempts[started++] = socket;
+            next_attempt = now + MBED_CONF_NSAPI_TCP_CONNECTION_ATTEMPT_DELAY;
+        }
+
+        _pending = 0;
+        for (unsigned i = 0; i < started; i++) {
+            if (!attempts[i]) {
+                continue;
+            }
+
+            nsapi_error_t err = _stack->socket_connect(attempts[i], addresses[i]);
+            if (err == NSAPI_ERROR_OK || err == NSAPI_ERROR_IS_CONNECTED) {
+                ret = NSAPI_ERROR_OK;
+                winner = i;
+                break;
+            } else if (err != NSAPI_ERROR_IN_PROGRESS && err != NSAPI_ERROR_ALREADY) {
+                if (i > 0) {
+                    _stack->socket_attach(attempts[i], 0, 0);
+                    _stack->socket_close(attempts[i]);
+                }
+
+                attempts[i] = 0;
+                failed += 1;
+            }
+
+            ret = err;
+        }
+
+        if (winner >= 0 || (started == count && failed == count)) {
+            break;
+        }
+
+        // wait for progress, the next attempt or the timeout
+        uint32_t wait = osWaitForever;
+        if (started < count) {
+            wait = next_attempt > now ? next_attempt - now : 0;
+        }
+
+        if (_timeout != osWaitForever) {
+            int elapsed = timer.read_ms();
+            if (elapsed >= (int)_timeout) {
+                // Timeout break
+                break;
+            }
+
+            if (wait > _timeout - elapsed) {
+                wait = _timeout - elapsed;
+            }
+        }
+
+        // Release lock before blocking so other threads
+        // accessing this object aren't blocked
+        _lock.unlock();
+        _event_flag.wait_any(WRITE_FLAG, wait);
+        _lock.lock();
+    }
+
+    if (winner > 0 && _socket) {
+        // swap the winning connection in for our own socket
+        _stack->socket_attach(_socket, 0, 0);
+        _stack->socket_close(_socket);
+        _socket = attempts[winner];
+        attempts[winner] = 0;
+    }
+
+    // abandon the attempts that lost the race
+    for (unsigned i = 1; i < started; i++) {
+        if (attempts[i]) {
+            _stack->socket_attach(attempts[i], 0, 0);
+            _stack->socket_close(attempts[i]);
+        }
+    }
+
+    _write_in_progress = false;
+    _lock.unlock();
+    return ret;
 }
 
 nsapi_size_or_error_t TCPSocket::send(const void *data, nsapi_size_t size)
@@ -67,6 +67,14 @@ public:
      *  Initiates a connection to a remote server specified by either
      *  a domain name or an IP address and a port.
      *
+     *  A domain name is resolved with NetworkStack::gethostbyname_dual,
+     *  which gives both IPv4 and IPv6 addresses unless the stack uses a
+     *  resolver of its own. In blocking mode the addresses are raced, each
+     *  attempt getting a short head start before the next one begins, and
+     *  the first connection to complete is kept. The winning connection may
+     *  use a different underlying socket, so socket options are best set
+     *  after connecting.
+     *
      *  @param host     Hostname of the remote host
      *  @param port     Port of the remote host
      *  @return         0 on success, negative error code on failure
@@ -122,6 +130,7 @@ protected:
 
     virtual nsapi_protocol_t get_proto();
     virtual void event();
+    nsapi_error_t connect_any(const SocketAddress *addresses, unsigned count);
 
     volatile unsigned _pending;
     rtos::EventFlags _event_flag;
@@ -113,6 +113,104 @@ public:
     nsapi_size_or_error_t recvfrom(SocketAddress *address,
             void *data, nsapi_size_t size);
 
+    /** Allocate a buffer for zero-copy transmission
+     *
+     *  Allocates a buffer of the given size from the network stack's
+     *  packet memory. Fill in the data and pass it to sendto to transmit
+     *  it without an intermediate copy, or release it with free_buffer.
+     *
+     *  @param buffer   Destination for the allocated buffer
+     *  @param size     Size of the payload in bytes
+     *  @return         0 on success, NSAPI_ERROR_UNSUPPORTED if the stack
+     *                  does not support zero-copy buffers, or another
+     *                  negative error code on failure
+     */
+    nsapi_error_t alloc_buffer(nsapi_buf_t *buffer, nsapi_size_t size);
+
+    /** Send a buffer over a UDP socket without copying
+     *
+     *  Sends a buffer obtained from alloc_buffer to the specified address.
+     *  On success, ownership of the buffer passes back to the network stack.
+     *  On failure the buffer is left untouched and must still be sent or
+     *  released with free_buffer.
+     *
+     *  By default, sendto blocks until data is sent. If socket is set to
+     *  non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK is returned
+     *  immediately.
+     *
+     *  @param address  The SocketAddress of the remote host
+     *  @param buffer   Buffer to send
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t sendto(const SocketAddress &address, nsapi_buf_t *buffer);
+
+    /** Receive a datagram over a UDP socket without copying
+     *
+     *  Lends the next datagram held by the network stack to the caller and
+     *  stores the source address in address if address is not NULL. The
+     *  datagram is accessed through buffer->data and buffer->size and
+     *  must be released with free_buffer once processed.
+     *
+     *  By default, recvfrom blocks until a datagram is received. If socket is set to
+     *  non-blocking or times out with no datagram, NSAPI_ERROR_WOULD_BLOCK
+     *  is returned.
+     *
+     *  @param address  Destination for the source address or NULL
+     *  @param buffer   Destination for the lent buffer
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t recvfrom(SocketAddress *address, nsapi_buf_t *buffer);
+
+    /** Release a zero-copy buffer
+     *
+     *  Returns a buffer obtained from alloc_buffer or recvfrom to the
+     *  network stack. Buffers must be released before the socket is closed.
+     *
+     *  @param buffer   Buffer to release
+     */
+    void free_buffer(nsapi_buf_t *buffer);
+
+    /** Send a batch of packets over a UDP socket
+     *
+     *  Sends each datagram to the address and port stored in its
+     *  descriptor, in order. The whole batch is handed to the network
+     *  stack in a single call, so the per-datagram locking and stack
+     *  overhead is paid once per batch. On return, the len field of each
+     *  sent descriptor holds the number of bytes sent.
+     *
+     *  By default, sendmmsg blocks until at least one datagram is sent.
+     *  If socket is set to non-blocking or times out, NSAPI_ERROR_WOULD_BLOCK
+     *  is returned immediately.
+     *
+     *  @param msgs     Array of datagrams to send
+     *  @param count    Number of datagrams in the array
+     *  @return         Number of sent datagrams on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t sendmmsg(nsapi_mmsg_t *msgs, unsigned count);
+
+    /** Receive a batch of datagrams over a UDP socket
+     *
+     *  Receives up to count datagrams into the buffers described by msgs.
+     *  For each received datagram the source address, port and number of
+     *  bytes written to the buffer are stored in its descriptor. If a
+     *  datagram is larger than its buffer, the excess data is silently
+     *  discarded.
+     *
+     *  By default, recvmmsg blocks until at least one datagram is received,
+     *  then returns whatever else is already queued without waiting. If
+     *  socket is set to non-blocking or times out with no datagram,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned.
+     *
+     *  @param msgs     Array of destinations for received datagrams
+     *  @param count    Number of entries in the array
+     *  @return         Number of received datagrams on success, negative
+     *                  error code on failure
+     */
+    nsapi_size_or_error_t recvmmsg(nsapi_mmsg_t *msgs, unsigned count);
+
 protected:
     virtual nsapi_protocol_t get_proto();
     virtual void event();
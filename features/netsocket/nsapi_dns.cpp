@@ -16,19 +16,72 @@
  */
 #include "nsapi_dns.h"
 #include "netsocket/UDPSocket.h"
+#include "platform/PlatformMutex.h"
+#include "platform/SingletonPtr.h"
+#include "events/mbed_shared_queues.h"
+#include "rtos/Kernel.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <new>
 
 #define CLASS_IN 1
 
 #define RR_A 1
+#define RR_SOA 6
 #define RR_AAAA 28
 
+#define RCODE_NXDOMAIN 3
+
 // DNS options
 #define DNS_BUFFER_SIZE 512
+#define DNS_HEADER_SIZE 12
 #define DNS_TIMEOUT 5000
 #define DNS_SERVERS_SIZE 5
+#define DNS_CACHE_ADDRESSES 4
+
+#ifndef MBED_CONF_NSAPI_DNS_CACHE_SIZE
+#define MBED_CONF_NSAPI_DNS_CACHE_SIZE 3
+#endif
+
+#ifndef MBED_CONF_NSAPI_DNS_CACHE_NEGATIVE_TTL
+#define MBED_CONF_NSAPI_DNS_CACHE_NEGATIVE_TTL 30
+#endif
+
+#ifndef MBED_CONF_NSAPI_DNS_SIMULTANEOUS_QUERIES
+#define MBED_CONF_NSAPI_DNS_SIMULTANEOUS_QUERIES 2
+#endif
+
+#ifndef MBED_CONF_NSAPI_DNS_RESOLUTION_DELAY
+#define MBED_CONF_NSAPI_DNS_RESOLUTION_DELAY 50
+#endif
+
+struct dns_cache {
+    char *host;
+    nsapi_version_t version;
+    nsapi_addr_t addr[DNS_CACHE_ADDRESSES];
+    unsigned count;     // 0 caches a negative answer
+    uint64_t expires;
+};
+
+struct dns_query {
+    int id;
+    NetworkStack *stack;
+    char *host;
+    nsapi_version_t version;
+    NetworkStack::hostbyname_cb_t callback;
+    UDPSocket *socket;
+    unsigned server;
+    int timeout;
+};
+
+static SingletonPtr<PlatformMutex> dns_mutex;
+#if MBED_CONF_NSAPI_DNS_CACHE_SIZE
+static dns_cache *dns_cache_table[MBED_CONF_NSAPI_DNS_CACHE_SIZE];
+#endif
+static dns_query *dns_query_table[MBED_CONF_NSAPI_DNS_SIMULTANEOUS_QUERIES];
+static int dns_query_id = 0;
+static events::EventQueue *dns_event_queue;
 
 nsapi_addr_t dns_servers[DNS_SERVERS_SIZE] = {
     {NSAPI_IPv4, {8, 8, 8, 8}},                             // Google
@@ -71,23 +124,62 @@ static void dns_append_name(uint8_t **p, const char *name, uint8_t len)
     *p += len;
 }
 
-static uint8_t dns_scan_byte(const uint8_t **p)
+// scans stop at the end of the received packet, anything past it reads as 0
+static uint8_t dns_scan_byte(const uint8_t **p, const uint8_t *end)
 {
+    if (*p >= end) {
+        return 0;
+    }
+
     return *(*p)++;
 }
 
-static uint16_t dns_scan_word(const uint8_t **p)
+static uint16_t dns_scan_word(const uint8_t **p, const uint8_t *end)
 {
-    uint16_t a = dns_scan_byte(p);
-    uint16_t b = dns_scan_byte(p);
+    uint16_t a = dns_scan_byte(p, end);
+    uint16_t b = dns_scan_byte(p, end);
     return (a << 8) | b;
 }
 
+static uint32_t dns_scan_dword(const uint8_t **p, const uint8_t *end)
+{
+    uint32_t a = dns_scan_word(p, end);
+    uint32_t b = dns_scan_word(p, end);
+    return (a << 16) | b;
+}
+
+static void dns_scan_skip(const uint8_t **p, const uint8_t *end, size_t len)
+{
+    *p = (size_t)(end - *p) < len ? end : *p + len;
+}
+
+static void dns_scan_name(const uint8_t **p, const uint8_t *end)
+{
+    while (*p < end) {
+        uint8_t len = dns_scan_byte(p, end);
+        if (len == 0) {
+            break;
+        } else if (len & 0xc0) { // this is link
+            dns_scan_byte(p, end);
+            break;
+        }
+
+        dns_scan_skip(p, end, len);
+    }
+}
+
+
+// questions for A and AAAA records carry different ids so both
+// can be outstanding on the same socket
+static uint16_t dns_question_id(nsapi_version_t version)
+{
+    return version != NSAPI_IPv6 ? 1 : 2;
+}
 
 static void dns_append_question(uint8_t **p, const char *host, nsapi_version_t version)
 {
     // fill the header
-    dns_append_word(p, 1);      // id      = 1
+    dns_append_word(p, dns_question_id(version)); // id
     dns_append_word(p, 0x0100); // flags   = recursion required
     dns_append_word(p, 1);      // qdcount = 1
     dns_append_word(p, 0);      // ancount = 0
@@ -112,66 +204,60 @@ static void dns_append_question(uint8_t **p, const char *host, nsapi_version_t v
     dns_append_word(p, CLASS_IN);
 }
 
-static int dns_scan_response(const uint8_t **p, nsapi_addr_t *addr, unsigned addr_count)
+static int dns_scan_response(const uint8_t **p, const uint8_t *end, uint16_t question_id,
+        nsapi_addr_t *addr, unsigned addr_count, uint32_t *ttl)
 {
     // scan header
-    uint16_t id    = dns_scan_word(p);
-    uint16_t flags = dns_scan_word(p);
+    if (end - *p < DNS_HEADER_SIZE) {
+        return -1;
+    }
+
+    uint16_t id    = dns_scan_word(p, end);
+    uint16_t flags = dns_scan_word(p, end);
     bool    qr     = 0x1 & (flags >> 15);
     uint8_t opcode = 0xf & (flags >> 11);
     uint8_t rcode  = 0xf & (flags >>  0);
 
-    uint16_t qdcount = dns_scan_word(p); // qdcount
-    uint16_t ancount = dns_scan_word(p); // ancount
-    dns_scan_word(p);                    // nscount
-    dns_scan_word(p);                    // arcount
+    uint16_t qdcount = dns_scan_word(p, end); // qdcount
+    uint16_t ancount = dns_scan_word(p, end); // ancount
+    uint16_t nscount = dns_scan_word(p, end); // nscount
+    dns_scan_word(p, end);                    // arcount
 
-    // verify header is response to query
-    if (!(id == 1 && qr && opcode == 0 && rcode == 0)) {
-        return 0;
+    // verify header is response to query, a missing host is
+    // still a valid answer that can be cached
+    if (!(id == question_id && qr && opcode == 0 && (rcode == 0 || rcode == RCODE_NXDOMAIN))) {
+        return -1;
     }
 
     // skip questions
     for (int i = 0; i < qdcount; i++) {
-        while (true) {
-            uint8_t len = dns_scan_byte(p);
-            if (len == 0) {
-                break;
-            }
-
-            *p += len;
-        }
-
-        dns_scan_word(p); // qtype
-        dns_scan_word(p); // qclass
+        dns_scan_name(p, end);
+        dns_scan_word(p, end); // qtype
+        dns_scan_word(p, end); // qclass
     }
 
     // scan each response
     unsigned count = 0;
+    *ttl = UINT32_MAX;
 
     for (int i = 0; i < ancount && count < addr_count; i++) {
-        while (true) {
-            uint8_t len = dns_scan_byte(p);
-            if (len == 0) {
-                break;
-            } else if (len & 0xc0) { // this is link
-                dns_scan_byte(p);
-                break;
-            }
+        dns_scan_name(p, end);
 
-            *p += len;
-        }
+        uint16_t rtype    = dns_scan_word(p, end);  // rtype
+        uint16_t rclass   = dns_scan_word(p, end);  // rclass
+        uint32_t rttl     = dns_scan_dword(p, end); // ttl
+        uint16_t rdlength = dns_scan_word(p, end);  // rdlength
 
-        uint16_t rtype    = dns_scan_word(p); // rtype
-        uint16_t rclass   = dns_scan_word(p); // rclass
-        *p += 4;                              // ttl
-        uint16_t rdlength = dns_scan_word(p); // rdlength
+        if ((size_t)(end - *p) < rdlength) {
+            // truncated packet
+            return -1;
+        }
 
         if (rtype == RR_A && rclass == CLASS_IN && rdlength == NSAPI_IPv4_BYTES) {
             // accept A record
             addr->version = NSAPI_IPv4;
             for (int i = 0; i < NSAPI_IPv4_BYTES; i++) {
-                addr->bytes[i] = dns_scan_byte(p);
+                addr->bytes[i] = dns_scan_byte(p, end);
             }
 
             addr += 1;
@@ -180,15 +266,199 @@ static int dns_scan_response(const uint8_t **p, nsapi_addr_t *addr, unsigned add
             // accept AAAA record
             addr->version = NSAPI_IPv6;
             for (int i = 0; i < NSAPI_IPv6_BYTES; i++) {
-                addr->bytes[i] = dns_scan_byte(p);
+                addr->bytes[i] = dns_scan_byte(p, end);
             }
 
             addr += 1;
             count += 1;
         } else {
-            // skip unrecognized records
-            *p += rdlength;
+            // skip unrecognized records, such as CNAMEs
+            dns_scan_skip(p, end, rdlength);
+            continue;
         }
+
+        // the answer is only valid as long as its shortest lived record
+        if (rttl < *ttl) {
+            *ttl = rttl;
+        }
+    }
+
+    if (count > 0) {
+        return count;
+    }
+
+    // a negative answer may be cached for as long as the SOA record
+    // in the authority section allows (RFC 2308)
+    *ttl = MBED_CONF_NSAPI_DNS_CACHE_NEGATIVE_TTL;
+
+    // all answers were scanned above, the authority section follows
+    for (int i = 0; i < nscount && *p < end; i++) {
+        dns_scan_name(p, end);
+
+        uint16_t rtype    = dns_scan_word(p, end);  // rtype
+        dns_scan_word(p, end);                      // rclass
+        uint32_t rttl     = dns_scan_dword(p, end); // ttl
+        uint16_t rdlength = dns_scan_word(p, end);  // rdlength
+
+        if ((size_t)(end - *p) < rdlength) {
+            // truncated authority, keep the default negative ttl
+            break;
+        }
+
+        if (rtype == RR_SOA && rdlength >= 4) {
+            // the SOA minimum is the last field of the record
+            const uint8_t *minimum = *p + rdlength - 4;
+            uint32_t soa_ttl = dns_scan_dword(&minimum, end);
+            if (rttl < soa_ttl) {
+                soa_ttl = rttl;
+            }
+
+            if (soa_ttl < *ttl) {
+                *ttl = soa_ttl;
+            }
+        }
+
+        dns_scan_skip(p, end, rdlength);
+    }
+
+    return 0;
+}
+
+// DNS cache shared by all network stacks
+static nsapi_version_t nsapi_dns_cache_version(nsapi_version_t version)
+{
+    // queries for anything other than IPv6 ask for A records
+    return version != NSAPI_IPv6 ? NSAPI_IPv4 : NSAPI_IPv6;
+}
+
+static nsapi_size_or_error_t nsapi_dns_cache_find(const char *host, nsapi_version_t version,
+        nsapi_addr_t *addr, unsigned addr_count)
+{
+    nsapi_size_or_error_t result = 0;
+
+#if MBED_CONF_NSAPI_DNS_CACHE_SIZE
+    version = nsapi_dns_cache_version(version);
+    uint64_t now = rtos::Kernel::get_ms_count();
+
+    dns_mutex->lock();
+
+    for (int i = 0; i < MBED_CONF_NSAPI_DNS_CACHE_SIZE; i++) {
+        dns_cache *entry = dns_cache_table[i];
+        if (!entry || entry->version != version || strcmp(entry->host, host) != 0) {
+            continue;
+        }
+
+        if (entry->expires <= now) {
+            // stale, drop it so it is not found again
+            free(entry->host);
+            delete entry;
+            dns_cache_table[i] = NULL;
+            break;
+        }
+
+        // entries are only as complete as DNS_CACHE_ADDRESSES allows, larger
+        // requests go to the server unless the answer was known to be short
+        if (entry->count == DNS_CACHE_ADDRESSES && addr_count > DNS_CACHE_ADDRESSES) {
+            break;
+        }
+
+        if (entry->count == 0) {
+            result = NSAPI_ERROR_DNS_FAILURE;
+            break;
+        }
+
+        unsigned count = entry->count < addr_count ? entry->count : addr_count;
+        memcpy(addr, entry->addr, count * sizeof(nsapi_addr_t));
+        result = count;
+        break;
+    }
+
+    dns_mutex->unlock();
+#endif
+
+    return result;
+}
+
+static void nsapi_dns_cache_add(const char *host, nsapi_version_t version,
+        const nsapi_addr_t *addr, unsigned count, uint32_t ttl)
+{
+#if MBED_CONF_NSAPI_DNS_CACHE_SIZE
+    if (ttl == 0) {
+        return;
+    }
+
+    version = nsapi_dns_cache_version(version);
+    uint64_t now = rtos::Kernel::get_ms_count();
+
+    dns_cache *entry = new (std::nothrow) dns_cache;
+    if (!entry) {
+        return;
+    }
+
+    entry->host = (char *)malloc(strlen(host) + 1);
+    if (!entry->host) {
+        delete entry;
+        return;
+    }
+
+    strcpy(entry->host, host);
+    entry->version = version;
+    entry->count = count < DNS_CACHE_ADDRESSES ? count : DNS_CACHE_ADDRESSES;
+    memcpy(entry->addr, addr, entry->count * sizeof(nsapi_addr_t));
+    entry->expires = now + (uint64_t)ttl * 1000;
+
+    dns_mutex->lock();
+
+    // replace an entry for the same host, an empty slot, or else
+    // the entry closest to expiry
+    int index = 0;
+    for (int i = 0; i < MBED_CONF_NSAPI_DNS_CACHE_SIZE; i++) {
+        dns_cache *other = dns_cache_table[i];
+        if (!other || (other->version == version && strcmp(other->host, host) == 0)) {
+            index = i;
+            break;
+        }
+
+        if (other->expires < dns_cache_table[index]->expires) {
+            index = i;
+        }
+    }
+
+    if (dns_cache_table[index]) {
+        free(dns_cache_table[index]->host);
+        delete dns_cache_table[index];
+    }
+    dns_cache_table[index] = entry;
+
+    dns_mutex->unlock();
+#endif
+}
+
+static nsapi_size_or_error_t nsapi_dns_parse_response(const char *host, nsapi_version_t version,
+        const uint8_t *packet, nsapi_size_t size, nsapi_addr_t *addr, unsigned addr_count)
+{
+    // scan at least as many addresses as the cache holds, so later
+    // queries for more addresses can still be answered from it
+    nsapi_addr_t cache_addr[DNS_CACHE_ADDRESSES];
+    nsapi_addr_t *scan_addr = addr_count < DNS_CACHE_ADDRESSES ? cache_addr : addr;
+    unsigned scan_count = addr_count < DNS_CACHE_ADDRESSES ? DNS_CACHE_ADDRESSES : addr_count;
+
+    const uint8_t *response = packet;
+    uint32_t ttl;
+    int count = dns_scan_response(&response, packet + size, dns_question_id(version), scan_addr, scan_count, &ttl);
+    if (count < 0) {
+        return NSAPI_ERROR_DNS_FAILURE;
+    }
+
+    nsapi_dns_cache_add(host, version, scan_addr, count, ttl);
+
+    if (count == 0) {
+        return NSAPI_ERROR_DNS_FAILURE;
+    }
+
+    if (scan_addr != addr) {
+        count = (unsigned)count < addr_count ? count : addr_count;
+        memcpy(addr, scan_addr, count * sizeof(nsapi_addr_t));
     }
 
     return count;
@@ -204,6 +474,12 @@ static nsapi_size_or_error_t nsapi_dns_query_multiple(NetworkStack *stack, const
         return NSAPI_ERROR_PARAMETER;
     }
 
+    // check for a cached answer
+    nsapi_size_or_error_t cached = nsapi_dns_cache_find(host, version, addr, addr_count);
+    if (cached != 0) {
+        return cached;
+    }
+
     // create a udp socket
     UDPSocket socket;
     int err = socket.open(stack);
@@ -242,11 +518,7 @@ static nsapi_size_or_error_t nsapi_dns_query_multiple(NetworkStack *stack, const
             break;
         }
 
-        const uint8_t *response = packet;
-        int count = dns_scan_response(&response, addr, addr_count);
-        if (count > 0) {
-            result = count;
-        }
+        result = nsapi_dns_parse_response(host, version, packet, err, addr, addr_count);
 
         /* The DNS response is final, no need to check other servers */
         break;
@@ -305,3 +577,414 @@ nsapi_error_t nsapi_dns_query(NetworkStack *stack, const char *host,
     address->set_addr(addr);
     return (nsapi_error_t)((result > 0) ? 0 : result);
 }
+
+
+// parallel A and AAAA queries, both questions go out back to back on
+// one socket so a family that is broken costs no more than the other
+static nsapi_size_or_error_t nsapi_dns_query_dual(NetworkStack *stack, const char *host,
+        nsapi_addr_t *addr, unsigned addr_count)
+{
+    // check for valid host name
+    int host_len = host ? strlen(host) : 0;
+    if (host_len > 128 || host_len == 0) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    // IPv6 comes first, it is the preferred family when both answer
+    static const nsapi_version_t versions[2] = {NSAPI_IPv6, NSAPI_IPv4};
+    nsapi_addr_t found[2][DNS_CACHE_ADDRESSES];
+    nsapi_size_or_error_t result[2];
+    nsapi_error_t error = NSAPI_ERROR_DNS_FAILURE;
+
+    // check for cached answers, 0 marks a family still to be resolved
+    for (int v = 0; v < 2; v++) {
+        result[v] = nsapi_dns_cache_find(host, versions[v], found[v], DNS_CACHE_ADDRESSES);
+    }
+
+    // create a udp socket
+    UDPSocket socket;
+    uint8_t *packet = NULL;
+    if (result[0] == 0 || result[1] == 0) {
+        error = socket.open(stack);
+        if (!error) {
+            packet = (uint8_t *)malloc(DNS_BUFFER_SIZE);
+            error = packet ? NSAPI_ERROR_DNS_FAILURE : NSAPI_ERROR_NO_MEMORY;
+        }
+    }
+
+    // check against each dns server until either family has an answer
+    for (unsigned i = 0; packet && i < DNS_SERVERS_SIZE; i++) {
+        if (result[0] > 0 || result[1] > 0 || (result[0] != 0 && result[1] != 0)) {
+            break;
+        }
+
+        // send the questions that are still open
+        bool sent = false;
+        for (int v = 0; v < 2; v++) {
+            if (result[v] != 0) {
+                continue;
+            }
+
+            uint8_t *question = packet;
+            dns_append_question(&question, host, versions[v]);
+
+            // send may fail for various reasons, including wrong address type - move on
+            nsapi_size_or_error_t err = socket.sendto(
+                    SocketAddress(dns_servers[i], 53), packet, question - packet);
+            if (err >= 0) {
+                sent = true;
+            }
+        }
+
+        if (!sent) {
+            continue;
+        }
+
+        // recv the responses in whatever order they arrive, once one family
+        // has addresses the other only gets a short grace period
+        uint64_t deadline = rtos::Kernel::get_ms_count() + DNS_TIMEOUT;
+        while (result[0] == 0 || result[1] == 0) {
+            uint64_t now = rtos::Kernel::get_ms_count();
+            if (now >= deadline) {
+                break;
+            }
+
+            socket.set_timeout(deadline - now);
+            nsapi_size_or_error_t err = socket.recvfrom(NULL, packet, DNS_BUFFER_SIZE);
+            if (err == NSAPI_ERROR_WOULD_BLOCK) {
+                break;
+            } else if (err < 0) {
+                error = err;
+                i = DNS_SERVERS_SIZE;
+                break;
+            } else if (err < 2) {
+                continue;
+            }
+
+            uint16_t id = (packet[0] << 8) | packet[1];
+            for (int v = 0; v < 2; v++) {
+                if (result[v] != 0 || id != dns_question_id(versions[v])) {
+                    continue;
+                }
+
+                // the DNS response is final for this family
+                result[v] = nsapi_dns_parse_response(host, versions[v],
+                        packet, err, found[v], DNS_CACHE_ADDRESSES);
+                if (result[v] > 0) {
+                    uint64_t grace = rtos::Kernel::get_ms_count() + MBED_CONF_NSAPI_DNS_RESOLUTION_DELAY;
+                    deadline = grace < deadline ? grace : deadline;
+                }
+            }
+        }
+    }
+
+    // clean up packet
+    free(packet);
+
+    // clean up udp
+    socket.close();
+
+    // interleave the families, starting with the preferred one
+    unsigned count = 0;
+    for (int j = 0; j < DNS_CACHE_ADDRESSES && count < addr_count; j++) {
+        for (int v = 0; v < 2 && count < addr_count; v++) {
+            if (j < result[v]) {
+                addr[count++] = found[v][j];
+            }
+        }
+    }
+
+    return count > 0 ? (nsapi_size_or_error_t)count : error;
+}
+
+nsapi_size_or_error_t nsapi_dns_query_dual(NetworkStack *stack, const char *host,
+        SocketAddress *addresses, nsapi_size_t addr_count)
+{
+    nsapi_addr_t *addrs = new nsapi_addr_t[addr_count];
+    nsapi_size_or_error_t result = nsapi_dns_query_dual(stack, host, addrs, addr_count);
+
+    if (result > 0) {
+        for (int i = 0; i < result; i++) {
+            addresses[i].set_addr(addrs[i]);
+        }
+    }
+
+    delete[] addrs;
+    return result;
+}
+
+// asynchronous queries, driven from the shared event queue so the
+// caller never blocks on the network
+static dns_query *nsapi_dns_query_async_find(int id)
+{
+    for (int i = 0; i < MBED_CONF_NSAPI_DNS_SIMULTANEOUS_QUERIES; i++) {
+        if (dns_query_table[i] && dns_query_table[i]->id == id) {
+            return dns_query_table[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void nsapi_dns_query_async_delete(dns_query *query)
+{
+    for (int i = 0; i < MBED_CONF_NSAPI_DNS_SIMULTANEOUS_QUERIES; i++) {
+        if (dns_query_table[i] == query) {
+            dns_query_table[i] = NULL;
+        }
+    }
+
+    if (query->timeout) {
+        dns_event_queue->cancel(query->timeout);
+    }
+
+    if (query->socket) {
+        query->socket->close();
+        delete query->socket;
+    }
+
+    free(query->host);
+    delete query;
+}
+
+// called with the mutex held, which is released before the callback runs
+static void nsapi_dns_query_async_resp(dns_query *query, nsapi_size_or_error_t result, const nsapi_addr_t *addr)
+{
+    NetworkStack::hostbyname_cb_t callback = query->callback;
+    nsapi_dns_query_async_delete(query);
+
+    dns_mutex->unlock();
+
+    if (result > 0) {
+        SocketAddress address(*addr);
+        callback(NSAPI_ERROR_OK, &address);
+    } else {
+        callback(result, NULL);
+    }
+}
+
+static void nsapi_dns_query_async_timeout(int id);
+
+static nsapi_error_t nsapi_dns_query_async_send(dns_query *query)
+{
+    uint8_t * const packet = (uint8_t *)malloc(DNS_BUFFER_SIZE);
+    if (!packet) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    // try the servers in order until one accepts the question
+    for (; query->server < DNS_SERVERS_SIZE; query->server++) {
+        uint8_t *question = packet;
+        dns_append_question(&question, query->host, query->version);
+
+        nsapi_size_or_error_t err = query->socket->sendto(
+                SocketAddress(dns_servers[query->server], 53), packet, question - packet);
+        if (err >= 0) {
+            break;
+        }
+    }
+
+    free(packet);
+
+    if (query->server >= DNS_SERVERS_SIZE) {
+        return NSAPI_ERROR_DNS_FAILURE;
+    }
+
+    query->timeout = dns_event_queue->call_in(DNS_TIMEOUT, nsapi_dns_query_async_timeout, query->id);
+    if (!query->timeout) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    return NSAPI_ERROR_OK;
+}
+
+static void nsapi_dns_query_async_response(int id)
+{
+    dns_mutex->lock();
+
+    dns_query *query = nsapi_dns_query_async_find(id);
+    if (!query || !query->socket) {
+        dns_mutex->unlock();
+        return;
+    }
+
+    uint8_t * const packet = (uint8_t *)malloc(DNS_BUFFER_SIZE);
+    if (!packet) {
+        nsapi_dns_query_async_resp(query, NSAPI_ERROR_NO_MEMORY, NULL);
+        return;
+    }
+
+    nsapi_size_or_error_t result = query->socket->recvfrom(NULL, packet, DNS_BUFFER_SIZE);
+    if (result == NSAPI_ERROR_WOULD_BLOCK) {
+        // spurious wakeup, keep waiting for the answer or the timeout
+        free(packet);
+        dns_mutex->unlock();
+        return;
+    }
+
+    nsapi_addr_t addr;
+    if (result >= 0) {
+        result = nsapi_dns_parse_response(query->host, query->version, packet, result, &addr, 1);
+    }
+
+    free(packet);
+    nsapi_dns_query_async_resp(query, result, &addr);
+}
+
+static void nsapi_dns_query_async_signal(void *id)
+{
+    // socket events may arrive in interrupt context, defer to the queue
+    dns_event_queue->call(nsapi_dns_query_async_response, (int)(intptr_t)id);
+}
+
+static void nsapi_dns_query_async_timeout(int id)
+{
+    dns_mutex->lock();
+
+    dns_query *query = nsapi_dns_query_async_find(id);
+    if (!query) {
+        dns_mutex->unlock();
+        return;
+    }
+
+    // no answer from this server, move on to the next one
+    query->timeout = 0;
+    query->server += 1;
+
+    nsapi_error_t err = nsapi_dns_query_async_send(query);
+    if (err) {
+        nsapi_dns_query_async_resp(query, err, NULL);
+        return;
+    }
+
+    dns_mutex->unlock();
+}
+
+static void nsapi_dns_query_async_start(int id)
+{
+    dns_mutex->lock();
+
+    dns_query *query = nsapi_dns_query_async_find(id);
+    if (!query) {
+        dns_mutex->unlock();
+        return;
+    }
+
+    query->socket = new (std::nothrow) UDPSocket;
+    if (!query->socket) {
+        nsapi_dns_query_async_resp(query, NSAPI_ERROR_NO_MEMORY, NULL);
+        return;
+    }
+
+    nsapi_error_t err = query->socket->open(query->stack);
+    if (err) {
+        delete query->socket;
+        query->socket = NULL;
+        nsapi_dns_query_async_resp(query, err, NULL);
+        return;
+    }
+
+    query->socket->set_blocking(false);
+    query->socket->sigio(mbed::callback(nsapi_dns_query_async_signal, (void *)(intptr_t)id));
+
+    err = nsapi_dns_query_async_send(query);
+    if (err) {
+        nsapi_dns_query_async_resp(query, err, NULL);
+        return;
+    }
+
+    dns_mutex->unlock();
+}
+
+nsapi_error_t nsapi_dns_query_async(NetworkStack *stack, const char *host,
+        NetworkStack::hostbyname_cb_t callback, nsapi_version_t version)
+{
+    // check for valid host name
+    int host_len = host ? strlen(host) : 0;
+    if (host_len > 128 || host_len == 0) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    // answer straight away from the cache if possible
+    nsapi_addr_t addr;
+    nsapi_size_or_error_t cached = nsapi_dns_cache_find(host, version, &addr, 1);
+    if (cached > 0) {
+        SocketAddress address(addr);
+        callback(NSAPI_ERROR_OK, &address);
+        return NSAPI_ERROR_OK;
+    } else if (cached < 0) {
+        return cached;
+    }
+
+    dns_query *query = new (std::nothrow) dns_query;
+    if (!query) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    query->host = (char *)malloc(host_len + 1);
+    if (!query->host) {
+        delete query;
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    strcpy(query->host, host);
+    query->stack = stack;
+    query->version = version;
+    query->callback = callback;
+    query->socket = NULL;
+    query->server = 0;
+    query->timeout = 0;
+
+    dns_mutex->lock();
+
+    // must be created from thread context before any socket event can use it
+    if (!dns_event_queue) {
+        dns_event_queue = mbed::mbed_event_queue();
+    }
+
+    int index = -1;
+    for (int i = 0; i < MBED_CONF_NSAPI_DNS_SIMULTANEOUS_QUERIES; i++) {
+        if (!dns_query_table[i]) {
+            index = i;
+            break;
+        }
+    }
+
+    if (index < 0) {
+        dns_mutex->unlock();
+        free(query->host);
+        delete query;
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    // ids are positive so they cannot be confused with errors
+    dns_query_id = dns_query_id < INT32_MAX ? dns_query_id + 1 : 1;
+    query->id = dns_query_id;
+    dns_query_table[index] = query;
+
+    if (!dns_event_queue->call(nsapi_dns_query_async_start, query->id)) {
+        nsapi_dns_query_async_delete(query);
+        dns_mutex->unlock();
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    int id = query->id;
+    dns_mutex->unlock();
+    return id;
+}
+
+nsapi_error_t nsapi_dns_query_async_cancel(int id)
+{
+    dns_mutex->lock();
+
+    dns_query *query = nsapi_dns_query_async_find(id);
+    if (!query) {
+        dns_mutex->unlock();
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    nsapi_dns_query_async_delete(query);
+
+    dns_mutex->unlock();
+    return NSAPI_ERROR_OK;
+}
@@ -148,6 +148,69 @@ nsapi_size_or_error_t nsapi_dns_query_multiple(S *stack, const char *host,
                 host, addr, addr_count, version);
 }
 
+/** Query a domain name server for both IPv4 and IPv6 addresses of a given hostname
+ *
+ *  The A and AAAA questions are sent at the same time. Once one of them
+ *  is answered the other is only waited for briefly, so a network where
+ *  one IP version is broken does not stall the lookup. The addresses of
+ *  both versions are interleaved, starting with IPv6.
+ *
+ *  @param stack      Network stack as target for DNS query
+ *  @param host       Hostname to resolve
+ *  @param addr       Array for the host addresses
+ *  @param addr_count Number of addresses allocated in the array
+ *  @return           Number of addresses found on success, negative error code on failure
+ *                    NSAPI_ERROR_DNS_FAILURE indicates the host could not be found
+ */
+nsapi_size_or_error_t nsapi_dns_query_dual(NetworkStack *stack, const char *host,
+        SocketAddress *addr, nsapi_size_t addr_count);
+
+/** Query a domain name server for both IPv4 and IPv6 addresses of a given hostname
+ *
+ *  @param stack      Network stack as target for DNS query
+ *  @param host       Hostname to resolve
+ *  @param addr       Array for the host addresses
+ *  @param addr_count Number of addresses allocated in the array
+ *  @return           Number of addresses found on success, negative error code on failure
+ *                    NSAPI_ERROR_DNS_FAILURE indicates the host could not be found
+ */
+template <typename S>
+nsapi_size_or_error_t nsapi_dns_query_dual(S *stack, const char *host,
+        SocketAddress *addr, nsapi_size_t addr_count)
+{
+    return nsapi_dns_query_dual(nsapi_create_stack(stack), host, addr, addr_count);
+}
+
+/** Query a domain name server for an IP address of a given hostname without blocking
+ *
+ *  The query runs on the shared event queue and the callback is called
+ *  from there once the hostname is resolved or the query fails. If the
+ *  answer is already cached, the callback is called before this
+ *  function returns.
+ *
+ *  @param stack    Network stack as target for DNS query
+ *  @param host     Hostname to resolve
+ *  @param callback Callback that is called with the result
+ *  @param version  IP version to resolve (defaults to NSAPI_IPv4)
+ *  @return         0 if the callback was already called, a positive unique
+ *                  id that can be passed to nsapi_dns_query_async_cancel
+ *                  while the query is in progress, or a negative error code
+ *                  on immediate failure, in which case the callback is not
+ *                  called
+ */
+nsapi_error_t nsapi_dns_query_async(NetworkStack *stack, const char *host,
+        NetworkStack::hostbyname_cb_t callback, nsapi_version_t version = NSAPI_IPv4);
+
+/** Cancel an asynchronous DNS query
+ *
+ *  The callback of a cancelled query is not called.
+ *
+ *  @param id       Unique id returned by nsapi_dns_query_async
+ *  @return         0 on success, NSAPI_ERROR_PARAMETER if the query
+ *                  already completed
+ */
+nsapi_error_t nsapi_dns_query_async_cancel(int id);
+
 /** Add a domain name server to list of servers to query
  *
  *  @param addr     Destination for the host address
@@ -276,6 +276,35 @@ typedef struct nsapi_wifi_ap {
 } nsapi_wifi_ap_t;
 
 
+/** nsapi_buf structure
+ *
+ *  Describes a packet buffer owned by a network stack and lent to the
+ *  application by the zero-copy socket operations. The application may
+ *  access the data and size fields, the handle is private to the stack.
+ *  A lent buffer must be returned to the stack either by sending it or
+ *  by freeing it.
+ */
+typedef struct nsapi_buf {
+    void *data;         /*!< Start of the payload */
+    nsapi_size_t size;  /*!< Size of the payload in bytes */
+    void *handle;       /*!< Stack specific handle for the buffer */
+} nsapi_buf_t;
+
+
+/** nsapi_mmsg structure
+ *
+ *  Describes one datagram of a batched UDP send or receive. The number
+ *  of bytes transferred for the datagram is stored in len.
+ */
+typedef struct nsapi_mmsg {
+    nsapi_addr_t addr;          /*!< Address of the remote host */
+    uint16_t port;              /*!< Port of the remote host */
+    void *data;                 /*!< Buffer of data to send or destination for received data */
+    nsapi_size_t size;          /*!< Size of the buffer in bytes */
+    nsapi_size_t len;           /*!< Number of bytes sent or received */
+} nsapi_mmsg_t;
+
+
 /** nsapi_stack structure
  *
  *  Stack structure representing a specific instance of a stack.
@@ -593,6 +622,108 @@ typedef struct nsapi_stack_api
      */
     nsapi_error_t (*getsockopt)(nsapi_stack_t *stack, nsapi_socket_t socket, int level,
             int optname, void *optval, unsigned *optlen);
+
+    /** Receive a packet over a UDP socket without copying
+     *
+     *  Lends the next received packet to the caller and stores the source
+     *  address in addr and port. The buffer belongs to the caller until it
+     *  is released with socket_free_buffer.
+     *
+     *  This call is non-blocking. If recvfrom would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param addr     Destination for the address of the remote host
+     *  @param port     Destination for the port of the remote host
+     *  @param buf      Destination for the lent buffer
+     *  @return         Number of received bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_recvfrom_buffer)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_addr_t *addr, uint16_t *port, nsapi_buf_t *buf);
+
+    /** Allocate a transmit buffer for a UDP socket
+     *
+     *  The buffer is allocated from the stack's own packet memory so it can
+     *  be passed to socket_sendto_buffer without copying the payload.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param size     Size of the payload in bytes
+     *  @param buf      Destination for the allocated buffer
+     *  @return         0 on success, negative error code on failure
+     */
+    nsapi_error_t (*socket_alloc_buffer)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_size_t size, nsapi_buf_t *buf);
+
+    /** Send a buffer over a UDP socket without copying
+     *
+     *  Sends the buffer to the specified address. On success the stack
+     *  takes back ownership of the buffer, on failure it remains with the
+     *  caller and may be sent again or freed.
+     *
+     *  This call is non-blocking. If sendto would block,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param addr     The address of the remote host
+     *  @param port     The port of the remote host
+     *  @param buf      Buffer from socket_alloc_buffer
+     *  @return         Number of sent bytes on success, negative error
+     *                  code on failure
+     */
+    nsapi_size_or_error_t (*socket_sendto_buffer)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_addr_t addr, uint16_t port, nsapi_buf_t *buf);
+
+    /** Return a buffer to the stack
+     *
+     *  Releases a buffer lent by socket_recvfrom_buffer or allocated by
+     *  socket_alloc_buffer.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param buf      Buffer to release
+     */
+    void (*socket_free_buffer)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_buf_t *buf);
+
+    /** Send a batch of packets over a UDP socket
+     *
+     *  Sends each datagram to its address in order, stopping at the first
+     *  datagram that cannot be sent. Returns the number of datagrams sent.
+     *
+     *  This call is non-blocking. If no datagram can be sent without
+     *  blocking, NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param msgs     Array of datagrams to send
+     *  @param count    Number of datagrams in the array
+     *  @return         Number of sent datagrams on success, negative error
+     *                  code if no datagram could be sent
+     */
+    nsapi_size_or_error_t (*socket_sendmmsg)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_mmsg_t *msgs, unsigned count);
+
+    /** Receive a batch of packets over a UDP socket
+     *
+     *  Receives up to count datagrams that are already queued on the
+     *  socket. Returns the number of datagrams received.
+     *
+     *  This call is non-blocking. If no datagram is queued,
+     *  NSAPI_ERROR_WOULD_BLOCK is returned immediately.
+     *
+     *  @param stack    Stack handle
+     *  @param socket   Socket handle
+     *  @param msgs     Array of destinations for received datagrams
+     *  @param count    Number of entries in the array
+     *  @return         Number of received datagrams on success, negative
+     *                  error code if no datagram could be received
+     */
+    nsapi_size_or_error_t (*socket_recvmmsg)(nsapi_stack_t *stack, nsapi_socket_t socket,
+            nsapi_mmsg_t *msgs, unsigned count);
 } nsapi_stack_api_t;
 
 
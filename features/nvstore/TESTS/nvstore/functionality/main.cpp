@@ -37,6 +37,8 @@ static const uint16_t max_test_keys = 20;
 
 static const size_t basic_func_max_data_size = 128;
 
+static const size_t gc_test_data_size = 32;
+
 static const int thr_test_num_buffs = 5;
 static const int thr_test_num_secs = 5;
 static const int thr_test_max_data_size = 32;
@@ -478,6 +480,216 @@ static void nvstore_multi_thread_test()
 #endif
 }
 
+static void nvstore_alloc_key_test()
+{
+    NVStore &nvstore = NVStore::get_instance();
+    uint16_t key, actual_len_bytes;
+    uint8_t data;
+    int result;
+
+    nvstore.set_max_keys(max_test_keys);
+    result = nvstore.reset();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+
+    // Predefined keys are never allocated, even when set
+    result = nvstore.set(NVSTORE_NUM_PREDEFINED_KEYS - 1, 1, &data);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.set(NVSTORE_NUM_PREDEFINED_KEYS + 1, 1, &data);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+
+    // Allocate all free keys, each one once
+    for (uint16_t i = NVSTORE_NUM_PREDEFINED_KEYS + 1; i < max_test_keys; i++) {
+        data = i;
+        result = nvstore.set_alloc_key(key, 1, &data);
+        TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+        TEST_ASSERT(key >= NVSTORE_NUM_PREDEFINED_KEYS);
+        TEST_ASSERT(key < max_test_keys);
+        TEST_ASSERT_NOT_EQUAL(NVSTORE_NUM_PREDEFINED_KEYS + 1, key);
+        result = nvstore.get(key, 1, &data, actual_len_bytes);
+        TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+        TEST_ASSERT_EQUAL(i, data);
+    }
+    result = nvstore.set_alloc_key(key, 1, &data);
+    TEST_ASSERT_EQUAL(NVSTORE_NO_FREE_KEY, result);
+
+    // Removed keys are allocated again
+    result = nvstore.remove(max_test_keys - 1);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.remove(NVSTORE_NUM_PREDEFINED_KEYS + 1);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    for (int i = 0; i < 2; i++) {
+        result = nvstore.set_alloc_key(key, 1, &data);
+        TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+        TEST_ASSERT((key == max_test_keys - 1) || (key == NVSTORE_NUM_PREDEFINED_KEYS + 1));
+    }
+    result = nvstore.set_alloc_key(key, 1, &data);
+    TEST_ASSERT_EQUAL(NVSTORE_NO_FREE_KEY, result);
+
+    // Same after reinitialization
+    result = nvstore.deinit();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.remove(NVSTORE_NUM_PREDEFINED_KEYS + 2);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.set_alloc_key(key, 1, &data);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    TEST_ASSERT_EQUAL(NVSTORE_NUM_PREDEFINED_KEYS + 2, key);
+    result = nvstore.set_alloc_key(key, 1, &data);
+    TEST_ASSERT_EQUAL(NVSTORE_NO_FREE_KEY, result);
+}
+
+static void nvstore_incremental_gc_test()
+{
+    NVStore &nvstore = NVStore::get_instance();
+    uint16_t key, actual_len_bytes;
+    uint8_t get_buf[gc_test_data_size];
+    uint8_t set_buf[gc_test_data_size];
+    int result;
+
+    nvstore.set_max_keys(max_test_keys);
+    result = nvstore.reset();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+
+    // Overwrite keys until the area is several times full, taking GC steps in between.
+    // Each key holds its key number and the number of times it was set.
+    int num_sets = 4 * nvstore.size() / (gc_test_data_size + 8);
+    uint8_t set_count[max_test_keys] = {0};
+    for (int i = 0; i < num_sets; i++) {
+        key = i % max_test_keys;
+        set_count[key]++;
+        memset(set_buf, set_count[key], sizeof(set_buf));
+        set_buf[0] = key;
+        result = nvstore.set(key, sizeof(set_buf), set_buf);
+        TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+
+        if (i % 3 == 0) {
+            result = nvstore.garbage_collection_step(2);
+            TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+        }
+
+        key = (i * 7) % max_test_keys;
+        if (set_count[key]) {
+            result = nvstore.get(key, sizeof(get_buf), get_buf, actual_len_bytes);
+            TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+            TEST_ASSERT_EQUAL(sizeof(get_buf), actual_len_bytes);
+            TEST_ASSERT_EQUAL(key, get_buf[0]);
+            TEST_ASSERT_EQUAL(set_count[key], get_buf[1]);
+        }
+    }
+
+    // Stop in the middle of a garbage collection, make sure nothing is lost
+    result = nvstore.deinit();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    for (key = 0; key < max_test_keys; key++) {
+        result = nvstore.get(key, sizeof(get_buf), get_buf, actual_len_bytes);
+        TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+        TEST_ASSERT_EQUAL(key, get_buf[0]);
+        TEST_ASSERT_EQUAL(set_count[key], get_buf[1]);
+    }
+
+    result = nvstore.garbage_collection_step(0);
+    TEST_ASSERT_EQUAL(NVSTORE_BAD_VALUE, result);
+}
+
+static void nvstore_transaction_test()
+{
+    NVStore &nvstore = NVStore::get_instance();
+    uint16_t key, actual_len_bytes;
+    uint8_t get_buf[gc_test_data_size];
+    uint8_t set_buf[gc_test_data_size];
+    int result;
+
+    nvstore.set_max_keys(max_test_keys);
+    result = nvstore.reset();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+
+    result = nvstore.set_in_transaction(1, sizeof(set_buf), set_buf);
+    TEST_ASSERT_EQUAL(NVSTORE_NOT_FOUND, result);
+    result = nvstore.commit_transaction();
+    TEST_ASSERT_EQUAL(NVSTORE_NOT_FOUND, result);
+
+    result = nvstore.set(1, sizeof(set_buf), set_buf);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+
+    // Committed items are all set
+    result = nvstore.begin_transaction();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.begin_transaction();
+    TEST_ASSERT_EQUAL(NVSTORE_ALREADY_EXISTS, result);
+    for (key = 2; key < 6; key++) {
+        memset(set_buf, key, sizeof(set_buf));
+        result = nvstore.set_in_transaction(key, sizeof(set_buf), set_buf);
+        TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    }
+    result = nvstore.remove_in_transaction(1);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.set_in_transaction(max_test_keys, sizeof(set_buf), set_buf);
+    TEST_ASSERT_EQUAL(NVSTORE_BAD_VALUE, result);
+
+    result = nvstore.get(2, sizeof(get_buf), get_buf, actual_len_bytes);
+    TEST_ASSERT_EQUAL(NVSTORE_NOT_FOUND, result);
+
+    result = nvstore.commit_transaction();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.get(1, sizeof(get_buf), get_buf, actual_len_bytes);
+    TEST_ASSERT_EQUAL(NVSTORE_NOT_FOUND, result);
+
+    // Aborted items are discarded
+    result = nvstore.begin_transaction();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.remove_in_transaction(2);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.set_in_transaction(6, sizeof(set_buf), set_buf);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.abort_transaction();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.abort_transaction();
+    TEST_ASSERT_EQUAL(NVSTORE_NOT_FOUND, result);
+    result = nvstore.get(6, sizeof(get_buf), get_buf, actual_len_bytes);
+    TEST_ASSERT_EQUAL(NVSTORE_NOT_FOUND, result);
+
+    // Touching a set once item fails the whole transaction
+    result = nvstore.set_once(7, sizeof(set_buf), set_buf);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.begin_transaction();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.remove_in_transaction(3);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.set_in_transaction(7, sizeof(set_buf), set_buf);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.commit_transaction();
+    TEST_ASSERT_EQUAL(NVSTORE_ALREADY_EXISTS, result);
+
+    // Committed items survive reinitialization, and garbage collection
+    result = nvstore.deinit();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    int num_txns = 2 * nvstore.size() / (2 * (gc_test_data_size + 8) + 16);
+    for (int i = 0; i <= num_txns; i++) {
+        for (key = 2; key < 6; key++) {
+            result = nvstore.get(key, sizeof(get_buf), get_buf, actual_len_bytes);
+            TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+            TEST_ASSERT_EQUAL(sizeof(get_buf), actual_len_bytes);
+            TEST_ASSERT_EQUAL(key, get_buf[0]);
+        }
+        if (i == num_txns) {
+            break;
+        }
+        result = nvstore.begin_transaction();
+        TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+        for (key = 2; key < 4; key++) {
+            memset(set_buf, key, sizeof(set_buf));
+            result = nvstore.set_in_transaction(key, sizeof(set_buf), set_buf);
+            TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+        }
+        result = nvstore.commit_transaction();
+        TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    }
+    result = nvstore.deinit();
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    result = nvstore.get(3, sizeof(get_buf), get_buf, actual_len_bytes);
+    TEST_ASSERT_EQUAL(NVSTORE_SUCCESS, result);
+    TEST_ASSERT_EQUAL(3, get_buf[0]);
+}
+
 static void race_test_worker(void *buf)
 {
     int ret;
@@ -551,6 +763,9 @@ utest::v1::status_t greentea_failure_handler(const Case *const source, const fai
 
 Case cases[] = {
     Case("NVStore: Basic functionality",  nvstore_basic_functionality_test, greentea_failure_handler),
+    Case("NVStore: Key allocation",       nvstore_alloc_key_test,           greentea_failure_handler),
+    Case("NVStore: Incremental GC",       nvstore_incremental_gc_test,      greentea_failure_handler),
+    Case("NVStore: Transactions",         nvstore_transaction_test,         greentea_failure_handler),
     Case("NVStore: Race test",            nvstore_race_test,                greentea_failure_handler),
     Case("NVStore: Multiple thread test", nvstore_multi_thread_test,        greentea_failure_handler),
 };
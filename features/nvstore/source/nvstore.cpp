@@ -21,6 +21,7 @@
 #if NVSTORE_ENABLED
 
 #include "FlashIAP.h"
+#include "MbedCRC.h"
 #include "mbed_critical.h"
 #include "mbed_assert.h"
 #include "Thread.h"
@@ -33,11 +34,13 @@
 
 static const uint16_t delete_item_flag = 0x8000;
 static const uint16_t set_once_flag    = 0x4000;
+static const uint16_t transaction_flag = 0x2000;
 static const uint16_t header_flag_mask = 0xF000;
 
-static const uint16_t master_record_key = 0xFFE;
-static const uint16_t no_key            = 0xFFF;
-static const uint16_t last_reserved_key = master_record_key;
+static const uint16_t transaction_commit_key = 0xFFD;
+static const uint16_t master_record_key      = 0xFFE;
+static const uint16_t no_key                 = 0xFFF;
+static const uint16_t last_reserved_key      = transaction_commit_key;
 
 typedef struct
 {
@@ -58,6 +61,12 @@ typedef struct {
     uint32_t reserved2;
 } master_record_data_t;
 
+typedef struct {
+    uint16_t num_records;
+    uint16_t reserved1;
+    uint32_t reserved2;
+} transaction_commit_data_t;
+
 static const uint32_t min_area_size = 4096;
 
 static const int num_write_retries = 16;
@@ -91,8 +100,21 @@ typedef enum {
     NVSTORE_AREA_STATE_VALID,
 } area_state_e;
 
+typedef enum {
+    NVSTORE_GC_STATE_IDLE = 0,
+    NVSTORE_GC_STATE_COPY,
+    NVSTORE_GC_STATE_ERASE,
+} gc_state_e;
+
 static const uint32_t initial_crc = 0xFFFFFFFF;
 
+static const uint32_t min_transaction_buf_size = 256;
+
+#if NVSTORE_HASH_INDEX
+static const uint8_t min_index_bits = 4;
+static const uint16_t min_free_keys_size = 8;
+#endif
+
 
 // -------------------------------------------------- Local Functions Declaration ----------------------------------------------------
 
@@ -108,31 +130,41 @@ static inline uint32_t align_up(uint32_t val, uint32_t size)
     return (((val - 1) / size) + 1) * size;
 }
 
-// CRC32 calculation. Supports "rolling" calculation (using the initial value).
+// Record CRC: reflected CRC32 without final XOR, computed by the shared
+// table driven CRC engine
+typedef mbed::MbedCRC<mbed::POLY_32BIT_ANSI, 32> nvstore_crc_t;
+
+// Calculate record CRC. The transaction flag is left out, so committed records
+// can be copied without it.
 // Parameters :
-// init_crc      - [IN]   Initial CRC.
-// data_size      - [IN]   Buffer's data size.
+// header        - [IN]   Record header.
+// data_size     - [IN]   Data size.
 // data_buf      - [IN]   Data buffer.
 // Return        : CRC.
-static uint32_t crc32(uint32_t init_crc, uint32_t data_size, uint8_t *data_buf)
+static uint32_t calc_record_crc(const nvstore_record_header_t &header, uint32_t data_size, const void *data_buf)
 {
-    uint32_t i, j;
-    uint32_t crc, mask;
+    nvstore_crc_t ct(initial_crc, 0, true, true);
+    nvstore_record_header_t crc_header = header;
+    uint32_t crc;
 
-    crc = init_crc;
-    for (i = 0; i < data_size; i++) {
-        crc = crc ^ (uint32_t) (data_buf[i]);
-        for (j = 0; j < 8; j++) {
-          mask = -(crc & 1);
-          crc = (crc >> 1) ^ (0xEDB88320 & mask);
-        }
+    crc_header.key_and_flags &= ~transaction_flag;
+    ct.compute_partial_start(&crc);
+    ct.compute_partial(&crc_header, sizeof(crc_header) - sizeof(crc_header.crc), &crc);
+    if (data_size) {
+        ct.compute_partial(const_cast<void *>(data_buf), data_size, &crc);
     }
+    ct.compute_partial_stop(&crc);
     return crc;
 }
 
 NVStore::NVStore() : _init_done(0), _init_attempts(0), _active_area(0), _max_keys(NVSTORE_MAX_KEYS),
-      _active_area_version(0), _free_space_offset(0), _size(0), _mutex(0), _offset_by_key(0), _flash(0),
-      _min_prog_size(0), _page_buf(0)
+      _active_area_version(0), _free_space_offset(0), _size(0), _mutex(0), _offset_by_key(0),
+#if NVSTORE_HASH_INDEX
+      _key_by_slot(0), _index_bits(0), _index_count(0), _free_keys(0), _num_free_keys(0),
+      _free_keys_size(0), _next_free_key(0),
+#endif
+      _flash(0), _min_prog_size(0), _page_buf(0), _gc_state(NVSTORE_GC_STATE_IDLE), _gc_key(0), _gc_offset(0),
+      _txn_buf(0), _txn_buf_size(0), _txn_size(0), _txn_records(0)
 {
     memset(_flash_area_params, 0, sizeof(_flash_area_params));
 }
@@ -169,6 +201,235 @@ void NVStore::set_max_keys(uint16_t num_keys)
     deinit();
 }
 
+#if NVSTORE_HASH_INDEX
+
+// Hash a key to its home slot (Fibonacci hashing, as consecutive keys are common).
+// Parameters :
+// key           - [IN]   Key.
+// bits          - [IN]   Log2 of number of slots.
+// Return        : Home slot.
+static inline uint32_t key_hash(uint16_t key, uint8_t bits)
+{
+    return (uint32_t)(key * 2654435769UL) >> (32 - bits);
+}
+
+void NVStore::init_key_index()
+{
+    _key_by_slot = 0;
+    _offset_by_key = 0;
+    _index_count = 0;
+    resize_key_index(min_index_bits);
+
+    _free_keys = 0;
+    _num_free_keys = 0;
+    _free_keys_size = 0;
+    _next_free_key = NVSTORE_NUM_PREDEFINED_KEYS;
+}
+
+void NVStore::deinit_key_index()
+{
+    delete[] _offset_by_key;
+    delete[] _key_by_slot;
+    delete[] _free_keys;
+    _offset_by_key = 0;
+    _key_by_slot = 0;
+    _free_keys = 0;
+}
+
+void NVStore::resize_key_index(uint8_t bits)
+{
+    uint32_t old_size = _key_by_slot ? (1UL << _index_bits) : 0;
+    uint32_t new_size = 1UL << bits;
+    uint16_t *old_keys = _key_by_slot;
+    uint32_t *old_offsets = _offset_by_key;
+
+    _key_by_slot = new uint16_t[new_size];
+    MBED_ASSERT(_key_by_slot);
+    _offset_by_key = new uint32_t[new_size];
+    MBED_ASSERT(_offset_by_key);
+    _index_bits = bits;
+
+    for (uint32_t slot = 0; slot < new_size; slot++) {
+        _key_by_slot[slot] = no_key;
+    }
+
+    for (uint32_t slot = 0; slot < old_size; slot++) {
+        if (old_keys[slot] != no_key) {
+            uint32_t new_slot = find_key_slot(old_keys[slot]);
+            _key_by_slot[new_slot] = old_keys[slot];
+            _offset_by_key[new_slot] = old_offsets[slot];
+        }
+    }
+
+    delete[] old_keys;
+    delete[] old_offsets;
+}
+
+uint32_t NVStore::find_key_slot(uint16_t key)
+{
+    uint32_t mask = (1UL << _index_bits) - 1;
+    uint32_t slot = key_hash(key, _index_bits);
+
+    // Linear probing, the table is never full
+    while ((_key_by_slot[slot] != key) && (_key_by_slot[slot] != no_key)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+uint32_t NVStore::get_key_offset(uint16_t key)
+{
+    uint32_t slot = find_key_slot(key);
+
+    if (_key_by_slot[slot] == no_key) {
+        return 0;
+    }
+    return _offset_by_key[slot];
+}
+
+void NVStore::set_key_offset(uint16_t key, uint32_t offset)
+{
+    uint32_t mask = (1UL << _index_bits) - 1;
+    uint32_t slot = find_key_slot(key);
+
+    if (_key_by_slot[slot] == key) {
+        if (offset) {
+            _offset_by_key[slot] = offset;
+            return;
+        }
+
+        // Remove the key and shift back following entries of the probe sequence,
+        // so no tombstones are needed
+        _index_count--;
+        uint32_t next = slot;
+        for (;;) {
+            next = (next + 1) & mask;
+            if (_key_by_slot[next] == no_key) {
+                break;
+            }
+            uint32_t home = key_hash(_key_by_slot[next], _index_bits);
+            // Move the entry unless its home slot lies cyclically in (slot, next]
+            if (((next - home) & mask) >= ((next - slot) & mask)) {
+                _key_by_slot[slot] = _key_by_slot[next];
+                _offset_by_key[slot] = _offset_by_key[next];
+                slot = next;
+            }
+        }
+        _key_by_slot[slot] = no_key;
+        return;
+    }
+
+    if (!offset) {
+        return;
+    }
+
+    // Keep load factor under 3/4
+    if ((uint32_t)(_index_count + 1) * 4 > (3UL << _index_bits)) {
+        resize_key_index(_index_bits + 1);
+        slot = find_key_slot(key);
+    }
+    _key_by_slot[slot] = key;
+    _offset_by_key[slot] = offset;
+    _index_count++;
+}
+
+int NVStore::alloc_key(uint16_t &key)
+{
+    // Released keys are checked lazily, as they may have been set again since
+    while (_num_free_keys) {
+        key = _free_keys[--_num_free_keys];
+        if (!get_key_offset(key)) {
+            return NVSTORE_SUCCESS;
+        }
+    }
+
+    // Keys above the watermark were never allocated, but may have been set explicitly
+    while (_next_free_key < _max_keys) {
+        key = _next_free_key++;
+        if (!get_key_offset(key)) {
+            return NVSTORE_SUCCESS;
+        }
+    }
+
+    return NVSTORE_NO_FREE_KEY;
+}
+
+void NVStore::release_key(uint16_t key)
+{
+    if ((key < NVSTORE_NUM_PREDEFINED_KEYS) || (key >= _next_free_key)) {
+        return;
+    }
+
+    if (_num_free_keys == _free_keys_size) {
+        // Drop keys that were set again and duplicates, before growing
+        uint16_t num_keys = 0;
+        for (uint16_t i = 0; i < _num_free_keys; i++) {
+            if (!get_key_offset(_free_keys[i])) {
+                _free_keys[num_keys++] = _free_keys[i];
+            }
+        }
+        std::sort(_free_keys, _free_keys + num_keys);
+        _num_free_keys = (uint16_t)(std::unique(_free_keys, _free_keys + num_keys) - _free_keys);
+
+        if (_num_free_keys == _free_keys_size) {
+            _free_keys_size = std::max((uint16_t)(_free_keys_size * 2), min_free_keys_size);
+            uint16_t *free_keys = new uint16_t[_free_keys_size];
+            MBED_ASSERT(free_keys);
+            std::copy(_free_keys, _free_keys + _num_free_keys, free_keys);
+            delete[] _free_keys;
+            _free_keys = free_keys;
+        }
+    }
+
+    _free_keys[_num_free_keys++] = key;
+}
+
+#else
+
+void NVStore::init_key_index()
+{
+    _offset_by_key = new uint32_t[_max_keys];
+    MBED_ASSERT(_offset_by_key);
+
+    for (uint16_t key = 0; key < _max_keys; key++) {
+        _offset_by_key[key] = 0;
+    }
+}
+
+void NVStore::deinit_key_index()
+{
+    delete[] _offset_by_key;
+    _offset_by_key = 0;
+}
+
+uint32_t NVStore::get_key_offset(uint16_t key)
+{
+    return _offset_by_key[key];
+}
+
+void NVStore::set_key_offset(uint16_t key, uint32_t offset)
+{
+    _offset_by_key[key] = offset;
+}
+
+int NVStore::alloc_key(uint16_t &key)
+{
+    for (key = NVSTORE_NUM_PREDEFINED_KEYS; key < _max_keys; key++) {
+        if (!_offset_by_key[key]) {
+            return NVSTORE_SUCCESS;
+        }
+    }
+    return NVSTORE_NO_FREE_KEY;
+}
+
+void NVStore::release_key(uint16_t key)
+{
+    // Free keys are found by scanning the index
+    (void) key;
+}
+
+#endif // NVSTORE_HASH_INDEX
+
 int NVStore::flash_read_area(uint8_t area, uint32_t offset, uint32_t size, void *buf)
 {
     return _flash->read(buf, _flash_area_params[area].address + offset, size);
@@ -190,12 +451,17 @@ int NVStore::flash_write_area(uint8_t area, uint32_t offset, uint32_t size, cons
 }
 
 int NVStore::flash_erase_area(uint8_t area)
+{
+    return flash_erase_sectors(area, 0, _flash_area_params[area].size);
+}
+
+int NVStore::flash_erase_sectors(uint8_t area, uint32_t offset, uint32_t size)
 {
     int ret;
     // On some boards, write action can fail due to HW limitations (like critical drivers
     // that disable all other actions). Just retry a few times until success.
     for (int i = 0; i < num_write_retries; i++) {
-        ret = _flash->erase(_flash_area_params[area].address, _flash_area_params[area].size);
+        ret = _flash->erase(_flash_area_params[area].address + offset, size);
         if (!ret) {
             return ret;
         }
@@ -313,7 +579,8 @@ int NVStore::read_record(uint8_t area, uint32_t offset, uint16_t buf_size, void
     uint16_t data_size, chunk_size;
     int os_ret;
     nvstore_record_header_t header;
-    uint32_t crc = initial_crc;
+    nvstore_crc_t ct(initial_crc, 0, true, true);
+    uint32_t crc;
 
     valid = 1;
 
@@ -322,13 +589,16 @@ int NVStore::read_record(uint8_t area, uint32_t offset, uint16_t buf_size, void
         return NVSTORE_READ_ERROR;
     }
 
-    crc = crc32(crc, sizeof(header) - sizeof(header.crc), (uint8_t *) &header);
-
     actual_size = 0;
     key   = header.key_and_flags & ~header_flag_mask;
     flags = header.key_and_flags & header_flag_mask;
 
-    if ((key >= _max_keys) && (key != master_record_key)) {
+    // CRC doesn't cover the transaction flag (see calc_record_crc)
+    header.key_and_flags &= ~transaction_flag;
+    ct.compute_partial_start(&crc);
+    ct.compute_partial(&header, sizeof(header) - sizeof(header.crc), &crc);
+
+    if ((key >= _max_keys) && (key != master_record_key) && (key != transaction_commit_key)) {
         valid = 0;
         return NVSTORE_SUCCESS;
     }
@@ -336,6 +606,12 @@ int NVStore::read_record(uint8_t area, uint32_t offset, uint16_t buf_size, void
     data_size = header.size;
     offset += sizeof(header);
 
+    // A partially written header may hold any size, so don't read past the area
+    if (offset + data_size > _size) {
+        valid = 0;
+        return NVSTORE_SUCCESS;
+    }
+
     // In case of validate only enabled, we use our internal buffer for data reading,
     // instead of the user one. This allows us to use a smaller buffer, on which CRC
     // is continuously calculated.
@@ -358,11 +634,12 @@ int NVStore::read_record(uint8_t area, uint32_t offset, uint16_t buf_size, void
         if (os_ret) {
             return NVSTORE_READ_ERROR;
         }
-        crc = crc32(crc, chunk_size, (uint8_t *) buf_ptr);
+        ct.compute_partial(buf_ptr, chunk_size, &crc);
         data_size -= chunk_size;
         offset += chunk_size;
     }
 
+    ct.compute_partial_stop(&crc);
     if (header.crc != crc) {
         valid = 0;
         return NVSTORE_SUCCESS;
@@ -378,18 +655,13 @@ int NVStore::write_record(uint8_t area, uint32_t offset, uint16_t key, uint16_t
                           uint32_t data_size, const void *data_buf, uint32_t &next_offset)
 {
     nvstore_record_header_t header;
-    uint32_t crc = initial_crc;
     int os_ret;
     uint8_t *prog_buf;
 
     header.key_and_flags = key | flags;
     header.size = data_size;
     header.crc = 0; // Satisfy compiler
-    crc = crc32(crc, sizeof(header) - sizeof(header.crc), (uint8_t *) &header);
-    if (data_size) {
-        crc = crc32(crc, data_size, (uint8_t *) data_buf);
-    }
-    header.crc = crc;
+    header.crc = calc_record_crc(header, data_size, data_buf);
 
     // In case page size is greater than header size, we can't write header and data
     // separately. Instead, we need to copy header and start of data to our page buffer
@@ -429,6 +701,77 @@ int NVStore::write_record(uint8_t area, uint32_t offset, uint16_t key, uint16_t
     return NVSTORE_SUCCESS;
 }
 
+int NVStore::index_records(uint32_t &offset, uint32_t end_offset, int &valid)
+{
+    nvstore_record_header_t header;
+    uint32_t next_offset, txn_offset = 0;
+    uint16_t key, flags, actual_size;
+    uint16_t txn_records = 0;
+    int ret;
+
+    valid = 1;
+    while (offset < end_offset) {
+        ret = read_record(_active_area, offset, 0, NULL,
+                          actual_size, 1, valid,
+                          key, flags, next_offset);
+        if (ret != NVSTORE_SUCCESS) {
+            return ret;
+        }
+        if (!valid) {
+            break;
+        }
+
+        if (flags & transaction_flag) {
+            // Transaction records only take effect once the commit record is reached
+            if (!txn_records) {
+                txn_offset = offset;
+            }
+            txn_records++;
+        } else if (key == transaction_commit_key) {
+            transaction_commit_data_t commit;
+            ret = read_record(_active_area, offset, sizeof(commit), &commit,
+                              actual_size, 0, valid,
+                              key, flags, next_offset);
+            if ((ret != NVSTORE_SUCCESS) && (ret != NVSTORE_BUFF_TOO_SMALL)) {
+                return ret;
+            }
+            if ((ret == NVSTORE_SUCCESS) && txn_records && (commit.num_records == txn_records)) {
+                while (txn_offset < offset) {
+                    if (flash_read_area(_active_area, txn_offset, sizeof(header), &header)) {
+                        return NVSTORE_READ_ERROR;
+                    }
+                    if (header.key_and_flags & delete_item_flag) {
+                        set_key_offset(header.key_and_flags & ~header_flag_mask, 0);
+                    } else {
+                        set_key_offset(header.key_and_flags & ~header_flag_mask,
+                                       txn_offset | (_active_area << offs_by_key_area_bit_pos));
+                    }
+                    txn_offset = align_up(txn_offset + sizeof(header) + header.size, _min_prog_size);
+                }
+            }
+            txn_records = 0;
+        } else {
+            // An uncommitted transaction (system crashed when written) is ignored
+            txn_records = 0;
+            if (flags & delete_item_flag) {
+                set_key_offset(key, 0);
+            } else {
+                set_key_offset(key, offset | (_active_area << offs_by_key_area_bit_pos) |
+                               (((flags & set_once_flag) != 0) << offs_by_key_set_once_bit_pos));
+            }
+        }
+        offset = next_offset;
+    }
+
+    // Transaction records with no commit record after them must not be followed by new ones.
+    // Report them as a faulty tail, so that the caller garbage collects them away.
+    if (txn_records) {
+        valid = 0;
+    }
+
+    return NVSTORE_SUCCESS;
+}
+
 int NVStore::write_master_record(uint8_t area, uint16_t version, uint32_t &next_offset)
 {
     master_record_data_t master_rec;
@@ -468,6 +811,9 @@ int NVStore::copy_record(uint8_t from_area, uint32_t from_offset, uint32_t to_of
     header = (nvstore_record_header_t *) read_buf;
     record_size = sizeof(nvstore_record_header_t) + header->size;
 
+    // Only committed transaction records are copied, so they become regular records
+    header->key_and_flags &= ~transaction_flag;
+
     // No need to copy records whose flags indicate deletion
     if (header->key_and_flags & delete_item_flag) {
         next_offset = align_up(to_offset, _min_prog_size);
@@ -508,45 +854,92 @@ int NVStore::copy_record(uint8_t from_area, uint32_t from_offset, uint32_t to_of
     return NVSTORE_SUCCESS;
 }
 
-int NVStore::garbage_collection(uint16_t key, uint16_t flags, uint16_t buf_size, const void *buf)
+int NVStore::gc_copy_key(uint16_t key, uint32_t &new_area_offset, uint16_t &max_records)
 {
-    uint32_t curr_offset, new_area_offset, next_offset;
+    uint32_t curr_offset, next_offset;
     int ret;
     uint8_t curr_area;
 
-    new_area_offset = align_up(sizeof(nvstore_record_header_t) + sizeof(master_record_data_t), _min_prog_size);
+    // Copy the record if the key has a valid offset (meaning that it exists) in the active area
+    curr_offset = get_key_offset(key);
+    uint32_t save_flags = curr_offset & offs_by_key_set_once_mask;
+    curr_area = (uint8_t)(curr_offset >> offs_by_key_area_bit_pos) & 1;
+    curr_offset &= ~offs_by_key_flag_mask;
+    if ((!curr_offset) || (curr_area != _active_area)) {
+        return NVSTORE_SUCCESS;
+    }
+    ret = copy_record(curr_area, curr_offset, new_area_offset, next_offset);
+    if (ret != NVSTORE_SUCCESS) {
+        return ret;
+    }
+    set_key_offset(key, new_area_offset | (1 - curr_area) << offs_by_key_area_bit_pos | save_flags);
+    new_area_offset = next_offset;
+    max_records--;
+    return NVSTORE_SUCCESS;
+}
 
-    // If GC is triggered by a set item request, we need to first write that item in the new location,
-    // otherwise we may either write it twice (if already included), or lose it in case we decide
-    // to skip it at garbage collection phase (and the system crashes).
-    if ((key != no_key) && !(flags & delete_item_flag)) {
-        ret = write_record(1 - _active_area, new_area_offset, key, 0, buf_size, buf, next_offset);
-        if (ret != NVSTORE_SUCCESS) {
-            return ret;
+#if NVSTORE_HASH_INDEX
+
+int NVStore::gc_copy_records(uint16_t &key, uint16_t max_records, uint32_t &new_area_offset)
+{
+    int ret = NVSTORE_SUCCESS;
+    uint32_t num_slots = 1UL << _index_bits;
+    uint16_t num_keys = 0;
+    uint16_t i;
+
+    // Only the occupied slots hold keys. Visit them in key order, so that the scan can be
+    // resumed by key, as the slots may move between incremental steps.
+    uint16_t *keys = new uint16_t[_index_count];
+    MBED_ASSERT(keys);
+    for (uint32_t slot = 0; slot < num_slots; slot++) {
+        if ((_key_by_slot[slot] >= key) && (_key_by_slot[slot] < _max_keys)) {
+            keys[num_keys++] = _key_by_slot[slot];
         }
-        _offset_by_key[key] = new_area_offset | (1 - _active_area) << offs_by_key_area_bit_pos |
-                                (((flags & set_once_flag) != 0) << offs_by_key_set_once_bit_pos);
-        new_area_offset = next_offset;
     }
+    std::sort(keys, keys + num_keys);
 
-    // Now iterate on all types, and copy the ones who have valid offsets (meaning that they exist)
-    // to the other area.
-    for (key = 0; key < _max_keys; key++) {
-        curr_offset = _offset_by_key[key];
-        uint16_t save_flags = curr_offset & offs_by_key_area_mask;
-        curr_area = (uint8_t)(curr_offset >> offs_by_key_area_bit_pos) & 1;
-        curr_offset &= ~offs_by_key_flag_mask;
-        if ((!curr_offset) || (curr_area != _active_area)) {
-            continue;
+    // Copying a record only updates the offset in its slot, so the keys stay valid
+    for (i = 0; (i < num_keys) && max_records; i++) {
+        key = keys[i];
+        ret = gc_copy_key(key, new_area_offset, max_records);
+        if (ret != NVSTORE_SUCCESS) {
+            break;
         }
-        ret = copy_record(curr_area, curr_offset, new_area_offset, next_offset);
+        key++;
+    }
+    if ((ret == NVSTORE_SUCCESS) && (i == num_keys)) {
+        key = _max_keys;
+    }
+
+    delete[] keys;
+    return ret;
+}
+
+#else
+
+int NVStore::gc_copy_records(uint16_t &key, uint16_t max_records, uint32_t &new_area_offset)
+{
+    int ret;
+
+    // Iterate on all types, and copy the ones who have valid offsets (meaning that they exist)
+    // in the active area to the other area.
+    for (; (key < _max_keys) && max_records; key++) {
+        ret = gc_copy_key(key, new_area_offset, max_records);
         if (ret != NVSTORE_SUCCESS) {
             return ret;
         }
-        _offset_by_key[key] = new_area_offset | (1 - curr_area) << offs_by_key_area_bit_pos | save_flags;
-        new_area_offset = next_offset;
     }
 
+    return NVSTORE_SUCCESS;
+}
+
+#endif // NVSTORE_HASH_INDEX
+
+int NVStore::gc_switch_area(uint32_t new_area_offset)
+{
+    uint32_t next_offset;
+    int ret;
+
     // Now write master record, with version incremented by 1.
     _active_area_version++;
     ret = write_master_record(1 - _active_area, _active_area_version, next_offset);
@@ -558,6 +951,147 @@ int NVStore::garbage_collection(uint16_t key, uint16_t flags, uint16_t buf_size,
 
     // Only now we can switch to the new active area
     _active_area = 1 - _active_area;
+    return NVSTORE_SUCCESS;
+}
+
+int NVStore::gc_erase_area(bool all)
+{
+    uint8_t area = 1 - _active_area;
+    uint32_t area_size = _flash_area_params[area].size;
+
+    // In erase state, _gc_offset is the offset of the next sector to erase
+    while (_gc_offset < area_size) {
+        uint32_t sector_size = _flash->get_sector_size(_flash_area_params[area].address + _gc_offset);
+        if (flash_erase_sectors(area, _gc_offset, sector_size)) {
+            return NVSTORE_WRITE_ERROR;
+        }
+        _gc_offset += sector_size;
+        if (!all) {
+            break;
+        }
+    }
+
+    if (_gc_offset >= area_size) {
+        _gc_state = NVSTORE_GC_STATE_IDLE;
+    }
+    return NVSTORE_SUCCESS;
+}
+
+int NVStore::gc_abort()
+{
+    uint32_t offset;
+    int ret, valid;
+
+    // Records copied so far are indexed in the nonactive area. The active area still holds
+    // all of them, so index it again, as init does.
+    deinit_key_index();
+    init_key_index();
+
+    offset = align_up(sizeof(nvstore_record_header_t) + sizeof(master_record_data_t), _min_prog_size);
+    ret = index_records(offset, std::min(_free_space_offset, (uint32_t) _size), valid);
+    if (ret != NVSTORE_SUCCESS) {
+        return ret;
+    }
+
+    _gc_state = NVSTORE_GC_STATE_ERASE;
+    _gc_offset = 0;
+    return NVSTORE_SUCCESS;
+}
+
+int NVStore::gc_remove_key(uint16_t key)
+{
+    uint32_t next_offset;
+    int ret;
+
+    // Only keys already scanned may have been copied
+    if ((_gc_state != NVSTORE_GC_STATE_COPY) || (key >= _gc_key)) {
+        return NVSTORE_SUCCESS;
+    }
+
+    if (_gc_offset + align_up(sizeof(nvstore_record_header_t), _min_prog_size) >= _size) {
+        return gc_abort();
+    }
+
+    ret = write_record(1 - _active_area, _gc_offset, key, delete_item_flag, 0, NULL, next_offset);
+    if (ret != NVSTORE_SUCCESS) {
+        return gc_abort();
+    }
+    _gc_offset = next_offset;
+    return NVSTORE_SUCCESS;
+}
+
+int NVStore::garbage_collection(uint16_t key, uint16_t flags, uint16_t buf_size, const void *buf)
+{
+    uint32_t new_area_offset, next_offset;
+    uint16_t gc_key = 0;
+    int ret;
+
+    // Complete the erasure of the nonactive area, if left by an incremental garbage collection
+    if (_gc_state == NVSTORE_GC_STATE_ERASE) {
+        ret = gc_erase_area(true);
+        if (ret != NVSTORE_SUCCESS) {
+            return ret;
+        }
+    }
+
+    // Continue an incremental garbage collection, unless the pending record doesn't fit
+    if ((_gc_state == NVSTORE_GC_STATE_COPY) &&
+        (_gc_offset + align_up(sizeof(nvstore_record_header_t) + buf_size, _min_prog_size) >= _size)) {
+        ret = gc_abort();
+        if (ret != NVSTORE_SUCCESS) {
+            return ret;
+        }
+        return garbage_collection(key, flags, buf_size, buf);
+    }
+
+    if (_gc_state == NVSTORE_GC_STATE_COPY) {
+        new_area_offset = _gc_offset;
+    } else {
+        new_area_offset = align_up(sizeof(nvstore_record_header_t) + sizeof(master_record_data_t), _min_prog_size);
+    }
+
+    // If GC is triggered by a set item request, we need to first write that item in the new location,
+    // otherwise we may either write it twice (if already included), or lose it in case we decide
+    // to skip it at garbage collection phase (and the system crashes).
+    if ((key != no_key) && !(flags & delete_item_flag)) {
+        ret = write_record(1 - _active_area, new_area_offset, key, flags, buf_size, buf, next_offset);
+        if (ret != NVSTORE_SUCCESS) {
+            return ret;
+        }
+        set_key_offset(key, new_area_offset | (1 - _active_area) << offs_by_key_area_bit_pos |
+                       (((flags & set_once_flag) != 0) << offs_by_key_set_once_bit_pos));
+        new_area_offset = next_offset;
+    } else if (flags & delete_item_flag) {
+        // Deleted item must not be copied to the new area (nor stay there, if already copied)
+        if (_gc_state == NVSTORE_GC_STATE_COPY) {
+            ret = write_record(1 - _active_area, new_area_offset, key, delete_item_flag, 0, NULL, next_offset);
+            if (ret != NVSTORE_SUCCESS) {
+                return ret;
+            }
+            new_area_offset = next_offset;
+        }
+        set_key_offset(key, 0);
+    }
+
+    ret = gc_copy_records(gc_key, _max_keys, new_area_offset);
+    if ((ret == NVSTORE_FLASH_AREA_TOO_SMALL) && (_gc_state == NVSTORE_GC_STATE_COPY)) {
+        // Nonactive area filled up with records superseded during the incremental garbage
+        // collection. Start over from an erased area.
+        ret = gc_abort();
+        if (ret != NVSTORE_SUCCESS) {
+            return ret;
+        }
+        return garbage_collection(key, flags, buf_size, buf);
+    }
+    if (ret != NVSTORE_SUCCESS) {
+        return ret;
+    }
+
+    ret = gc_switch_area(new_area_offset);
+    if (ret != NVSTORE_SUCCESS) {
+        return ret;
+    }
+    _gc_state = NVSTORE_GC_STATE_IDLE;
 
     // The older area doesn't concern us now. Erase it now.
     if (flash_erase_area(1 - _active_area)) {
@@ -567,6 +1101,64 @@ int NVStore::garbage_collection(uint16_t key, uint16_t flags, uint16_t buf_size,
     return ret;
 }
 
+int NVStore::garbage_collection_step(uint16_t max_records)
+{
+    int ret = NVSTORE_SUCCESS;
+
+    if (!_init_done) {
+        ret = init();
+        if (ret != NVSTORE_SUCCESS) {
+            return ret;
+        }
+    }
+
+    if (!max_records) {
+        return NVSTORE_BAD_VALUE;
+    }
+
+    _mutex->lock();
+
+    if (_gc_state == NVSTORE_GC_STATE_ERASE) {
+        ret = gc_erase_area(false);
+        _mutex->unlock();
+        return ret;
+    }
+
+    if (_gc_state == NVSTORE_GC_STATE_IDLE) {
+        if ((uint64_t) _free_space_offset * 100 < (uint64_t) _size * NVSTORE_GC_THRESHOLD) {
+            _mutex->unlock();
+            return NVSTORE_SUCCESS;
+        }
+        _gc_state = NVSTORE_GC_STATE_COPY;
+        _gc_key = 0;
+        _gc_offset = align_up(sizeof(nvstore_record_header_t) + sizeof(master_record_data_t), _min_prog_size);
+    }
+
+    ret = gc_copy_records(_gc_key, max_records, _gc_offset);
+    if (ret == NVSTORE_FLASH_AREA_TOO_SMALL) {
+        ret = gc_abort();
+    }
+    if ((ret != NVSTORE_SUCCESS) || (_gc_state != NVSTORE_GC_STATE_COPY) || (_gc_key < _max_keys)) {
+        _mutex->unlock();
+        return ret;
+    }
+
+    // All keys were scanned. Copy the ones set since they were scanned, and switch areas.
+    uint16_t gc_key = 0;
+    ret = gc_copy_records(gc_key, _max_keys, _gc_offset);
+    if (ret == NVSTORE_FLASH_AREA_TOO_SMALL) {
+        ret = gc_abort();
+    } else if (ret == NVSTORE_SUCCESS) {
+        ret = gc_switch_area(_gc_offset);
+        if (ret == NVSTORE_SUCCESS) {
+            _gc_state = NVSTORE_GC_STATE_ERASE;
+            _gc_offset = 0;
+        }
+    }
+
+    _mutex->unlock();
+    return ret;
+}
 
 int NVStore::do_get(uint16_t key, uint16_t buf_size, void *buf, uint16_t &actual_size,
                     int validate_only)
@@ -597,7 +1189,7 @@ int NVStore::do_get(uint16_t key, uint16_t buf_size, void *buf, uint16_t &actual
     }
 
     _mutex->lock();
-    record_offset = _offset_by_key[key];
+    record_offset = get_key_offset(key);
 
     if (!record_offset) {
         _mutex->unlock();
@@ -653,27 +1245,29 @@ int NVStore::do_set(uint16_t &key, uint16_t buf_size, const void *buf, uint16_t
         buf_size = 0;
     }
 
-    if ((flags & delete_item_flag) && !_offset_by_key[key]) {
+    record_size = align_up(sizeof(nvstore_record_header_t) + buf_size, _min_prog_size);
+
+    // The key index may be rehashed by other setters, so only look it up under the mutex
+    _mutex->lock();
+
+    if ((flags & delete_item_flag) && !get_key_offset(key)) {
+        _mutex->unlock();
         return NVSTORE_NOT_FOUND;
     }
 
-    if ((key != no_key) && (_offset_by_key[key] & offs_by_key_set_once_mask)) {
+    if ((key != no_key) && (get_key_offset(key) & offs_by_key_set_once_mask)) {
+        _mutex->unlock();
         return NVSTORE_ALREADY_EXISTS;
     }
 
-    record_size = align_up(sizeof(nvstore_record_header_t) + buf_size, _min_prog_size);
-
-    _mutex->lock();
-
+    bool allocated = false;
     if (key == no_key) {
-        for (key = NVSTORE_NUM_PREDEFINED_KEYS; key < _max_keys; key++) {
-            if (!_offset_by_key[key]) {
-                break;
-            }
-        }
-        if (key == _max_keys) {
-            return NVSTORE_NO_FREE_KEY;
+        ret = alloc_key(key);
+        if (ret != NVSTORE_SUCCESS) {
+            _mutex->unlock();
+            return ret;
         }
+        allocated = true;
     }
 
     new_free_space = core_util_atomic_incr_u32(&_free_space_offset, record_size);
@@ -682,6 +1276,11 @@ int NVStore::do_set(uint16_t &key, uint16_t buf_size, const void *buf, uint16_t
     // If we cross the area limit, we need to invoke GC.
     if (new_free_space >= _size) {
         ret = garbage_collection(key, flags, buf_size, buf);
+        if ((ret != NVSTORE_SUCCESS) && allocated) {
+            release_key(key);
+        } else if ((ret == NVSTORE_SUCCESS) && (flags & delete_item_flag)) {
+            release_key(key);
+        }
         _mutex->unlock();
         return ret;
     }
@@ -689,21 +1288,26 @@ int NVStore::do_set(uint16_t &key, uint16_t buf_size, const void *buf, uint16_t
     // Now write the record
     ret = write_record(_active_area, record_offset, key, flags, buf_size, buf, next_offset);
     if (ret != NVSTORE_SUCCESS) {
+        if (allocated) {
+            release_key(key);
+        }
         _mutex->unlock();
         return ret;
     }
 
-    // Update _offset_by_key. High bit indicates area.
+    // Update key index. High bit indicates area.
     if (flags & delete_item_flag) {
-        _offset_by_key[key] = 0;
+        set_key_offset(key, 0);
+        release_key(key);
+        ret = gc_remove_key(key);
     } else {
-        _offset_by_key[key] = record_offset | (_active_area << offs_by_key_area_bit_pos) |
-                              (((flags & set_once_flag) != 0) << offs_by_key_set_once_bit_pos);
+        set_key_offset(key, record_offset | (_active_area << offs_by_key_area_bit_pos) |
+                       (((flags & set_once_flag) != 0) << offs_by_key_set_once_bit_pos));
     }
 
     _mutex->unlock();
 
-    return NVSTORE_SUCCESS;
+    return ret;
 }
 
 int NVStore::set(uint16_t key, uint16_t buf_size, const void *buf)
@@ -727,6 +1331,249 @@ int NVStore::remove(uint16_t key)
     return do_set(key, 0, NULL, delete_item_flag);
 }
 
+int NVStore::stage_record(uint16_t key, uint16_t flags, uint16_t data_size, const void *data_buf)
+{
+    nvstore_record_header_t header;
+    uint32_t record_size, needed_size;
+
+    if (!data_buf) {
+        data_size = 0;
+    }
+
+    // Leave room for the commit record, as well as for the master record in an area
+    record_size = align_up(sizeof(header) + data_size, _min_prog_size);
+    needed_size = _txn_size + record_size;
+    if (key != transaction_commit_key) {
+        needed_size += align_up(sizeof(header) + sizeof(transaction_commit_data_t), _min_prog_size);
+    }
+    if (needed_size >= _size - align_up(sizeof(header) + sizeof(master_record_data_t), _min_prog_size)) {
+        return NVSTORE_FLASH_AREA_TOO_SMALL;
+    }
+
+    if (_txn_size + record_size > _txn_buf_size) {
+        uint32_t buf_size = std::max(_txn_buf_size * 2, _txn_size + record_size);
+        uint8_t *buf = new uint8_t[buf_size];
+        MBED_ASSERT(buf);
+        memcpy(buf, _txn_buf, _txn_size);
+        delete[] _txn_buf;
+        _txn_buf = buf;
+        _txn_buf_size = buf_size;
+    }
+
+    header.key_and_flags = key | flags | transaction_flag;
+    header.size = data_size;
+    header.crc = 0; // Satisfy compiler
+    header.crc = calc_record_crc(header, data_size, data_buf);
+
+    // Unused bytes are left erased, as write_record does
+    memset(_txn_buf + _txn_size, 0xFF, record_size);
+    memcpy(_txn_buf + _txn_size, &header, sizeof(header));
+    if (data_size) {
+        memcpy(_txn_buf + _txn_size + sizeof(header), data_buf, data_size);
+    }
+    _txn_size += record_size;
+    _txn_records++;
+
+    return NVSTORE_SUCCESS;
+}
+
+int NVStore::begin_transaction()
+{
+    int ret;
+
+    if (!_init_done) {
+        ret = init();
+        if (ret != NVSTORE_SUCCESS) {
+            return ret;
+        }
+    }
+
+    _mutex->lock();
+
+    if (_txn_buf) {
+        _mutex->unlock();
+        return NVSTORE_ALREADY_EXISTS;
+    }
+
+    _txn_buf = new uint8_t[min_transaction_buf_size];
+    MBED_ASSERT(_txn_buf);
+    _txn_buf_size = min_transaction_buf_size;
+    _txn_size = 0;
+    _txn_records = 0;
+
+    _mutex->unlock();
+    return NVSTORE_SUCCESS;
+}
+
+int NVStore::set_in_transaction(uint16_t key, uint16_t buf_size, const void *buf)
+{
+    int ret;
+
+    if (!_init_done) {
+        return NVSTORE_NOT_FOUND;
+    }
+
+    if (key >= _max_keys) {
+        return NVSTORE_BAD_VALUE;
+    }
+
+    _mutex->lock();
+    if (!_txn_buf) {
+        ret = NVSTORE_NOT_FOUND;
+    } else {
+        ret = stage_record(key, 0, buf_size, buf);
+    }
+    _mutex->unlock();
+
+    return ret;
+}
+
+int NVStore::remove_in_transaction(uint16_t key)
+{
+    int ret;
+
+    if (!_init_done) {
+        return NVSTORE_NOT_FOUND;
+    }
+
+    if (key >= _max_keys) {
+        return NVSTORE_BAD_VALUE;
+    }
+
+    _mutex->lock();
+    if (!_txn_buf) {
+        ret = NVSTORE_NOT_FOUND;
+    } else {
+        ret = stage_record(key, delete_item_flag, 0, NULL);
+    }
+    _mutex->unlock();
+
+    return ret;
+}
+
+int NVStore::write_transaction()
+{
+    nvstore_record_header_t *header;
+    transaction_commit_data_t commit;
+    uint32_t offset, record_offset, new_free_space;
+    uint16_t key;
+    int ret;
+
+    // Items set with the write once API can't be set or removed again
+    for (offset = 0; offset < _txn_size;) {
+        header = (nvstore_record_header_t *)(_txn_buf + offset);
+        key = header->key_and_flags & ~header_flag_mask;
+        if (get_key_offset(key) & offs_by_key_set_once_mask) {
+            return NVSTORE_ALREADY_EXISTS;
+        }
+        offset += align_up(sizeof(nvstore_record_header_t) + header->size, _min_prog_size);
+    }
+
+    // Commit record, without the transaction flag, validates all records before it
+    commit.num_records = _txn_records;
+    commit.reserved1 = 0;
+    commit.reserved2 = 0;
+    ret = stage_record(transaction_commit_key, 0, sizeof(commit), &commit);
+    if (ret != NVSTORE_SUCCESS) {
+        return ret;
+    }
+    header = (nvstore_record_header_t *)(_txn_buf + _txn_size -
+                                         align_up(sizeof(nvstore_record_header_t) + sizeof(commit), _min_prog_size));
+    header->key_and_flags &= ~transaction_flag;
+
+    // If we cross the area limit, garbage collect first, so that all records land in one area
+    if (_free_space_offset + _txn_size >= _size) {
+        ret = garbage_collection(no_key, 0, 0, NULL);
+        if (ret != NVSTORE_SUCCESS) {
+            return ret;
+        }
+        if (_free_space_offset + _txn_size >= _size) {
+            return NVSTORE_FLASH_AREA_TOO_SMALL;
+        }
+    }
+
+    new_free_space = core_util_atomic_incr_u32(&_free_space_offset, _txn_size);
+    record_offset = new_free_space - _txn_size;
+
+    // All records are written in a single program operation
+    if (flash_write_area(_active_area, record_offset, _txn_size, _txn_buf)) {
+        return NVSTORE_WRITE_ERROR;
+    }
+
+    // Update key index, record by record (up to the commit record)
+    for (offset = 0; offset < _txn_size;) {
+        header = (nvstore_record_header_t *)(_txn_buf + offset);
+        key = header->key_and_flags & ~header_flag_mask;
+        if (key == transaction_commit_key) {
+            break;
+        }
+        if (!(header->key_and_flags & delete_item_flag)) {
+            set_key_offset(key, (record_offset + offset) | (_active_area << offs_by_key_area_bit_pos));
+        } else if (get_key_offset(key)) {
+            set_key_offset(key, 0);
+            release_key(key);
+            ret = gc_remove_key(key);
+            if (ret != NVSTORE_SUCCESS) {
+                return ret;
+            }
+        }
+        offset += align_up(sizeof(nvstore_record_header_t) + header->size, _min_prog_size);
+    }
+
+    return NVSTORE_SUCCESS;
+}
+
+void NVStore::discard_transaction()
+{
+    delete[] _txn_buf;
+    _txn_buf = 0;
+    _txn_buf_size = 0;
+    _txn_size = 0;
+    _txn_records = 0;
+}
+
+int NVStore::commit_transaction()
+{
+    int ret = NVSTORE_SUCCESS;
+
+    if (!_init_done) {
+        return NVSTORE_NOT_FOUND;
+    }
+
+    _mutex->lock();
+
+    if (!_txn_buf) {
+        _mutex->unlock();
+        return NVSTORE_NOT_FOUND;
+    }
+
+    if (_txn_records) {
+        ret = write_transaction();
+    }
+    discard_transaction();
+
+    _mutex->unlock();
+    return ret;
+}
+
+int NVStore::abort_transaction()
+{
+    if (!_init_done) {
+        return NVSTORE_NOT_FOUND;
+    }
+
+    _mutex->lock();
+
+    if (!_txn_buf) {
+        _mutex->unlock();
+        return NVSTORE_NOT_FOUND;
+    }
+    discard_transaction();
+
+    _mutex->unlock();
+    return NVSTORE_SUCCESS;
+}
+
 int NVStore::init()
 {
     area_state_e area_state[NVSTORE_NUM_AREAS];
@@ -756,12 +1603,8 @@ int NVStore::init()
         return NVSTORE_SUCCESS;
     }
 
-    _offset_by_key = new uint32_t[_max_keys];
-    MBED_ASSERT(_offset_by_key);
-
-    for (key = 0; key < _max_keys; key++) {
-        _offset_by_key[key] = 0;
-    }
+    init_key_index();
+    _gc_state = NVSTORE_GC_STATE_IDLE;
 
     _mutex = new PlatformMutex;
     MBED_ASSERT(_mutex);
@@ -851,25 +1694,13 @@ int NVStore::init()
     }
 
     // Traverse area until reaching the empty space at the end or until reaching a faulty record
-    while (_free_space_offset < free_space_offset_of_area[_active_area]) {
-        ret = read_record(_active_area, _free_space_offset, 0, NULL,
-                          actual_size, 1, valid,
-                          key, flags, next_offset);
-        MBED_ASSERT(ret == NVSTORE_SUCCESS);
+    ret = index_records(_free_space_offset, free_space_offset_of_area[_active_area], valid);
+    MBED_ASSERT(ret == NVSTORE_SUCCESS);
 
-        // In case we have a faulty record, this probably means that the system crashed when written.
-        // Perform a garbage collection, to make the the other area valid.
-        if (!valid) {
-            ret = garbage_collection(no_key, 0, 0, NULL);
-            break;
-        }
-        if (flags & delete_item_flag) {
-            _offset_by_key[key] = 0;
-        } else {
-            _offset_by_key[key] = _free_space_offset | (_active_area << offs_by_key_area_bit_pos) |
-                                  (((flags & set_once_flag) != 0) << offs_by_key_set_once_bit_pos);
-        }
-        _free_space_offset = next_offset;
+    // In case we have a faulty record, this probably means that the system crashed when written.
+    // Perform a garbage collection, to make the the other area valid.
+    if (!valid) {
+        ret = garbage_collection(no_key, 0, 0, NULL);
     }
 
     _init_done = 1;
@@ -882,11 +1713,12 @@ int NVStore::deinit()
         _flash->deinit();
         delete _flash;
         delete _mutex;
-        delete[] _offset_by_key;
+        deinit_key_index();
         if (_page_buf) {
             delete[] _page_buf;
             _page_buf = 0;
         }
+        discard_transaction();
     }
 
     _init_attempts = 0;
@@ -57,6 +57,17 @@ typedef enum {
 #define NVSTORE_MAX_KEYS ((uint16_t)NVSTORE_NUM_PREDEFINED_KEYS)
 #endif
 
+// Keep the key index in a hash table sized by the number of stored keys,
+// instead of an array sized by the maximal number of keys
+#ifndef NVSTORE_HASH_INDEX
+#define NVSTORE_HASH_INDEX 0
+#endif
+
+// Active area usage (percent) above which incremental garbage collection starts
+#ifndef NVSTORE_GC_THRESHOLD
+#define NVSTORE_GC_THRESHOLD 50
+#endif
+
 // defines 2 areas - active and nonactive, not configurable
 #define NVSTORE_NUM_AREAS        2
 
@@ -208,6 +219,83 @@ public:
      */
     int remove(uint16_t key);
 
+    /**
+     * @brief Start a transaction. Items set or removed in the transaction are staged in RAM,
+     *        and written by commit_transaction all together, or not at all (on power loss).
+     *        A single transaction may be in progress at a time.
+     *
+     * @returns NVSTORE_SUCCESS           Transaction started.
+     *          NVSTORE_ALREADY_EXISTS    A transaction is already in progress.
+     */
+    int begin_transaction();
+
+    /**
+     * @brief Stage setting an item in the transaction, given key.
+     *
+     * @param[in]  key                  Key of stored item.
+     * @param[in]  buf_size             Item size in bytes.
+     * @param[in]  buf                  Buffer containing data.
+     *
+     * @returns NVSTORE_SUCCESS           Item staged.
+     *          NVSTORE_NOT_FOUND         No transaction in progress.
+     *          NVSTORE_BAD_VALUE         Bad value in any of the parameters.
+     *          NVSTORE_FLASH_AREA_TOO_SMALL
+     *                                    Transaction doesn't fit in Flash area.
+     */
+    int set_in_transaction(uint16_t key, uint16_t buf_size, const void *buf);
+
+    /**
+     * @brief Stage removing an item in the transaction, given key.
+     *        Removing an item that doesn't exist at commit time has no effect.
+     *
+     * @param[in]  key                  Key of stored item.
+     *
+     * @returns NVSTORE_SUCCESS           Removal staged.
+     *          NVSTORE_NOT_FOUND         No transaction in progress.
+     *          NVSTORE_BAD_VALUE         Bad value in any of the parameters.
+     *          NVSTORE_FLASH_AREA_TOO_SMALL
+     *                                    Transaction doesn't fit in Flash area.
+     */
+    int remove_in_transaction(uint16_t key);
+
+    /**
+     * @brief Write all staged items on Flash, in a single program operation followed by
+     *        a commit record, and end the transaction (also on failure).
+     *
+     * @returns NVSTORE_SUCCESS           Transaction was successfully written on Flash.
+     *          NVSTORE_NOT_FOUND         No transaction in progress.
+     *          NVSTORE_WRITE_ERROR       Physical error writing data.
+     *          NVSTORE_FLASH_AREA_TOO_SMALL
+     *                                    Not enough space in Flash area.
+     *          NVSTORE_ALREADY_EXISTS    An item set with write once API is set or removed.
+     */
+    int commit_transaction();
+
+    /**
+     * @brief End the transaction, discarding all staged items.
+     *
+     * @returns NVSTORE_SUCCESS           Transaction discarded.
+     *          NVSTORE_NOT_FOUND         No transaction in progress.
+     */
+    int abort_transaction();
+
+    /**
+     * @brief Perform a bounded step of incremental garbage collection.
+     *        Once the active area is filled above NVSTORE_GC_THRESHOLD percent, each step copies
+     *        up to max_records records to the nonactive area, and the last one switches areas.
+     *        Following steps erase the old area, a sector per step. This spreads the compaction
+     *        over time, instead of stalling the set operation that exhausts the active area.
+     *        Meant to be called periodically, for instance from an EventQueue or the idle hook.
+     *
+     * @param[in]  max_records          Maximal number of records to copy in this step.
+     *
+     * @returns NVSTORE_SUCCESS           Step completed successfully.
+     *          NVSTORE_READ_ERROR        Physical error reading data.
+     *          NVSTORE_WRITE_ERROR       Physical error writing data.
+     *          NVSTORE_BAD_VALUE         Bad value in any of the parameters.
+     */
+    int garbage_collection_step(uint16_t max_records);
+
     /**
      * @brief Initializes NVStore component.
      *
@@ -274,11 +362,28 @@ private:
     size_t _size;
     PlatformMutex *_mutex;
     uint32_t *_offset_by_key;
+#if NVSTORE_HASH_INDEX
+    // With the hash index, _offset_by_key is indexed by slot and _key_by_slot holds the keys
+    uint16_t *_key_by_slot;
+    uint8_t _index_bits;
+    uint16_t _index_count;
+    uint16_t *_free_keys;
+    uint16_t _num_free_keys;
+    uint16_t _free_keys_size;
+    uint16_t _next_free_key;
+#endif
     nvstore_area_data_t _flash_area_params[NVSTORE_NUM_AREAS];
     static nvstore_area_data_t initial_area_params[NVSTORE_NUM_AREAS];
     mbed::FlashIAP *_flash;
     uint32_t _min_prog_size;
     uint8_t *_page_buf;
+    uint8_t _gc_state;
+    uint16_t _gc_key;
+    uint32_t _gc_offset;
+    uint8_t *_txn_buf;
+    uint32_t _txn_buf_size;
+    uint32_t _txn_size;
+    uint16_t _txn_records;
 
     // Private constructor, as class is a singleton
     NVStore();
@@ -316,6 +421,78 @@ private:
      */
     int flash_erase_area(uint8_t area);
 
+    /**
+     * @brief Erase sectors of an area.
+     *
+     * @param[in]  area                   Area.
+     * @param[in]  offset                 Offset in area (sector aligned).
+     * @param[in]  size                   Number of bytes to erase (sector aligned).
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int flash_erase_sectors(uint8_t area, uint32_t offset, uint32_t size);
+
+    /**
+     * @brief Allocate the key index.
+     */
+    void init_key_index();
+
+    /**
+     * @brief Free the key index.
+     */
+    void deinit_key_index();
+
+    /**
+     * @brief Get offset of a key from the key index.
+     *
+     * @param[in]  key                    Key.
+     *
+     * @returns Offset (with area and set once flags), 0 if key doesn't exist.
+     */
+    uint32_t get_key_offset(uint16_t key);
+
+    /**
+     * @brief Set offset of a key in the key index.
+     *
+     * @param[in]  key                    Key.
+     * @param[in]  offset                 Offset (with area and set once flags), 0 to remove the key.
+     */
+    void set_key_offset(uint16_t key, uint32_t offset);
+
+    /**
+     * @brief Allocate a free key (from the non predefined keys).
+     *
+     * @param[out] key                    Allocated key.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int alloc_key(uint16_t &key);
+
+    /**
+     * @brief Return a key to the free keys after a failed allocation or a removal.
+     *
+     * @param[in]  key                    Key.
+     */
+    void release_key(uint16_t key);
+
+#if NVSTORE_HASH_INDEX
+    /**
+     * @brief Find the hash index slot of a key.
+     *
+     * @param[in]  key                    Key.
+     *
+     * @returns Slot holding the key, or the empty slot where it should be inserted.
+     */
+    uint32_t find_key_slot(uint16_t key);
+
+    /**
+     * @brief Rehash the key index into a new table.
+     *
+     * @param[in]  bits                   Log2 of the new number of slots.
+     */
+    void resize_key_index(uint8_t bits);
+#endif
+
     /**
      * @brief Calculate addresses and sizes of areas (in case no user configuration is given),
      *        or validate user configuration (if given).
@@ -368,6 +545,41 @@ private:
     int write_record(uint8_t area, uint32_t offset, uint16_t key, uint16_t flags,
                      uint32_t data_size, const void *data_buf, uint32_t &next_offset);
 
+    /**
+     * @brief Stage a record in the transaction buffer, in the same format as on Flash.
+     *
+     * @param[in]  key                    Record key.
+     * @param[in]  flags                  Record flags.
+     * @param[in]  data_size              Data size (bytes).
+     * @param[in]  data_buf               Data buffer.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int stage_record(uint16_t key, uint16_t flags, uint16_t data_size, const void *data_buf);
+
+    /**
+     * @brief Write staged transaction on Flash, followed by its commit record, and update key index.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int write_transaction();
+
+    /**
+     * @brief Free transaction buffer, ending the transaction.
+     */
+    void discard_transaction();
+
+    /**
+     * @brief Index records of the active area, applying transactions only once committed.
+     *
+     * @param[in,out] offset              Offset of first record, offset past the last indexed one.
+     * @param[in]  end_offset             Offset to stop at.
+     * @param[out] valid                  Whether the traversal ended without reaching a faulty record.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int index_records(uint32_t &offset, uint32_t end_offset, int &valid);
+
     /**
      * @brief Write a master record of a given area.
      *
@@ -405,6 +617,64 @@ private:
      */
     int garbage_collection(uint16_t key, uint16_t flags, uint16_t buf_size, const void *buf);
 
+    /**
+     * @brief Copy the record of a key, if still in the active area, to the nonactive one.
+     *
+     * @param[in]  key                    Record key.
+     * @param[in,out] new_area_offset     Offset of free space in nonactive area.
+     * @param[in,out] max_records         Decremented if the record was copied.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int gc_copy_key(uint16_t key, uint32_t &new_area_offset, uint16_t &max_records);
+
+    /**
+     * @brief Copy records of keys still in the active area to the nonactive one.
+     *
+     * @param[in,out] key                 First key to check, next key to check on return.
+     * @param[in]  max_records            Maximal number of records to copy.
+     * @param[in,out] new_area_offset     Offset of free space in nonactive area.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int gc_copy_records(uint16_t &key, uint16_t max_records, uint32_t &new_area_offset);
+
+    /**
+     * @brief Write master record of the nonactive area and make it the active one.
+     *
+     * @param[in]  new_area_offset        Offset of free space in nonactive area.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int gc_switch_area(uint32_t new_area_offset);
+
+    /**
+     * @brief Erase the nonactive area after an incremental garbage collection.
+     *
+     * @param[in]  all                    Erase the whole area, rather than a single sector.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int gc_erase_area(bool all);
+
+    /**
+     * @brief Abandon an incremental garbage collection, rebuilding the key index
+     *        from the active area.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int gc_abort();
+
+    /**
+     * @brief Write a deletion record to the nonactive area during an incremental garbage
+     *        collection, in case the removed key was already copied there.
+     *
+     * @param[in]  key                    Removed key.
+     *
+     * @returns 0 for success, nonzero for failure.
+     */
+    int gc_remove_key(uint16_t key);
+
     /**
      * @brief Actual logics of get API (covers also get size API).
      *
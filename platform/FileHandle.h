@@ -74,6 +74,30 @@ public:
      */
     virtual ssize_t write(const void *buffer, size_t size) = 0;
 
+    /** Read the contents of a file into a list of buffers
+     *
+     *  Buffers are filled in order, as if by one read of their total size.
+     *  The default implementation reads each buffer in turn, stopping
+     *  at the first one that isn't filled completely.
+     *
+     *  @param iov      Array of buffers to read in to
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         The number of bytes read, 0 at end of file, negative error on failure
+     */
+    virtual ssize_t readv(const struct iovec *iov, int iovcnt);
+
+    /** Write the contents of a list of buffers to a file
+     *
+     *  Buffers are written in order, as if by one write of their total size.
+     *  The default implementation writes each buffer in turn, stopping
+     *  at the first one that isn't written completely.
+     *
+     *  @param iov      Array of buffers to write from
+     *  @param iovcnt   Number of buffers in the array
+     *  @return         The number of bytes written, negative error on failure
+     */
+    virtual ssize_t writev(const struct iovec *iov, int iovcnt);
+
     /** Move the file position to a given offset from from a given location
      *
      *  @param offset   The offset from whence to move to
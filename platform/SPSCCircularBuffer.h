@@ -0,0 +1,218 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_SPSCCIRCULARBUFFER_H
+#define MBED_SPSCCIRCULARBUFFER_H
+
+#include "platform/platform.h"
+#include "platform/mbed_assert.h"
+
+namespace mbed {
+
+/** \addtogroup platform */
+/** @{*/
+/**
+ * \defgroup platform_SPSCCircularBuffer SPSCCircularBuffer functions
+ * @{
+ */
+
+/** Templated single-producer, single-consumer circular buffer
+ *
+ *  Unlike CircularBuffer no critical sections are taken. One context may
+ *  push while one other context pops, for example an interrupt handler
+ *  filling the buffer and a thread draining it. Each side only writes its
+ *  own index, and publishes it after the elements it covers.
+ *
+ *  @note Synchronization level: Interrupt safe for one producer and one consumer
+ */
+template<typename T, uint32_t BufferSize>
+class SPSCCircularBuffer {
+public:
+    SPSCCircularBuffer() : _head(0), _tail(0) {
+        MBED_STATIC_ASSERT(BufferSize > 0, "BufferSize must be larger than 0");
+    }
+
+    ~SPSCCircularBuffer() {
+    }
+
+    /** Push an element to the buffer, only called by the producer
+     *
+     * Unlike CircularBuffer::push, a full buffer is not overwritten as
+     * that would move the consumer's index.
+     *
+     * @param data Data to be pushed to the buffer
+     * @return True if the data was pushed, false if the buffer is full
+     */
+    bool push(const T& data) {
+        uint32_t head = _head;
+        uint32_t next = increment(head, 1);
+        if (next == _tail) {
+            return false;
+        }
+        _pool[head] = data;
+        barrier();
+        _head = next;
+        return true;
+    }
+
+    /** Push a number of elements to the buffer, only called by the producer
+     *
+     * @param data  Data to be pushed to the buffer
+     * @param count Number of elements to push
+     * @return The number of elements pushed, less than count if the buffer filled up
+     */
+    uint32_t push(const T *data, uint32_t count) {
+        uint32_t head = _head;
+        uint32_t space = BufferSize - used(head, _tail);
+        if (count > space) {
+            count = space;
+        }
+
+        // copy up to the end of the storage, then wrap around
+        uint32_t first = Storage - head;
+        if (first > count) {
+            first = count;
+        }
+        copy(&_pool[head], data, first);
+        copy(&_pool[0], data + first, count - first);
+
+        barrier();
+        _head = increment(head, count);
+        return count;
+    }
+
+    /** Pop an element from the buffer, only called by the consumer
+     *
+     * @param data Data to be popped from the buffer
+     * @return True if the buffer is not empty and data contains an element, false otherwise
+     */
+    bool pop(T& data) {
+        uint32_t tail = _tail;
+        if (tail == _head) {
+            return false;
+        }
+        barrier();
+        data = _pool[tail];
+        barrier();
+        _tail = increment(tail, 1);
+        return true;
+    }
+
+    /** Pop a number of elements from the buffer, only called by the consumer
+     *
+     * @param data  Destination for the popped data
+     * @param count Maximum number of elements to pop
+     * @return The number of elements popped, less than count if the buffer ran empty
+     */
+    uint32_t pop(T *data, uint32_t count) {
+        uint32_t tail = _tail;
+        uint32_t available = used(_head, tail);
+        if (count > available) {
+            count = available;
+        }
+        barrier();
+
+        // copy up to the end of the storage, then wrap around
+        uint32_t first = Storage - tail;
+        if (first > count) {
+            first = count;
+        }
+        copy(data, &_pool[tail], first);
+        copy(data + first, &_pool[0], count - first);
+
+        barrier();
+        _tail = increment(tail, count);
+        return count;
+    }
+
+    /** Peek into the buffer without popping, only called by the consumer
+     *
+     * @param data Data to be peeked from the buffer
+     * @return True if the buffer is not empty and data contains an element, false otherwise
+     */
+    bool peek(T& data) const {
+        uint32_t tail = _tail;
+        if (tail == _head) {
+            return false;
+        }
+        barrier();
+        data = _pool[tail];
+        return true;
+    }
+
+    /** Check if the buffer is empty
+     *
+     * @return True if the buffer is empty, false if not
+     */
+    bool empty() const {
+        return _head == _tail;
+    }
+
+    /** Check if the buffer is full
+     *
+     * @return True if the buffer is full, false if not
+     */
+    bool full() const {
+        return increment(_head, 1) == _tail;
+    }
+
+    /** Reset the buffer, neither the producer nor the consumer may be active
+     */
+    void reset() {
+        _head = 0;
+        _tail = 0;
+    }
+
+    /** Get the number of elements currently stored in the buffer */
+    uint32_t size() const {
+        return used(_head, _tail);
+    }
+
+private:
+    // one slot is kept free to tell a full buffer from an empty one
+    static const uint32_t Storage = BufferSize + 1;
+
+    static uint32_t increment(uint32_t index, uint32_t count) {
+        index += count;
+        return index >= Storage ? index - Storage : index;
+    }
+
+    static uint32_t used(uint32_t head, uint32_t tail) {
+        return head >= tail ? head - tail : Storage + head - tail;
+    }
+
+    static void copy(T *dst, const T *src, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            dst[i] = src[i];
+        }
+    }
+
+    // keeps element accesses on the right side of index updates
+    static void barrier() {
+        __DMB();
+    }
+
+    T _pool[Storage];
+    volatile uint32_t _head;
+    volatile uint32_t _tail;
+};
+
+/**@}*/
+
+/**@}*/
+
+}
+
+#endif
@@ -19,6 +19,7 @@
 #include "platform/mbed_toolchain.h"
 #include "platform/SingletonPtr.h"
 #include "platform/PlatformMutex.h"
+#include "platform/mbed_assert.h"
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -65,6 +66,193 @@ void mbed_stats_heap_get(mbed_stats_heap_t *stats)
 #endif
 }
 
+/******************************************************************************/
+/* Size-class pools in front of the system heap                               */
+/******************************************************************************/
+
+#ifndef MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
+#define MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED  0
+#endif
+
+#if MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
+
+/* Small blocks come from a free list per size class, one arena taken from the
+   heap on first use holds all of them. Requests that fit no class, or whose
+   classes are exhausted, go to the heap as before. */
+
+static const uint32_t pool_block_sizes[] = { MBED_CONF_PLATFORM_MALLOC_POOL_BLOCK_SIZES };
+static const uint32_t pool_block_counts[] = { MBED_CONF_PLATFORM_MALLOC_POOL_BLOCK_COUNTS };
+
+#define POOL_CLASS_COUNT (sizeof(pool_block_sizes) / sizeof(pool_block_sizes[0]))
+
+MBED_STATIC_ASSERT(sizeof(pool_block_sizes) == sizeof(pool_block_counts),
+                   "malloc-pool-block-sizes and malloc-pool-block-counts must have the same length");
+
+typedef struct pool_block {
+    struct pool_block *next;
+} pool_block_t;
+
+typedef struct {
+    uint8_t *start;
+    uint8_t *end;
+    pool_block_t *free_list;
+    mbed_stats_heap_pool_t stats;
+} pool_class_t;
+
+static SingletonPtr<PlatformMutex> pool_mutex;
+static pool_class_t pool_classes[POOL_CLASS_COUNT];
+static uint8_t *pool_start;
+static uint8_t *pool_end;
+static bool pool_failed;
+
+/* Size must be a multiple of 8 to keep alignment */
+static uint32_t pool_block_size(uint32_t index)
+{
+    return (pool_block_sizes[index] + 7) & ~7;
+}
+
+/* Called with pool_mutex locked */
+static void pool_setup(void *(*arena_alloc)(size_t size))
+{
+    uint32_t arena_size = 0;
+    for (uint32_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        MBED_ASSERT(i == 0 || pool_block_sizes[i - 1] < pool_block_sizes[i]);
+        arena_size += pool_block_size(i) * pool_block_counts[i];
+    }
+
+    uint8_t *block = (uint8_t *)arena_alloc(arena_size);
+    if (block == NULL) {
+        pool_failed = true;
+        return;
+    }
+
+    pool_start = block;
+    for (uint32_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        pool_class_t *pool = &pool_classes[i];
+        uint32_t size = pool_block_size(i);
+
+        pool->start = block;
+        pool->free_list = NULL;
+        for (uint32_t j = 0; j < pool_block_counts[i]; j++) {
+            pool_block_t *free_block = (pool_block_t *)(block + (pool_block_counts[i] - j - 1) * size);
+            free_block->next = pool->free_list;
+            pool->free_list = free_block;
+        }
+        block += size * pool_block_counts[i];
+        pool->end = block;
+
+        memset(&pool->stats, 0, sizeof(pool->stats));
+        pool->stats.block_size = size;
+        pool->stats.block_cnt = pool_block_counts[i];
+    }
+    pool_end = block;
+}
+
+/* Return the class ptr was allocated from or NULL if it came from the heap */
+static pool_class_t *pool_find(void *ptr)
+{
+    uint8_t *block = (uint8_t *)ptr;
+    if (block < pool_start || block >= pool_end) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < POOL_CLASS_COUNT; i++) {
+        if (block < pool_classes[i].end) {
+            return &pool_classes[i];
+        }
+    }
+    return NULL;
+}
+
+static void *pool_alloc(size_t size, void *(*arena_alloc)(size_t size))
+{
+    if (size > pool_block_sizes[POOL_CLASS_COUNT - 1] || size == 0) {
+        return NULL;
+    }
+
+    void *ptr = NULL;
+    pool_mutex->lock();
+    if (pool_start == NULL && !pool_failed) {
+        pool_setup(arena_alloc);
+    }
+    if (pool_start != NULL) {
+        // Take the smallest class that fits and still has a free block
+        bool overflow = false;
+        for (uint32_t i = 0; i < POOL_CLASS_COUNT; i++) {
+            pool_class_t *pool = &pool_classes[i];
+            if (size > pool->stats.block_size) {
+                continue;
+            }
+            if (pool->free_list == NULL) {
+                if (!overflow) {
+                    pool->stats.overflow_cnt += 1;
+                    overflow = true;
+                }
+                continue;
+            }
+            ptr = pool->free_list;
+            pool->free_list = pool->free_list->next;
+            pool->stats.current_cnt += 1;
+            pool->stats.total_cnt += 1;
+            if (pool->stats.current_cnt > pool->stats.max_cnt) {
+                pool->stats.max_cnt = pool->stats.current_cnt;
+            }
+            break;
+        }
+    }
+    pool_mutex->unlock();
+    return ptr;
+}
+
+/* Return false if ptr came from the heap and has to be freed there */
+static bool pool_free(void *ptr)
+{
+    pool_class_t *pool = pool_find(ptr);
+    if (pool == NULL) {
+        return false;
+    }
+
+    pool_mutex->lock();
+    pool_block_t *block = (pool_block_t *)ptr;
+    block->next = pool->free_list;
+    pool->free_list = block;
+    pool->stats.current_cnt -= 1;
+    pool_mutex->unlock();
+    return true;
+}
+
+#ifndef MBED_HEAP_STATS_ENABLED
+/* Return the usable size of a pool block or 0 if ptr came from the heap */
+static size_t pool_usable_size(void *ptr)
+{
+    pool_class_t *pool = pool_find(ptr);
+    return pool != NULL ? pool->stats.block_size : 0;
+}
+#endif
+
+#endif // #if MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
+
+size_t mbed_stats_heap_pool_get(mbed_stats_heap_pool_t *stats, size_t count)
+{
+#if MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
+    size_t i;
+    pool_mutex->lock();
+    for (i = 0; i < count && i < POOL_CLASS_COUNT; i++) {
+        memcpy(&stats[i], &pool_classes[i].stats, sizeof(mbed_stats_heap_pool_t));
+        if (pool_start == NULL) {
+            // Not set up until the first small allocation
+            stats[i].block_size = pool_block_size(i);
+            stats[i].block_cnt = pool_block_counts[i];
+        }
+    }
+    pool_mutex->unlock();
+    return i;
+#else
+    (void)stats;
+    (void)count;
+    return 0;
+#endif
+}
+
 /******************************************************************************/
 /* GCC memory allocation wrappers                                             */
 /******************************************************************************/
@@ -88,6 +276,62 @@ extern "C" {
 // TODO: memory tracing doesn't work with uVisor enabled.
 #if !defined(FEATURE_UVISOR)
 
+#if MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
+static void *pool_arena_alloc(size_t size) {
+    return __real__malloc_r(_REENT, size);
+}
+
+static void *pool_malloc(struct _reent * r, size_t size) {
+    void *ptr = pool_alloc(size, pool_arena_alloc);
+    return ptr != NULL ? ptr : __real__malloc_r(r, size);
+}
+
+static void pool_free_r(struct _reent * r, void * ptr) {
+    if (!pool_free(ptr)) {
+        __real__free_r(r, ptr);
+    }
+}
+
+// Only used without heap stats, which realloc and calloc through malloc
+#ifndef MBED_HEAP_STATS_ENABLED
+static void *pool_realloc(struct _reent * r, void * ptr, size_t size) {
+    size_t old_size = pool_usable_size(ptr);
+    if (old_size == 0) {
+        return __real__realloc_r(r, ptr, size);
+    }
+
+    void *new_ptr = NULL;
+    if (size != 0) {
+        new_ptr = pool_malloc(r, size);
+        if (new_ptr == NULL) {
+            return NULL;
+        }
+        memcpy(new_ptr, ptr, (old_size < size) ? old_size : size);
+    }
+    pool_free(ptr);
+    return new_ptr;
+}
+
+static void *pool_calloc(struct _reent * r, size_t nmemb, size_t size) {
+    // Leave overflowing requests to the heap to reject
+    if (size != 0 && nmemb > (size_t)-1 / size) {
+        return __real__calloc_r(r, nmemb, size);
+    }
+    void *ptr = pool_alloc(nmemb * size, pool_arena_alloc);
+    if (ptr == NULL) {
+        return __real__calloc_r(r, nmemb, size);
+    }
+    memset(ptr, 0, nmemb * size);
+    return ptr;
+}
+#endif // #ifndef MBED_HEAP_STATS_ENABLED
+#else
+#define pool_malloc     __real__malloc_r
+#define pool_free_r     __real__free_r
+#define pool_realloc    __real__realloc_r
+#define pool_calloc     __real__calloc_r
+#endif // #if MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
+
 extern "C" void * __wrap__malloc_r(struct _reent * r, size_t size) {
     return malloc_wrapper(r, size, MBED_CALLER_ADDR());
 }
@@ -99,7 +343,7 @@ extern "C" void * malloc_wrapper(struct _reent * r, size_t size, void * caller)
 #endif
 #ifdef MBED_HEAP_STATS_ENABLED
     malloc_stats_mutex->lock();
-    alloc_info_t *alloc_info = (alloc_info_t*)__real__malloc_r(r, size + sizeof(alloc_info_t));
+    alloc_info_t *alloc_info = (alloc_info_t*)pool_malloc(r, size + sizeof(alloc_info_t));
     if (alloc_info != NULL) {
         alloc_info->size = size;
         ptr = (void*)(alloc_info + 1);
@@ -114,7 +358,7 @@ extern "C" void * malloc_wrapper(struct _reent * r, size_t size, void * caller)
     }
     malloc_stats_mutex->unlock();
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    ptr = __real__malloc_r(r, size);
+    ptr = pool_malloc(r, size);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mbed_mem_trace_malloc(ptr, size, caller);
@@ -156,7 +400,7 @@ extern "C" void * __wrap__realloc_r(struct _reent * r, void * ptr, size_t size)
         free(ptr);
     }
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    new_ptr = __real__realloc_r(r, ptr, size);
+    new_ptr = pool_realloc(r, ptr, size);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mbed_mem_trace_realloc(new_ptr, ptr, size, MBED_CALLER_ADDR());
@@ -181,10 +425,10 @@ extern "C" void free_wrapper(struct _reent * r, void * ptr, void * caller) {
         heap_stats.current_size -= alloc_info->size;
         heap_stats.alloc_cnt -= 1;
     }
-    __real__free_r(r, (void*)alloc_info);
+    pool_free_r(r, (void*)alloc_info);
     malloc_stats_mutex->unlock();
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    __real__free_r(r, ptr);
+    pool_free_r(r, ptr);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mbed_mem_trace_free(ptr, caller);
@@ -205,7 +449,7 @@ extern "C" void * __wrap__calloc_r(struct _reent * r, size_t nmemb, size_t size)
         memset(ptr, 0, nmemb * size);
     }
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    ptr = __real__calloc_r(r, nmemb, size);
+    ptr = pool_calloc(r, nmemb, size);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mbed_mem_trace_calloc(ptr, nmemb, size, MBED_CALLER_ADDR());
@@ -247,8 +491,8 @@ extern "C" void * __wrap__memalign_r(struct _reent * r, size_t alignment, size_t
 #define SUB_FREE        $Sub$$__iar_dlfree
 #endif
 
-/* Enable hooking of memory function only if tracing is also enabled */
-#if defined(MBED_MEM_TRACING_ENABLED) || defined(MBED_HEAP_STATS_ENABLED)
+/* Enable hooking of memory function only if tracing or the pools are also enabled */
+#if defined(MBED_MEM_TRACING_ENABLED) || defined(MBED_HEAP_STATS_ENABLED) || MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
 
 extern "C" {
     void *SUPER_MALLOC(size_t size);
@@ -259,6 +503,62 @@ extern "C" {
     void free_wrapper(void *ptr, void* caller);
 }
 
+#if MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
+static void *pool_arena_alloc(size_t size) {
+    return SUPER_MALLOC(size);
+}
+
+static void *pool_malloc(size_t size) {
+    void *ptr = pool_alloc(size, pool_arena_alloc);
+    return ptr != NULL ? ptr : SUPER_MALLOC(size);
+}
+
+static void pool_free_super(void *ptr) {
+    if (!pool_free(ptr)) {
+        SUPER_FREE(ptr);
+    }
+}
+
+// Only used without heap stats, which realloc and calloc through malloc
+#ifndef MBED_HEAP_STATS_ENABLED
+static void *pool_realloc(void *ptr, size_t size) {
+    size_t old_size = pool_usable_size(ptr);
+    if (old_size == 0) {
+        return SUPER_REALLOC(ptr, size);
+    }
+
+    void *new_ptr = NULL;
+    if (size != 0) {
+        new_ptr = pool_malloc(size);
+        if (new_ptr == NULL) {
+            return NULL;
+        }
+        memcpy(new_ptr, ptr, (old_size < size) ? old_size : size);
+    }
+    pool_free(ptr);
+    return new_ptr;
+}
+
+static void *pool_calloc(size_t nmemb, size_t size) {
+    // Leave overflowing requests to the heap to reject
+    if (size != 0 && nmemb > (size_t)-1 / size) {
+        return SUPER_CALLOC(nmemb, size);
+    }
+    void *ptr = pool_alloc(nmemb * size, pool_arena_alloc);
+    if (ptr == NULL) {
+        return SUPER_CALLOC(nmemb, size);
+    }
+    memset(ptr, 0, nmemb * size);
+    return ptr;
+}
+#endif // #ifndef MBED_HEAP_STATS_ENABLED
+#else
+#define pool_malloc     SUPER_MALLOC
+#define pool_free_super SUPER_FREE
+#define pool_realloc    SUPER_REALLOC
+#define pool_calloc     SUPER_CALLOC
+#endif // #if MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
+
 
 extern "C" void* SUB_MALLOC(size_t size) {
     return malloc_wrapper(size, MBED_CALLER_ADDR());
@@ -271,7 +571,7 @@ extern "C" void* malloc_wrapper(size_t size, void* caller) {
 #endif
 #ifdef MBED_HEAP_STATS_ENABLED
     malloc_stats_mutex->lock();
-    alloc_info_t *alloc_info = (alloc_info_t*)SUPER_MALLOC(size + sizeof(alloc_info_t));
+    alloc_info_t *alloc_info = (alloc_info_t*)pool_malloc(size + sizeof(alloc_info_t));
     if (alloc_info != NULL) {
         alloc_info->size = size;
         ptr = (void*)(alloc_info + 1);
@@ -286,7 +586,7 @@ extern "C" void* malloc_wrapper(size_t size, void* caller) {
     }
     malloc_stats_mutex->unlock();
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    ptr = SUPER_MALLOC(size);
+    ptr = pool_malloc(size);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mbed_mem_trace_malloc(ptr, size, caller);
@@ -324,7 +624,7 @@ extern "C" void* SUB_REALLOC(void *ptr, size_t size) {
         free(ptr);
     }
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    new_ptr = SUPER_REALLOC(ptr, size);
+    new_ptr = pool_realloc(ptr, size);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mbed_mem_trace_realloc(new_ptr, ptr, size, MBED_CALLER_ADDR());
@@ -345,7 +645,7 @@ extern "C" void *SUB_CALLOC(size_t nmemb, size_t size) {
         memset(ptr, 0, nmemb * size);
     }
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    ptr = SUPER_CALLOC(nmemb, size);
+    ptr = pool_calloc(nmemb, size);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mbed_mem_trace_calloc(ptr, nmemb, size, MBED_CALLER_ADDR());
@@ -370,10 +670,10 @@ extern "C" void free_wrapper(void *ptr, void* caller) {
         heap_stats.current_size -= alloc_info->size;
         heap_stats.alloc_cnt -= 1;
     }
-    SUPER_FREE((void*)alloc_info);
+    pool_free_super((void*)alloc_info);
     malloc_stats_mutex->unlock();
 #else // #ifdef MBED_HEAP_STATS_ENABLED
-    SUPER_FREE(ptr);
+    pool_free_super(ptr);
 #endif // #ifdef MBED_HEAP_STATS_ENABLED
 #ifdef MBED_MEM_TRACING_ENABLED
     mbed_mem_trace_free(ptr, caller);
@@ -397,4 +697,8 @@ extern "C" void free_wrapper(void *ptr, void* caller) {
 #error Heap statistics are not supported with the current toolchain.
 #endif
 
+#if MBED_CONF_PLATFORM_MALLOC_POOL_ENABLED
+#error Malloc pools are not supported with the current toolchain.
+#endif
+
 #endif // #if defined(TOOLCHAIN_GCC)
@@ -627,6 +627,44 @@ extern "C" ssize_t write(int fh, const void *buf, size_t length) {
     }
 }
 
+static bool iov_valid(const struct iovec *iov, int iovcnt) {
+    if (iovcnt < 0 || iovcnt > IOV_MAX) {
+        return false;
+    }
+
+    // total size must be representable in the result
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len > SSIZE_MAX - total) {
+            return false;
+        }
+        total += iov[i].iov_len;
+    }
+    return true;
+}
+
+extern "C" ssize_t writev(int fh, const struct iovec *iov, int iovcnt) {
+
+    FileHandle* fhc = get_fhc(fh);
+    if (fhc == NULL) {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (!iov_valid(iov, iovcnt)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ssize_t ret = fhc->writev(iov, iovcnt);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    } else {
+        return ret;
+    }
+}
+
 #if defined (__ARMCC_VERSION) && (__ARMCC_VERSION >= 6010050)
 extern "C" void PREFIX(_exit)(int return_code) {
     while(1) {}
@@ -717,6 +755,28 @@ extern "C" ssize_t read(int fh, void *buf, size_t length) {
     }
 }
 
+extern "C" ssize_t readv(int fh, const struct iovec *iov, int iovcnt) {
+
+    FileHandle* fhc = get_fhc(fh);
+    if (fhc == NULL) {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (!iov_valid(iov, iovcnt)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ssize_t ret = fhc->readv(iov, iovcnt);
+    if (ret < 0) {
+        errno = -ret;
+        return -1;
+    } else {
+        return ret;
+    }
+}
+
 
 #ifdef __ARMCC_VERSION
 extern "C" int PREFIX(_istty)(FILEHANDLE fh)
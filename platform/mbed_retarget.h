@@ -486,6 +486,17 @@ struct pollfd {
     short revents;
 };
 
+/* Refer to sys/uio standard
+ */
+struct iovec {
+    void   *iov_base;   ///< Base address of a memory region
+    size_t  iov_len;    ///< Size of the memory region in bytes
+};
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024    ///< Maximum number of iovec structures in one call
+#endif
+
 /* POSIX-compatible I/O functions */
 #if __cplusplus
 extern "C" {
@@ -500,6 +511,8 @@ extern "C" {
 #endif
     ssize_t write(int fildes, const void *buf, size_t nbyte);
     ssize_t read(int fildes, void *buf, size_t nbyte);
+    ssize_t writev(int fildes, const struct iovec *iov, int iovcnt);
+    ssize_t readv(int fildes, const struct iovec *iov, int iovcnt);
     off_t lseek(int fildes, off_t offset, int whence);
     int isatty(int fildes);
     int fsync(int fildes);
@@ -48,6 +48,29 @@ typedef struct {
  */
 void mbed_stats_heap_get(mbed_stats_heap_t *stats);
 
+/**
+ * struct mbed_stats_heap_pool_t definition
+ */
+typedef struct {
+    uint32_t block_size;        /**< Size of the blocks in the class. */
+    uint32_t block_cnt;         /**< Number of blocks in the class. */
+    uint32_t current_cnt;       /**< Current number of blocks allocated. */
+    uint32_t max_cnt;           /**< Max number of blocks allocated at a given time. */
+    uint32_t total_cnt;         /**< Cumulative number of blocks ever allocated. */
+    uint32_t overflow_cnt;      /**< Number of requests passed on because the class was exhausted. */
+} mbed_stats_heap_pool_t;
+
+/**
+ *  Fill the passed array of stat structures with the stats of each malloc size-class pool.
+ *  Pooled allocations are also counted by mbed_stats_heap_get.
+ *
+ *  @param stats    A pointer to an array of mbed_stats_heap_pool_t structures to fill
+ *  @param count    The number of mbed_stats_heap_pool_t structures in the provided array
+ *  @return         The number of mbed_stats_heap_pool_t structures that have been filled,
+ *                  0 if the pools are disabled.
+ */
+size_t mbed_stats_heap_pool_get(mbed_stats_heap_pool_t *stats, size_t count);
+
 /**
  * struct mbed_stats_stack_t definition
  */